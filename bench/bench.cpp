@@ -0,0 +1,326 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "resolver.hpp"
+#include "time.hpp"
+
+// per-stage timings for the query pipeline over a fixed corpus, so releases can be compared.
+// usage: timelib_bench [--iterations n] [--json] [--out file]
+// (--startup-probe is how the benchmark runs itself for the startup stage)
+
+#ifndef TIMELIB_VERSION
+#define TIMELIB_VERSION "unknown"
+#endif
+
+namespace {
+
+std::atomic<std::size_t> allocations{0};
+
+}
+
+// counts every heap allocation in the process, the stages are run one at a time so the delta
+// around a stage is what it allocated
+void* operator new(const std::size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// fresh processes started for the startup stage
+constexpr std::size_t kStartupRuns = 10;
+
+// what a launcher sees: every query form, aliases and iana names in several spellings, times on
+// both sides of the usual dst switch hours, typos that go through the fuzzy fallback and plain
+// misses
+constexpr std::string_view kCorpus[] = {
+    // current time
+    "time in tokyo",
+    "time in new york",
+    "what time is it in london",
+    "current time in paris",
+    "time in nyc",
+    "time in Europe/Berlin",
+    "time in America/Argentina/Buenos_Aires",
+    "time in asia/kolkata",
+    "time in utc",
+    "time in pst",
+    "time in Australia/Lord_Howe",
+    "time in kathmandu",
+    "time in londn",
+    "time in buenos airs",
+    "time in atlantis",
+    "time in zzzz",
+    // conversions
+    "5pm in nyc to london",
+    "5pm nyc to tokyo",
+    "9:30am in delhi to la",
+    "12am in sydney to berlin",
+    "12pm in paris to ist",
+    "3:30am ist to pst",
+    "17:45 in Europe/London to America/Chicago",
+    "2:30am in new york to london",
+    "1:30am in london to new york",
+    "2:15am in Australia/Lord_Howe to utc",
+    "3am in chatham to honolulu",
+    "11pm in America/Sao_Paulo to Asia/Tokyo",
+    "0:00 in utc to Pacific/Kiritimati",
+    "8pm in berln to tokio",
+    "7am in atlantis to london",
+    "6pm in london to",
+    "25:00 in london to paris",
+    // differences
+    "time difference between delhi and la",
+    "time difference between tokyo and new york",
+    "time difference between london and paris",
+    "time difference between Asia/Kathmandu and utc",
+    "time difference between nyc and Australia/Lord_Howe",
+    "time difference between est and cet",
+    "time difference between atlantis and london",
+    // not queries at all
+    "",
+    "hello",
+    "weather in london",
+    "5pm",
+    "difference between london and paris",
+};
+
+struct Stage {
+    std::string name;
+    std::size_t ops = 0;
+    double ns_per_op = 0;
+    double allocs_per_op = 0;
+    double p50 = 0;
+    double p99 = 0;
+};
+
+double nanoseconds(const Clock::duration d) {
+    return std::chrono::duration<double, std::nano>(d).count();
+}
+
+double percentile(std::vector<double>& samples, const double p) {
+    if (samples.empty()) return 0;
+    const auto index = static_cast<std::size_t>(p * static_cast<double>(samples.size() - 1));
+    std::nth_element(samples.begin(), samples.begin() + static_cast<std::ptrdiff_t>(index), samples.end());
+    return samples[index];
+}
+
+// runs `op` over `count` items. throughput and allocations come from an untimed-per-op loop,
+// the percentiles from a second loop timing every call, so the clock reads don't skew ns/op
+Stage measure(const std::string& name, const std::size_t count, const std::size_t iterations,
+              const std::function<void(std::size_t)>& op) {
+    Stage stage;
+    stage.name = name;
+    if (count == 0) return stage;
+
+    // warm up caches and anything built lazily
+    for (std::size_t i = 0; i < count; ++i) op(i);
+
+    const std::size_t allocs_before = allocations.load(std::memory_order_relaxed);
+    const auto start = Clock::now();
+    for (std::size_t n = 0; n < iterations; ++n) {
+        for (std::size_t i = 0; i < count; ++i) op(i);
+    }
+    const auto elapsed = Clock::now() - start;
+    const std::size_t allocs = allocations.load(std::memory_order_relaxed) - allocs_before;
+
+    stage.ops = count * iterations;
+    stage.ns_per_op = nanoseconds(elapsed) / static_cast<double>(stage.ops);
+    stage.allocs_per_op = static_cast<double>(allocs) / static_cast<double>(stage.ops);
+
+    std::vector<double> samples;
+    samples.reserve(stage.ops);
+    for (std::size_t n = 0; n < iterations; ++n) {
+        for (std::size_t i = 0; i < count; ++i) {
+            const auto before = Clock::now();
+            op(i);
+            samples.push_back(nanoseconds(Clock::now() - before));
+        }
+    }
+    stage.p50 = percentile(samples, 0.50);
+    stage.p99 = percentile(samples, 0.99);
+    return stage;
+}
+
+// the first answer in a process that has loaded nothing yet: the tzdb, the resolver and the
+// zone's offset table are all built on the way. prints nanoseconds and allocations
+int probeStartup() {
+    const std::size_t allocs_before = allocations.load(std::memory_order_relaxed);
+    const auto start = Clock::now();
+    const auto result = timelib::TimeConverter::processQuery(timelib::TimeConverter().parseInput("time in london"));
+    const auto elapsed = Clock::now() - start;
+    std::cout << nanoseconds(elapsed) << ' ' << allocations.load(std::memory_order_relaxed) - allocs_before << std::endl;
+    return result.code == timelib::ErrorCode::Success ? 0 : 1;
+}
+
+// startup can only be measured once per process, so the probe runs in fresh copies of this
+// binary, one sample each
+Stage measureStartup(const std::string& self) {
+    Stage stage;
+    stage.name = "startup";
+
+    std::vector<double> samples;
+    double allocs = 0;
+    const std::string command = "'" + self + "' --startup-probe";
+    for (std::size_t run = 0; run < kStartupRuns; ++run) {
+        FILE* probe = popen(command.c_str(), "r");
+        if (!probe) break;
+        double ns = 0, allocated = 0;
+        const bool read = std::fscanf(probe, "%lf %lf", &ns, &allocated) == 2;
+        if (pclose(probe) != 0 || !read) {
+            std::cerr << "startup probe failed" << std::endl;
+            break;
+        }
+        samples.push_back(ns);
+        allocs += allocated;
+    }
+    if (samples.empty()) return stage;
+
+    stage.ops = samples.size();
+    for (const double ns : samples) stage.ns_per_op += ns;
+    stage.ns_per_op /= static_cast<double>(stage.ops);
+    stage.allocs_per_op = allocs / static_cast<double>(stage.ops);
+    stage.p50 = percentile(samples, 0.50);
+    stage.p99 = percentile(samples, 0.99);
+    return stage;
+}
+
+void writeText(std::ostream& out, const std::vector<Stage>& stages) {
+    out << std::left << std::setw(20) << "stage" << std::right << std::setw(10) << "ops" << std::setw(12) << "ns/op"
+        << std::setw(12) << "allocs/op" << std::setw(10) << "p50" << std::setw(10) << "p99" << '\n';
+    out << std::fixed;
+    for (const auto& stage : stages) {
+        out << std::left << std::setw(20) << stage.name << std::right << std::setw(10) << stage.ops
+            << std::setw(12) << std::setprecision(1) << stage.ns_per_op
+            << std::setw(12) << std::setprecision(2) << stage.allocs_per_op
+            << std::setw(10) << std::setprecision(0) << stage.p50
+            << std::setw(10) << stage.p99 << '\n';
+    }
+}
+
+void writeJson(std::ostream& out, const std::vector<Stage>& stages, const std::size_t corpus, const std::size_t iterations) {
+    out << std::fixed << std::setprecision(2);
+    out << "{\n  \"version\": \"" << TIMELIB_VERSION << "\",\n  \"corpus\": " << corpus
+        << ",\n  \"iterations\": " << iterations << ",\n  \"stages\": [\n";
+    for (std::size_t i = 0; i < stages.size(); ++i) {
+        const auto& stage = stages[i];
+        out << "    {\"name\": \"" << stage.name << "\", \"ops\": " << stage.ops << ", \"ns_per_op\": " << stage.ns_per_op
+            << ", \"allocs_per_op\": " << stage.allocs_per_op << ", \"p50_ns\": " << stage.p50 << ", \"p99_ns\": " << stage.p99
+            << (i + 1 < stages.size() ? "},\n" : "}\n");
+    }
+    out << "  ]\n}\n";
+}
+
+}
+
+int main(int argc, char** argv) {
+    std::size_t iterations = 200;
+    bool json = false;
+    std::string out_path;
+
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view arg = argv[i];
+        if (arg == "--startup-probe") {
+            return probeStartup();
+        } else if (arg == "--iterations" && i + 1 < argc) {
+            iterations = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--json") {
+            json = true;
+        } else if (arg == "--out" && i + 1 < argc) {
+            out_path = argv[++i];
+            json = true;
+        } else {
+            std::cerr << "usage: " << argv[0] << " [--iterations n] [--json] [--out file]" << std::endl;
+            return 2;
+        }
+    }
+
+    using timelib::ParsedQuery;
+    using timelib::QueryResult;
+    using timelib::QueryType;
+    using timelib::TimeConverter;
+
+    const std::vector<std::string_view> corpus(std::begin(kCorpus), std::end(kCorpus));
+    const TimeConverter converter;
+
+    std::vector<ParsedQuery> queries;
+    for (const auto input : corpus) queries.push_back(converter.parseInput(input));
+
+    // stage inputs, split out of the corpus the way the pipeline would see them
+    std::vector<std::string> names;
+    std::vector<const ParsedQuery*> conversions;
+    std::vector<const ParsedQuery*> differences;
+    std::vector<std::pair<const ParsedQuery*, QueryResult>> evaluated;
+    for (const auto& query : queries) {
+        if (!query.is_valid) continue;
+        names.push_back(query.location_a);
+        if (query.location_b) names.push_back(*query.location_b);
+        if (query.type == QueryType::Conversion) conversions.push_back(&query);
+        if (query.type == QueryType::Difference) differences.push_back(&query);
+        evaluated.emplace_back(&query, TimeConverter::evaluate(query));
+    }
+
+    timelib::ZoneResolver resolver;
+    std::string rendered;
+    // keeps the measured calls from being optimized away
+    volatile std::size_t sink = 0;
+
+    std::vector<Stage> stages;
+    stages.push_back(measureStartup(argv[0]));
+    stages.push_back(measure("parse", corpus.size(), iterations, [&](const std::size_t i) {
+        sink += static_cast<std::size_t>(converter.parseInput(corpus[i]).is_valid);
+    }));
+    stages.push_back(measure("resolve", names.size(), iterations, [&](const std::size_t i) {
+        sink += resolver.resolve(names[i]) != nullptr;
+    }));
+    stages.push_back(measure("resolve_uncached", names.size(), std::max<std::size_t>(iterations / 10, 1), [&](const std::size_t i) {
+        sink += resolver.resolveUncached(names[i]) != nullptr;
+    }));
+    stages.push_back(measure("convert", conversions.size(), iterations, [&](const std::size_t i) {
+        sink += static_cast<std::size_t>(TimeConverter::evaluate(*conversions[i]).code);
+    }));
+    stages.push_back(measure("difference", differences.size(), iterations, [&](const std::size_t i) {
+        sink += static_cast<std::size_t>(TimeConverter::evaluate(*differences[i]).code);
+    }));
+    stages.push_back(measure("format", evaluated.size(), iterations, [&](const std::size_t i) {
+        rendered.clear();
+        TimeConverter::render(std::back_inserter(rendered), evaluated[i].second, *evaluated[i].first);
+        sink += rendered.size();
+    }));
+    stages.push_back(measure("process_query", queries.size(), iterations, [&](const std::size_t i) {
+        sink += static_cast<std::size_t>(TimeConverter::processQuery(queries[i], rendered));
+    }));
+    stages.push_back(measure("end_to_end", corpus.size(), iterations, [&](const std::size_t i) {
+        sink += static_cast<std::size_t>(TimeConverter::processQuery(converter.parseInput(corpus[i]), rendered));
+    }));
+
+    if (!json) {
+        writeText(std::cout, stages);
+    } else if (out_path.empty()) {
+        writeJson(std::cout, stages, corpus.size(), iterations);
+    } else {
+        std::ofstream file(out_path);
+        writeJson(file, stages, corpus.size(), iterations);
+        if (!file) {
+            std::cerr << "could not write " << out_path << std::endl;
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,216 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string_view>
+
+namespace timelib {
+
+    struct AliasKey {
+        std::string_view key;
+        std::uint16_t target = 0;
+        // a later duplicate of this key overwrites it instead of being dropped
+        bool replaces = true;
+    };
+
+    namespace detail {
+
+        constexpr char asciiLower(const char c) {
+            return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+        }
+
+        constexpr bool equalsIgnoreCase(const std::string_view a, const std::string_view b) {
+            if (a.size() != b.size()) return false;
+            for (std::size_t i = 0; i < a.size(); ++i) {
+                if (asciiLower(a[i]) != asciiLower(b[i])) return false;
+            }
+            return true;
+        }
+
+        constexpr int compareIgnoreCase(const std::string_view a, const std::string_view b) {
+            const std::size_t length = a.size() < b.size() ? a.size() : b.size();
+            for (std::size_t i = 0; i < length; ++i) {
+                const auto ca = static_cast<unsigned char>(asciiLower(a[i]));
+                const auto cb = static_cast<unsigned char>(asciiLower(b[i]));
+                if (ca != cb) return ca < cb ? -1 : 1;
+            }
+            return a.size() == b.size() ? 0 : (a.size() < b.size() ? -1 : 1);
+        }
+
+        // fnv-1a over the lowercased bytes, so lookups never need a lowered copy of the key
+        constexpr std::uint64_t hashIgnoreCase(const std::string_view key) {
+            std::uint64_t hash = 0xcbf29ce484222325ULL;
+            for (const char c : key) {
+                hash ^= static_cast<unsigned char>(asciiLower(c));
+                hash *= 0x100000001b3ULL;
+            }
+            return hash;
+        }
+
+        constexpr std::uint64_t mixSeed(std::uint64_t hash, const std::uint32_t seed) {
+            hash ^= seed * 0x9e3779b97f4a7c15ULL;
+            hash ^= hash >> 33;
+            hash *= 0xff51afd7ed558ccdULL;
+            hash ^= hash >> 33;
+            return hash;
+        }
+
+        // "a|b|c" lists keep the built-in tables readable
+        constexpr std::size_t aliasCount(const std::string_view list) {
+            if (list.empty()) return 0;
+            std::size_t count = 1;
+            for (const char c : list) {
+                if (c == '|') ++count;
+            }
+            return count;
+        }
+
+        constexpr std::string_view aliasAt(std::string_view list, std::size_t index) {
+            while (index-- > 0) list.remove_prefix(list.find('|') + 1);
+            return list.substr(0, list.find('|'));
+        }
+
+        constexpr std::size_t scratchCapacity(const std::size_t n) {
+            std::size_t capacity = 1;
+            while (capacity < 2 * n) capacity *= 2;
+            return capacity;
+        }
+
+        // first-seen index of every key through a scratch open addressing table, which keeps the
+        // dedup linear (gcc's constexpr evaluator makes a quadratic pass take seconds)
+        template <std::size_t N>
+        constexpr std::array<std::size_t, N> firstOccurrences(const std::array<AliasKey, N>& keys) {
+            constexpr std::size_t capacity = scratchCapacity(N);
+            std::array<std::size_t, capacity> table{};
+            std::array<std::size_t, N> first{};
+            for (std::size_t i = 0; i < N; ++i) {
+                std::size_t slot = hashIgnoreCase(keys[i].key) & (capacity - 1);
+                while (table[slot] != 0 && !equalsIgnoreCase(keys[table[slot] - 1].key, keys[i].key)) {
+                    slot = (slot + 1) & (capacity - 1);
+                }
+                if (table[slot] == 0) table[slot] = i + 1;
+                first[i] = table[slot] - 1;
+            }
+            return first;
+        }
+
+        template <std::size_t N>
+        constexpr std::size_t uniqueKeyCount(const std::array<AliasKey, N>& keys) {
+            const auto first = firstOccurrences(keys);
+            std::size_t count = 0;
+            for (std::size_t i = 0; i < N; ++i) {
+                if (first[i] == i) ++count;
+            }
+            return count;
+        }
+
+        // folds duplicates the way the old unordered_map inserts did: keys stay in first-seen
+        // order, and a duplicate only changes the target when it is marked as replacing
+        template <std::size_t M, std::size_t N>
+        constexpr std::array<AliasKey, M> mergeAliasKeys(const std::array<AliasKey, N>& keys) {
+            const auto first = firstOccurrences(keys);
+            std::array<std::size_t, N> position{};
+            std::array<AliasKey, M> merged{};
+            std::size_t count = 0;
+            for (std::size_t i = 0; i < N; ++i) {
+                if (first[i] == i) {
+                    position[i] = count;
+                    merged[count++] = keys[i];
+                } else if (keys[i].replaces) {
+                    merged[position[first[i]]].target = keys[i].target;
+                }
+            }
+            return merged;
+        }
+
+    }
+
+    // perfect hash over a fixed key set, built entirely at compile time (hash and displace: every
+    // key lands in a bucket, and each bucket stores the seed that scatters its keys into free
+    // slots). a lookup is one pass over the key, one slot probe and one compare, and keys are
+    // matched without regard to ascii case.
+    template <std::size_t N>
+    class AliasTable {
+        static_assert(N > 0 && N < 32767, "alias table size out of range");
+
+    public:
+        constexpr explicit AliasTable(const std::array<AliasKey, N>& keys) : keys_(keys) {
+            for (auto& slot : slots_) slot = -1;
+
+            std::array<std::uint64_t, N> hashes{};
+            std::array<std::size_t, kBuckets + 1> starts{};
+            for (std::size_t i = 0; i < N; ++i) {
+                hashes[i] = detail::hashIgnoreCase(keys_[i].key);
+                ++starts[hashes[i] % kBuckets + 1];
+            }
+            for (std::size_t b = 0; b < kBuckets; ++b) starts[b + 1] += starts[b];
+
+            // keys grouped by bucket, counting sort style
+            std::array<std::size_t, N> members{};
+            std::array<std::size_t, kBuckets> filled{};
+            for (std::size_t i = 0; i < N; ++i) {
+                const std::size_t bucket = hashes[i] % kBuckets;
+                members[starts[bucket] + filled[bucket]++] = i;
+            }
+
+            // biggest buckets first while most slots are still free
+            std::array<std::size_t, kBuckets> order{};
+            for (std::size_t i = 0; i < kBuckets; ++i) {
+                std::size_t j = i;
+                while (j > 0 && filled[order[j - 1]] < filled[i]) {
+                    order[j] = order[j - 1];
+                    --j;
+                }
+                order[j] = i;
+            }
+
+            std::array<std::size_t, N> placed{};
+            for (const std::size_t bucket : order) {
+                const std::size_t first = starts[bucket];
+                const std::size_t count = filled[bucket];
+                if (count == 0) break;
+
+                for (std::uint32_t seed = 1;; ++seed) {
+                    if (seed == kMaxSeed) throw std::logic_error("alias table: no seed found for bucket");
+
+                    bool fits = true;
+                    for (std::size_t m = 0; m < count && fits; ++m) {
+                        placed[m] = detail::mixSeed(hashes[members[first + m]], seed) % kSlots;
+                        fits = slots_[placed[m]] < 0;
+                        for (std::size_t k = 0; k < m && fits; ++k) fits = placed[k] != placed[m];
+                    }
+                    if (!fits) continue;
+
+                    seeds_[bucket] = seed;
+                    for (std::size_t m = 0; m < count; ++m) {
+                        slots_[placed[m]] = static_cast<std::int16_t>(members[first + m]);
+                    }
+                    break;
+                }
+            }
+        }
+
+        // index of `key` among the keys the table was built from, or -1
+        constexpr int find(const std::string_view key) const {
+            const std::uint64_t hash = detail::hashIgnoreCase(key);
+            const int index = slots_[detail::mixSeed(hash, seeds_[hash % kBuckets]) % kSlots];
+            if (index < 0 || !detail::equalsIgnoreCase(keys_[index].key, key)) return -1;
+            return index;
+        }
+
+        constexpr std::size_t size() const { return N; }
+        constexpr const AliasKey& operator[](const std::size_t index) const { return keys_[index]; }
+
+    private:
+        static constexpr std::size_t kBuckets = N / 2 + 1;
+        static constexpr std::size_t kSlots = N + N / 4 + 1;
+        static constexpr std::uint32_t kMaxSeed = 1u << 20;
+
+        std::array<AliasKey, N> keys_{};
+        std::array<std::uint32_t, kBuckets> seeds_{};
+        std::array<std::int16_t, kSlots> slots_{};
+    };
+
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <date/date.h>
+
+namespace timelib {
+
+    // where "now" comes from. TimeConverter reads it once per query (once per batch for
+    // processBatch) and hands that instant to every stage, so a query never straddles a minute
+    // or a day. implementations have to be safe to call from any thread.
+    class Clock {
+    public:
+        virtual ~Clock() = default;
+        virtual date::sys_seconds now() const = 0;
+    };
+
+    // the real time, read from std::chrono::system_clock on every call
+    class SystemClock final : public Clock {
+    public:
+        date::sys_seconds now() const override {
+            return date::floor<std::chrono::seconds>(std::chrono::system_clock::now());
+        }
+    };
+
+    // always the same instant, for evaluating queries as of some point in the past or future and
+    // for reproducible output
+    class FixedClock final : public Clock {
+    public:
+        explicit FixedClock(const date::sys_seconds instant) : instant_(instant) {}
+
+        date::sys_seconds now() const override { return instant_; }
+
+    private:
+        const date::sys_seconds instant_;
+    };
+
+    // the real time as of the last tick. a background thread refreshes it every `interval`, so
+    // reading it is a single relaxed load instead of a system call, at the price of running up
+    // to one interval late
+    class CoarseClock final : public Clock {
+    public:
+        explicit CoarseClock(std::chrono::milliseconds interval = std::chrono::milliseconds{100});
+        ~CoarseClock() override;
+
+        CoarseClock(const CoarseClock&) = delete;
+        CoarseClock& operator=(const CoarseClock&) = delete;
+
+        date::sys_seconds now() const override {
+            return date::sys_seconds{std::chrono::seconds{seconds_.load(std::memory_order_relaxed)}};
+        }
+
+    private:
+        std::atomic<std::int64_t> seconds_;
+        const std::chrono::milliseconds interval_;
+
+        std::mutex mutex_;
+        std::condition_variable wake_;
+        bool stopping_ = false;
+        std::thread ticker_;
+
+        void refresh();
+        void tick();
+    };
+
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <date/date.h>
+#include <date/tz.h>
+
+namespace timelib {
+
+    struct ZoneOffset {
+        std::chrono::seconds offset{0};
+        // interned, stays valid for the life of the process
+        std::string_view abbrev;
+    };
+
+    // a zone's offset history flattened into sorted parallel arrays for [first, last) years.
+    // interval i starts at starts_[i] and runs until starts_[i + 1] (or the end of the range),
+    // adjacent intervals with the same offset and abbreviation are merged.
+    class CompiledZone {
+    public:
+        // tables this small are scanned with a compare-and-count loop the compiler vectorizes,
+        // bigger ones use a branchless binary search
+        static constexpr std::size_t kLinearSearchLimit = 32;
+
+        CompiledZone(const date::time_zone* zone, date::year first, date::year last);
+        // adopts tables that were compiled ahead of time (see ZoneImage), abbreviation ids must
+        // already be interned
+        CompiledZone(const date::time_zone* zone, std::int64_t begin, std::int64_t end,
+                     std::vector<std::int64_t> starts, std::vector<std::int32_t> offsets,
+                     std::vector<std::uint16_t> abbrevs);
+
+        const date::time_zone* zone() const { return zone_; }
+        std::size_t size() const { return starts_.size(); }
+        bool covers(date::sys_seconds tp) const;
+
+        // only meaningful for instants the table covers
+        ZoneOffset offsetAt(date::sys_seconds tp) const;
+
+        // local -> utc with date::zoned_time's choose semantics (a skipped local time maps to
+        // the transition instant). nullopt when the local time is too close to the edge of the
+        // range to answer from the table alone.
+        std::optional<date::sys_seconds> toSys(date::local_seconds tp, date::choose z) const;
+
+        std::int64_t rangeBegin() const { return begin_; }
+        std::int64_t rangeEnd() const { return end_; }
+        const std::vector<std::int64_t>& starts() const { return starts_; }
+        const std::vector<std::int32_t>& offsets() const { return offsets_; }
+        const std::vector<std::uint16_t>& abbrevIds() const { return abbrevs_; }
+
+        static std::uint16_t internAbbrev(std::string_view abbrev);
+        static std::string_view abbrev(std::uint16_t id);
+
+    private:
+        const date::time_zone* zone_;
+        std::int64_t begin_ = 0;
+        std::int64_t end_ = 0;
+
+        std::vector<std::int64_t> starts_;
+        std::vector<std::int32_t> offsets_;
+        std::vector<std::uint16_t> abbrevs_;
+
+        std::size_t intervalAt(std::int64_t seconds) const;
+    };
+
+    // process wide registry of compiled zones, filled lazily the first time a zone is used.
+    // the helpers answer from the table when it covers the instant and fall back to the date
+    // library otherwise, so callers don't have to care whether the layer is enabled.
+    class ZoneTables {
+    public:
+        // years covered by tables built from now on. an empty range turns the layer off. tables
+        // built for the old range are retired but kept alive, since callers may still hold them
+        static void setYearRange(date::year first, date::year last);
+
+        // serves tables from a compiled image (see timelib_tzcompile) instead of building them,
+        // and switches the year range to the image's. false when the file can't be used or was
+        // compiled from another tzdata release than the loaded one, in which case nothing changes
+        static bool loadImage(const std::string& path);
+        // stops serving tables from the image, for when the tzdb it was compiled from is replaced
+        static void unloadImage();
+
+        static const CompiledZone* find(const date::time_zone* zone);
+        // builds the registry and its pools now instead of on first use, for a caller whose own
+        // statics have to be torn down before them (see TimeConverter::warmup)
+        static void prepare();
+
+        // 32-bit handles for zones, what a resolved ParsedQuery carries. a zone gets its id the
+        // first time it's asked for and keeps it for the life of the process (tzdb zones are never
+        // freed). kNoZone for a null zone, and once every id is taken
+        static constexpr std::uint32_t kNoZone = 0;
+        static std::uint32_t zoneId(const date::time_zone* zone);
+        static const date::time_zone* zoneById(std::uint32_t id);
+
+        static ZoneOffset offsetAt(const date::time_zone* zone, date::sys_seconds tp);
+        static date::sys_seconds toSys(const date::time_zone* zone, date::local_seconds tp, date::choose z);
+        // first instant after tp at which the zone's offset or abbreviation changes
+        static date::sys_seconds nextTransition(const date::time_zone* zone, date::sys_seconds tp);
+    };
+
+}
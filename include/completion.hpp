@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "names.hpp"
+
+namespace timelib {
+
+    struct Completion {
+        // lowercased, as indexed
+        std::string_view name;
+        std::string_view timezone;
+        std::string_view target;
+        NameKind kind = NameKind::ZoneName;
+    };
+
+    // sorted prefix index over names for autocomplete. names sharing a prefix form one contiguous
+    // run, and a sparse table over the run's weights pulls out the k best without scanning it, so
+    // a one letter prefix over a big gazetteer costs the same as a long one.
+    class PrefixIndex {
+    public:
+        PrefixIndex() = default;
+        // names are lowercased and copied, the first entry for a name wins
+        explicit PrefixIndex(const std::vector<NameEntry>& entries);
+
+        // over NameCatalog::builtin()
+        static PrefixIndex builtin();
+
+        // up to k names starting with `prefix` (case ignored), best first and at most one per
+        // target, so "san f" offers "san francisco" rather than also "san fran". location names
+        // beat aliases, which beat zone names, and shorter names win ties
+        std::vector<Completion> complete(std::string_view prefix, std::size_t k) const;
+
+        bool hasPrefix(std::string_view prefix) const;
+        std::size_t size() const { return entries_.size(); }
+
+    private:
+        struct Ref {
+            std::uint32_t offset;
+            std::uint32_t size;
+        };
+
+        struct Entry {
+            Ref name;
+            Ref timezone;
+            Ref target;
+            NameKind kind;
+        };
+
+        std::string text_;
+        // sorted by name
+        std::vector<Entry> entries_;
+        std::vector<std::uint32_t> weights_;
+        // levels_[j][i] is the best entry in [i, i + 2^j)
+        std::vector<std::vector<std::uint32_t>> levels_;
+
+        std::string_view view(Ref ref) const { return {text_.data() + ref.offset, ref.size}; }
+        std::uint32_t better(std::uint32_t a, std::uint32_t b) const;
+        std::uint32_t best(std::size_t first, std::size_t last) const;
+        std::pair<std::size_t, std::size_t> range(std::string_view lower) const;
+    };
+
+}
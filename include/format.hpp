@@ -0,0 +1,192 @@
+#pragma once
+
+#include <charconv>
+#include <chrono>
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <date/date.h>
+#include "compiled_zone.hpp"
+#include "meeting.hpp"
+
+namespace timelib {
+
+    namespace detail {
+
+        inline constexpr std::string_view kMonthNames[] = {
+            "Jan", "Feb", "Mar", "Apr", "May", "Jun", "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"};
+
+        inline constexpr char kTwoDigits[] =
+            "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+            "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+            "8081828384858687888990919293949596979899";
+
+        template <class Out>
+        Out write(Out out, const std::string_view text) {
+            for (const char c : text) *out++ = c;
+            return out;
+        }
+
+        template <class Out>
+        Out writeTwoDigits(Out out, const unsigned value) {
+            *out++ = kTwoDigits[value * 2];
+            *out++ = kTwoDigits[value * 2 + 1];
+            return out;
+        }
+
+        template <class Out>
+        Out writeNumber(Out out, const long long value) {
+            char digits[24];
+            const auto result = std::to_chars(digits, digits + sizeof(digits), value);
+            return write(out, std::string_view(digits, static_cast<std::size_t>(result.ptr - digits)));
+        }
+
+        // location names are printed with the first letter capitalized, like "Tokyo (JST)"
+        template <class Out>
+        Out writeCapitalized(Out out, const std::string_view text) {
+            if (text.empty()) return out;
+            const char first = text[0];
+            *out++ = first >= 'a' && first <= 'z' ? static_cast<char>(first - 'a' + 'A') : first;
+            return write(out, text.substr(1));
+        }
+
+        // "02:30 PM" for a time of day in seconds
+        template <class Out>
+        Out writeClock(Out out, const unsigned seconds) {
+            const unsigned hour = seconds / 3600 % 24;
+            out = writeTwoDigits(out, hour % 12 == 0 ? 12 : hour % 12);
+            *out++ = ':';
+            out = writeTwoDigits(out, seconds / 60 % 60);
+            return write(out, hour < 12 ? " AM" : " PM");
+        }
+
+        // "Jul 10, 02:30 PM" in utc
+        template <class Out>
+        Out writeUtc(Out out, const date::sys_seconds tp) {
+            const auto day = date::floor<date::days>(tp);
+            const date::year_month_day ymd{day};
+            out = write(out, kMonthNames[static_cast<unsigned>(ymd.month()) - 1]);
+            *out++ = ' ';
+            out = writeTwoDigits(out, static_cast<unsigned>(ymd.day()));
+            out = write(out, ", ");
+            return writeClock(out, static_cast<unsigned>((tp - day).count()));
+        }
+
+    }
+
+    // the converter's fixed output layouts, written straight into any output iterator (a char*,
+    // std::back_inserter of a reused string, ...). nothing is parsed at runtime and nothing is
+    // allocated beyond what the iterator itself does.
+    class TimeFormatter {
+    public:
+        // longest time() output, for sizing plain char buffers. abbreviations are at most 6
+        // characters in the tzdb, this leaves room for some more
+        static constexpr std::size_t kMaxTimeLength = 32;
+
+        // "Jul 10, 02:30 PM (BST)", same as date::format("%b %d, %I:%M %p (%Z)") did
+        template <class Out>
+        static Out time(Out out, const date::sys_seconds tp, const ZoneOffset& offset) {
+            const date::local_seconds local{tp.time_since_epoch() + offset.offset};
+            const auto day = date::floor<date::days>(local);
+            const date::year_month_day ymd{day};
+            const auto seconds = static_cast<unsigned>((local - day).count());
+
+            out = detail::write(out, detail::kMonthNames[static_cast<unsigned>(ymd.month()) - 1]);
+            *out++ = ' ';
+            out = detail::writeTwoDigits(out, static_cast<unsigned>(ymd.day()));
+            out = detail::write(out, ", ");
+            out = detail::writeClock(out, seconds);
+            out = detail::write(out, " (");
+            out = detail::write(out, offset.abbrev);
+            *out++ = ')';
+            return out;
+        }
+
+        // "The current time in london is Jul 10, 02:30 PM (BST)"
+        template <class Out>
+        static Out currentTime(Out out, const std::string_view location, const date::sys_seconds tp, const ZoneOffset& offset) {
+            out = detail::write(out, "The current time in ");
+            out = detail::write(out, location);
+            out = detail::write(out, " is ");
+            return time(out, tp, offset);
+        }
+
+        // "Jul 10, 09:30 PM (IST) in delhi is Jul 10, 12:00 PM (EDT) in nyc"
+        template <class Out>
+        static Out conversion(Out out, const std::string_view source, const std::string_view target, const date::sys_seconds tp,
+                              const ZoneOffset& source_offset, const ZoneOffset& target_offset) {
+            out = time(out, tp, source_offset);
+            out = detail::write(out, " in ");
+            out = detail::write(out, source);
+            out = detail::write(out, " is ");
+            out = time(out, tp, target_offset);
+            out = detail::write(out, " in ");
+            return detail::write(out, target);
+        }
+
+        // "Tokyo (JST) is 16h ahead of La (PDT)."
+        template <class Out>
+        static Out difference(Out out, const std::string_view name_a, const std::string_view name_b,
+                              const ZoneOffset& offset_a, const ZoneOffset& offset_b) {
+            const auto offset_diff = offset_a.offset - offset_b.offset;
+            const auto hours = std::chrono::duration_cast<std::chrono::hours>(offset_diff).count();
+            const auto minutes = std::chrono::duration_cast<std::chrono::minutes>(offset_diff % std::chrono::hours(1)).count();
+
+            out = detail::writeCapitalized(out, name_a);
+            out = detail::write(out, " (");
+            out = detail::write(out, offset_a.abbrev);
+            out = detail::write(out, ") is ");
+            if (offset_diff.count() == 0) {
+                out = detail::write(out, "in the same timezone as ");
+            } else {
+                if (hours != 0) {
+                    out = detail::writeNumber(out, hours < 0 ? -hours : hours);
+                    *out++ = 'h';
+                }
+                if (minutes != 0) {
+                    *out++ = ' ';
+                    out = detail::writeNumber(out, minutes < 0 ? -minutes : minutes);
+                    *out++ = 'm';
+                }
+                out = detail::write(out, offset_diff.count() > 0 ? " ahead of " : " behind ");
+            }
+            out = detail::writeCapitalized(out, name_b);
+            out = detail::write(out, " (");
+            out = detail::write(out, offset_b.abbrev);
+            return detail::write(out, ").");
+        }
+
+        // "Working hours 09:00 AM-05:00 PM overlap in london, nyc and tokyo (UTC): Oct 20, 01:00 PM-02:00 PM; ..."
+        // or "... don't overlap in ... in that period"
+        template <class Out>
+        static Out meeting(Out out, const std::vector<std::string>& locations, const int hour, const int minute,
+                           const int end_hour, const int end_minute, const std::vector<TimeInterval>& windows) {
+            out = detail::write(out, "Working hours ");
+            out = detail::writeClock(out, static_cast<unsigned>(hour * 3600 + minute * 60));
+            *out++ = '-';
+            out = detail::writeClock(out, static_cast<unsigned>(end_hour * 3600 + end_minute * 60));
+            out = detail::write(out, windows.empty() ? " don't overlap in " : " overlap in ");
+            for (std::size_t i = 0; i < locations.size(); ++i) {
+                if (i > 0) out = detail::write(out, i + 1 == locations.size() ? " and " : ", ");
+                out = detail::write(out, locations[i]);
+            }
+            if (windows.empty()) return detail::write(out, " in that period");
+
+            out = detail::write(out, " (UTC): ");
+            for (std::size_t i = 0; i < windows.size(); ++i) {
+                if (i > 0) out = detail::write(out, "; ");
+                out = detail::writeUtc(out, windows[i].begin);
+                *out++ = '-';
+                // the end only gets its date when it's on another day
+                if (date::floor<date::days>(windows[i].end) == date::floor<date::days>(windows[i].begin)) {
+                    out = detail::writeClock(out, static_cast<unsigned>((windows[i].end - date::floor<date::days>(windows[i].end)).count()));
+                } else {
+                    out = detail::writeUtc(out, windows[i].end);
+                }
+            }
+            return out;
+        }
+    };
+
+}
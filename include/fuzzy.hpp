@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "names.hpp"
+
+namespace timelib {
+
+    struct FuzzyOptions {
+        bool enabled = true;
+        // hard cap on typos
+        std::size_t max_distance = 2;
+        // at most one typo per this many characters of input, so short names never match something
+        // unrelated. 0 leaves only max_distance
+        std::size_t chars_per_edit = 3;
+        // 1 - distance / length of the longer string
+        double min_confidence = 0.75;
+    };
+
+    struct FuzzyMatch {
+        std::string_view name;
+        std::string_view timezone;
+        std::size_t distance = 0;
+        double confidence = 0.0;
+    };
+
+    // approximate lookup over location names, aliases and zone names. a trigram inverted index
+    // narrows the candidates to names sharing enough trigrams to be within the allowed distance,
+    // and a bit-parallel (myers/hyyrö) edit distance verifies them, so a search only touches a
+    // handful of names no matter how many are indexed.
+    class FuzzyMatcher {
+    public:
+        FuzzyMatcher() = default;
+        // names are lowercased and copied, the first entry for a name wins
+        explicit FuzzyMatcher(const std::vector<NameEntry>& entries);
+
+        // over NameCatalog::builtin()
+        static FuzzyMatcher builtin();
+
+        // within options' distance limits, ranked best first. views point into the matcher
+        std::vector<FuzzyMatch> search(std::string_view query, const FuzzyOptions& options, std::size_t limit) const;
+
+        // the top match when it clears the options and isn't tied with a match for another zone
+        std::optional<FuzzyMatch> best(std::string_view query, const FuzzyOptions& options) const;
+
+        std::size_t size() const { return entries_.size(); }
+
+        // levenshtein distance, bit-parallel when the shorter string fits in a machine word
+        static std::size_t editDistance(std::string_view a, std::string_view b);
+
+    private:
+        struct Entry {
+            std::uint32_t name_offset;
+            std::uint32_t name_size;
+            std::uint32_t timezone_offset;
+            std::uint32_t timezone_size;
+        };
+
+        std::string text_;
+        std::vector<Entry> entries_;
+
+        // csr posting lists: grams_[i] is a packed trigram, its entries are
+        // postings_[gram_starts_[i] .. gram_starts_[i + 1])
+        std::vector<std::uint32_t> grams_;
+        std::vector<std::uint32_t> gram_starts_;
+        std::vector<std::uint32_t> postings_;
+
+        std::string_view name(const Entry& entry) const { return {text_.data() + entry.name_offset, entry.name_size}; }
+        std::string_view timezone(const Entry& entry) const { return {text_.data() + entry.timezone_offset, entry.timezone_size}; }
+    };
+
+}
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "mapped_file.hpp"
+
+namespace timelib {
+
+    struct GazetteerOptions {
+        // places with fewer people are left out
+        std::uint32_t min_population = 15000;
+        // also index the alternate names column (other spellings and languages, codes)
+        bool alternate_names = true;
+    };
+
+    // on-disk layout of a compiled gazetteer, as written by timelib_gazcompile. sections follow
+    // the header in this order: zone names, places (most populous first), keys (sorted by their
+    // lowercased text), postings, every place's keys, then the string blob, which holds each
+    // distinct string once.
+    namespace places {
+        constexpr char kMagic[4] = {'T', 'L', 'G', 'Z'};
+        constexpr std::uint32_t kVersion = 1;
+
+        struct Header {
+            char magic[4];
+            std::uint32_t version;
+            std::uint32_t zone_count;
+            std::uint32_t place_count;
+            std::uint32_t key_count;
+            std::uint32_t posting_count;
+            std::uint32_t place_key_count;
+            std::uint32_t strings_size;
+        };
+
+        struct StringRef {
+            std::uint32_t offset;
+            std::uint32_t size;
+        };
+
+        struct Place {
+            StringRef name;
+            std::uint32_t zone;
+            std::uint32_t population;
+            // [first_key, first_key + key_count) of the place key section
+            std::uint32_t first_key;
+            std::uint32_t key_count;
+        };
+
+        // a name places are known by. its postings are place ids in ascending order, which is
+        // most populous first
+        struct Key {
+            StringRef text;
+            std::uint32_t first_posting;
+            std::uint32_t posting_count;
+        };
+    }
+
+    // a large read-only table of places (every city above some population, from a GeoNames style
+    // dump) for LocationMap to fall back on. the file is mapped and searched in place, so opening
+    // it is a header check and a lookup is a binary search over its keys, nothing is copied onto
+    // the heap per place. a name several places share ("paris") goes to the most populous one,
+    // "paris, us" picks by country.
+    class Gazetteer {
+    public:
+        static constexpr std::uint32_t kNone = ~std::uint32_t{0};
+
+        // nullptr when the file is missing, truncated or from another format version
+        static std::unique_ptr<const Gazetteer> open(const std::string& path);
+
+        // compiles a GeoNames style tsv (cities500.txt, cities15000.txt, allCountries.txt: name,
+        // ascii name, alternate names, country code, population and timezone in the usual
+        // columns) into a gazetteer file. returns the number of places written, 0 on failure
+        static std::size_t write(const std::string& tsv_path, const std::string& path, const GazetteerOptions& options = {});
+
+        Gazetteer(const Gazetteer&) = delete;
+        Gazetteer& operator=(const Gazetteer&) = delete;
+
+        std::size_t size() const { return header().place_count; }
+
+        // the most populous place known as `name` (case is ignored), kNone when there is none
+        std::uint32_t find(std::string_view name) const;
+        // every place known as `name`, most populous first
+        std::vector<std::uint32_t> findAll(std::string_view name, std::size_t limit = 10) const;
+
+        // views into the mapped file, valid for as long as the gazetteer is
+        std::string_view name(std::uint32_t place) const { return string(places_[place].name); }
+        std::string_view timezone(std::uint32_t place) const { return string(zones_[places_[place].zone]); }
+        std::uint32_t population(std::uint32_t place) const { return places_[place].population; }
+        // the other names the place is found under, lowercased
+        std::vector<std::string> aliases(std::uint32_t place) const;
+
+    private:
+        Gazetteer() = default;
+
+        detail::MappedFile file_;
+
+        const places::StringRef* zones_ = nullptr;
+        const places::Place* places_ = nullptr;
+        const places::Key* keys_ = nullptr;
+        const std::uint32_t* postings_ = nullptr;
+        const std::uint32_t* place_keys_ = nullptr;
+        const char* strings_ = nullptr;
+
+        const places::Header& header() const { return *reinterpret_cast<const places::Header*>(file_.data()); }
+        std::string_view string(places::StringRef ref) const { return {strings_ + ref.offset, ref.size}; }
+        const places::Key* findKey(std::string_view name) const;
+        bool validate();
+    };
+
+}
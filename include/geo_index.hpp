@@ -0,0 +1,147 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <date/tz.h>
+#include "mapped_file.hpp"
+
+namespace timelib {
+
+    struct Coordinate {
+        double latitude = 0;
+        double longitude = 0;
+    };
+
+    struct GeoIndexOptions {
+        // grid resolution, the world is split into (360 * n) x (180 * n) cells. has to divide
+        // 1000000 and be at most 40
+        std::uint32_t cells_per_degree = 4;
+        // boundaries are simplified (douglas-peucker) to within this many degrees, 0 keeps every
+        // vertex. the default is about 50 m at the equator
+        double tolerance = 0.0005;
+    };
+
+    // on-disk layout of a compiled coordinate index, as written by timelib_geocompile. sections
+    // follow the header in this order: zone names, one Cell per grid cell (row by row from the
+    // south pole, west to east), cell entries, edges, then the string blob.
+    namespace geo {
+        constexpr char kMagic[4] = {'T', 'L', 'G', 'I'};
+        constexpr std::uint32_t kVersion = 1;
+        // coordinates are stored in microdegrees, x is longitude and y latitude
+        constexpr std::int32_t kScale = 1000000;
+        constexpr std::uint32_t kNoZone = 0xffffffff;
+
+        struct Header {
+            char magic[4];
+            std::uint32_t version;
+            std::uint32_t cells_per_degree;
+            std::uint32_t zone_count;
+            std::uint32_t entry_count;
+            std::uint32_t edge_count;
+            std::uint32_t strings_size;
+            std::uint32_t reserved;
+        };
+
+        struct StringRef {
+            std::uint32_t offset;
+            std::uint32_t size;
+        };
+
+        // entries [first, first + count). a cell without entries lies inside one zone as a
+        // whole, which is then `first` (kNoZone when no zone covers it)
+        struct Cell {
+            std::uint32_t first;
+            std::uint32_t count;
+        };
+
+        // one zone whose boundary runs through a cell. `inside` tells whether the reference point
+        // (ref_x, ref_y) in the cell is in the zone, and another point of the cell is when the
+        // segment between them crosses the zone's edges an even number of times (odd if not)
+        struct CellEntry {
+            std::uint32_t zone;
+            std::uint32_t first_edge;
+            std::uint32_t edge_count;
+            std::uint32_t inside;
+            std::int32_t ref_x;
+            std::int32_t ref_y;
+        };
+
+        struct Edge {
+            std::int32_t x1;
+            std::int32_t y1;
+            std::int32_t x2;
+            std::int32_t y2;
+        };
+    }
+
+    // timezone lookup by latitude / longitude. boundary polygons are cut up onto a uniform grid
+    // when the index is compiled: cells well inside a zone answer straight away, and cells on a
+    // border keep only the border edges running through them and a reference point whose zone
+    // is known, so a point is settled by crossing a handful of edges instead of testing whole
+    // polygons. the compiled file is mapped read-only and checked once when it's opened.
+    class GeoIndex {
+    public:
+        // nullptr when the file is missing, truncated, from another format version or has
+        // coordinates off the globe. the zone names are looked up in `db`, which should be the one
+        // the index is used with (a null db finds none)
+        static std::unique_ptr<const GeoIndex> open(const std::string& path, const date::tzdb* db);
+        // the same file with its zone names looked up in another tzdb, for after a reload. the
+        // mapping is shared, not made again
+        std::unique_ptr<const GeoIndex> rebind(const date::tzdb* db) const;
+
+        // compiles a geojson FeatureCollection of timezone boundaries (like the ones
+        // timezone-boundary-builder releases: a "tzid" property and Polygon / MultiPolygon
+        // geometry per feature) into an index file. returns the number of zones written, 0 on failure
+        static std::size_t write(const std::string& geojson_path, const std::string& path, const GeoIndexOptions& options = {});
+
+        GeoIndex(const GeoIndex&) = delete;
+        GeoIndex& operator=(const GeoIndex&) = delete;
+
+        std::size_t size() const { return header().zone_count; }
+        std::uint32_t cellsPerDegree() const { return header().cells_per_degree; }
+        // what the zone names were looked up in
+        const date::tzdb* tzdb() const { return db_; }
+
+        // nullptr outside every boundary (open sea, or when the file has no oceans), for
+        // coordinates that aren't on the globe and for zones the loaded tzdb doesn't have
+        const date::time_zone* lookup(double latitude, double longitude) const;
+        // the zone's name as the file spells it, empty where lookup finds nothing in the file
+        std::string_view name(double latitude, double longitude) const;
+
+        // lookup over a whole array, out has to have room for count zones
+        void lookup(const Coordinate* coordinates, std::size_t count, const date::time_zone** out) const;
+        std::vector<const date::time_zone*> lookup(const std::vector<Coordinate>& coordinates) const;
+
+        // "51.5074,-0.1278", "51.5074, -0.1278" or "51.5074 -0.1278", latitude first
+        static std::optional<Coordinate> parseCoordinate(std::string_view text);
+
+    private:
+        GeoIndex() = default;
+
+        // indexes rebound to another tzdb share the mapping
+        detail::MappedFile file_;
+
+        const geo::StringRef* names_ = nullptr;
+        const geo::Cell* cells_ = nullptr;
+        const geo::CellEntry* entries_ = nullptr;
+        const geo::Edge* edges_ = nullptr;
+        const char* strings_ = nullptr;
+        std::uint32_t width_ = 0;
+        std::uint32_t height_ = 0;
+        // the tzdb zone for each name, resolved when the file is opened
+        const date::tzdb* db_ = nullptr;
+        std::vector<const date::time_zone*> zones_;
+
+        const geo::Header& header() const { return *reinterpret_cast<const geo::Header*>(file_.data()); }
+        std::string_view string(geo::StringRef ref) const { return {strings_ + ref.offset, ref.size}; }
+        std::uint32_t find(double latitude, double longitude) const;
+        bool validate();
+        void bind(const date::tzdb* db);
+    };
+
+}
@@ -1,10 +1,19 @@
 // NOTE: a majority of this file was "generated" using AI tools (specifically, using Gemini 2.5 Pro).
 #pragma once
 
-#include <unordered_map>
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <optional>
 #include <string>
+#include <string_view>
+#include <utility>
 #include <vector>
-#include <algorithm>
+#include "alias_table.hpp"
+#include "gazetteer.hpp"
+#include "string_pool.hpp"
 
 namespace timelib {
 
@@ -14,54 +23,221 @@ namespace timelib {
         std::vector<std::string> aliases;
     };
 
-    class LocationMap {
-    public:
-        LocationMap() {
-            initializeLocations();
-        }
+    struct BuiltinLocation {
+        std::string_view official_name;
+        std::string_view timezone;
+        std::string_view aliases;
+    };
 
-        std::string getTimezone(const std::string& location) const {
-            std::string lower_location = location;
-            std::transform(lower_location.begin(), lower_location.end(), lower_location.begin(), ::tolower);
+    namespace detail {
 
-            if (const auto it = alias_to_location_.find(lower_location); it != alias_to_location_.end()) {
-                if (const auto loc_it = locations_.find(it->second); loc_it != locations_.end()) {
-                    return loc_it->second.timezone;
+        inline constexpr BuiltinLocation kBuiltinLocations[] = {
+            {"new york", "America/New_York", "nyc|ny|new york city|manhattan|eastern time|et"},
+            {"los angeles", "America/Los_Angeles", "la|l.a.|la county|pacific time|pt"},
+            {"chicago", "America/Chicago", "chi|central time|ct"},
+            {"san francisco", "America/Los_Angeles", "sf|bay area|san fran|frisco"},
+            {"london", "Europe/London", "london|uk|britain|england|great britain|united kingdom"},
+            {"paris", "Europe/Paris", "paris|france"},
+            {"berlin", "Europe/Berlin", "berlin|germany"},
+            {"tokyo", "Asia/Tokyo", "tokyo|tokio|japan"},
+            {"mumbai", "Asia/Kolkata", "mumbai|bombay"},
+            {"delhi", "Asia/Kolkata", "delhi|new delhi|india"},
+            {"sydney", "Australia/Sydney", "sydney|australia"},
+            {"melbourne", "Australia/Melbourne", "melbourne|melbrn"},
+            {"houston", "America/Chicago", "houston"},
+            {"phoenix", "America/Phoenix", "phoenix|arizona|mountain time no dst"},
+            {"philadelphia", "America/New_York", "philly"},
+            {"san antonio", "America/Chicago", "san antonio"},
+            {"san diego", "America/Los_Angeles", "san diego"},
+            {"dallas", "America/Chicago", "dallas|dfw"},
+            {"san jose", "America/Los_Angeles", "san jose"},
+            {"austin", "America/Chicago", "austin|atx"},
+            {"jacksonville", "America/New_York", "jacksonville|jax"},
+            {"indianapolis", "America/Indiana/Indianapolis", "indy"},
+            {"columbus", "America/New_York", "columbus"},
+            {"seattle", "America/Los_Angeles", "seattle"},
+            {"denver", "America/Denver", "denver|mountain time|mt"},
+            {"washington dc", "America/New_York", "washington|dc|d.c."},
+            {"boston", "America/New_York", "boston"},
+            {"detroit", "America/Detroit", "detroit"},
+            {"nashville", "America/Chicago", "nashville"},
+            {"memphis", "America/Chicago", "memphis"},
+            {"portland", "America/Los_Angeles", "portland|pdx"},
+            {"las vegas", "America/Los_Angeles", "vegas"},
+            {"miami", "America/New_York", "miami"},
+            {"atlanta", "America/New_York", "atlanta|atl"},
+            {"new orleans", "America/Chicago", "nola"},
+            {"honolulu", "Pacific/Honolulu", "honolulu|hawaii|hst"},
+            {"anchorage", "America/Anchorage", "anchorage|alaska|akst"},
+            {"toronto", "America/Toronto", "toronto|the 6ix"},
+            {"montreal", "America/Toronto", "montreal"},
+            {"vancouver", "America/Vancouver", "vancouver|yvr"},
+            {"calgary", "America/Edmonton", "calgary"},
+            {"edmonton", "America/Edmonton", "edmonton"},
+            {"ottawa", "America/Toronto", "ottawa"},
+            {"quebec city", "America/Toronto", "quebec"},
+            {"winnipeg", "America/Winnipeg", "winnipeg"},
+            {"halifax", "America/Halifax", "halifax"},
+            {"st johns", "America/St_Johns", "st. john's|newfoundland"},
+            {"sao paulo", "America/Sao_Paulo", "sao paulo|sp|brazil"},
+            {"buenos aires", "America/Argentina/Buenos_Aires", "buenos aires|ba|argentina"},
+            {"rio de janeiro", "America/Sao_Paulo", "rio"},
+            {"bogota", "America/Bogota", "bogota|colombia"},
+            {"lima", "America/Lima", "lima|peru"},
+            {"santiago", "America/Santiago", "santiago|chile"},
+            {"caracas", "America/Caracas", "caracas|venezuela"},
+            {"quito", "America/Guayaquil", "quito|ecuador"},
+            {"la paz", "America/La_Paz", "la paz|bolivia"},
+            {"montevideo", "America/Montevideo", "montevideo|uruguay"},
+            {"asuncion", "America/Asuncion", "asuncion|paraguay"},
+            {"mexico city", "America/Mexico_City", "mexico city|cdmx|mexico"},
+            {"havana", "America/Havana", "havana|cuba"},
+            {"panama city", "America/Panama", "panama"},
+            {"san jose cr", "America/Costa_Rica", "san jose|costa rica"},
+            {"kingston", "America/Jamaica", "kingston|jamaica"},
+            {"santo domingo", "America/Santo_Domingo", "santo domingo|dominican republic"},
+            {"madrid", "Europe/Madrid", "madrid|spain"},
+            {"rome", "Europe/Rome", "rome|italy"},
+            {"moscow", "Europe/Moscow", "moscow|russia"},
+            {"kyiv", "Europe/Kyiv", "kyiv|kiev|ukraine"},
+            {"amsterdam", "Europe/Amsterdam", "amsterdam|netherlands|holland"},
+            {"brussels", "Europe/Brussels", "brussels|belgium"},
+            {"vienna", "Europe/Vienna", "vienna|austria"},
+            {"zurich", "Europe/Zurich", "zurich|switzerland"},
+            {"athens", "Europe/Athens", "athens|greece"},
+            {"stockholm", "Europe/Stockholm", "stockholm|sweden"},
+            {"oslo", "Europe/Oslo", "oslo|norway"},
+            {"copenhagen", "Europe/Copenhagen", "copenhagen|denmark"},
+            {"helsinki", "Europe/Helsinki", "helsinki|finland"},
+            {"dublin", "Europe/Dublin", "dublin|ireland"},
+            {"lisbon", "Europe/Lisbon", "lisbon|portugal"},
+            {"prague", "Europe/Prague", "prague|czech republic"},
+            {"warsaw", "Europe/Warsaw", "warsaw|poland"},
+            {"budapest", "Europe/Budapest", "budapest|hungary"},
+            {"bucharest", "Europe/Bucharest", "bucharest|romania"},
+            {"istanbul", "Europe/Istanbul", "istanbul|turkey"},
+            {"beijing", "Asia/Shanghai", "beijing|peking"},
+            {"shanghai", "Asia/Shanghai", "shanghai|china"},
+            {"hong kong", "Asia/Hong_Kong", "hong kong|hk"},
+            {"singapore", "Asia/Singapore", "singapore|sg"},
+            {"seoul", "Asia/Seoul", "seoul|south korea"},
+            {"bangkok", "Asia/Bangkok", "bangkok|thailand"},
+            {"dubai", "Asia/Dubai", "dubai|uae|united arab emirates"},
+            {"jakarta", "Asia/Jakarta", "jakarta|indonesia"},
+            {"manila", "Asia/Manila", "manila|philippines"},
+            {"ho chi minh city", "Asia/Ho_Chi_Minh", "saigon|vietnam"},
+            {"taipei", "Asia/Taipei", "taipei|taiwan"},
+            {"kuala lumpur", "Asia/Kuala_Lumpur", "kuala lumpur|malaysia"},
+            {"karachi", "Asia/Karachi", "karachi|pakistan"},
+            {"dhaka", "Asia/Dhaka", "dhaka|bangladesh"},
+            {"riyadh", "Asia/Riyadh", "riyadh|saudi arabia"},
+            {"baghdad", "Asia/Baghdad", "baghdad|iraq"},
+            {"tehran", "Asia/Tehran", "tehran|iran"},
+            {"jerusalem", "Asia/Jerusalem", "jerusalem|israel"},
+            {"kabul", "Asia/Kabul", "kabul|afghanistan"},
+            {"yekaterinburg", "Asia/Yekaterinburg", "yekaterinburg"},
+            {"vladivostok", "Asia/Vladivostok", "vladivostok"},
+            {"cairo", "Africa/Cairo", "cairo|egypt"},
+            {"lagos", "Africa/Lagos", "lagos|nigeria"},
+            {"kinshasa", "Africa/Kinshasa", "kinshasa|drc"},
+            {"johannesburg", "Africa/Johannesburg", "johannesburg|joburg|south africa"},
+            {"nairobi", "Africa/Nairobi", "nairobi|kenya"},
+            {"addis ababa", "Africa/Addis_Ababa", "addis ababa|ethiopia"},
+            {"casablanca", "Africa/Casablanca", "casablanca|morocco"},
+            {"accra", "Africa/Accra", "accra|ghana"},
+            {"algiers", "Africa/Algiers", "algiers|algeria"},
+            {"dakar", "Africa/Dakar", "dakar|senegal"},
+            {"brisbane", "Australia/Brisbane", "brisbane"},
+            {"perth", "Australia/Perth", "perth"},
+            {"adelaide", "Australia/Adelaide", "adelaide"},
+            {"canberra", "Australia/Sydney", "canberra"},
+            {"darwin", "Australia/Darwin", "darwin"},
+            {"auckland", "Pacific/Auckland", "auckland|new zealand"},
+            {"wellington", "Pacific/Auckland", "wellington"},
+            {"fiji", "Pacific/Fiji", "fiji"},
+            {"papeete", "Pacific/Tahiti", "tahiti"},
+        };
+
+        constexpr std::size_t builtinLocationKeyCount() {
+            std::size_t count = 0;
+            for (const auto& location : kBuiltinLocations) count += 1 + aliasCount(location.aliases);
+            return count;
+        }
+
+        // every name and alias in table order. later entries win on duplicates, same as the old
+        // map inserts did ("san jose" ends up in costa rica)
+        constexpr std::array<AliasKey, builtinLocationKeyCount()> builtinLocationKeys() {
+            std::array<AliasKey, builtinLocationKeyCount()> keys{};
+            std::size_t count = 0;
+            for (std::size_t i = 0; i < std::size(kBuiltinLocations); ++i) {
+                const auto target = static_cast<std::uint16_t>(i);
+                keys[count++] = {kBuiltinLocations[i].official_name, target, true};
+                for (std::size_t a = 0; a < aliasCount(kBuiltinLocations[i].aliases); ++a) {
+                    keys[count++] = {aliasAt(kBuiltinLocations[i].aliases, a), target, true};
                 }
             }
-            return "";
+            return keys;
         }
 
-        bool hasLocation(const std::string& location) const {
-            std::string lower_location = location;
-            std::transform(lower_location.begin(), lower_location.end(), lower_location.begin(), ::tolower);
+        inline constexpr auto kBuiltinLocationKeys = builtinLocationKeys();
+        inline constexpr std::size_t kLocationAliasCount = uniqueKeyCount(kBuiltinLocationKeys);
+        inline constexpr AliasTable<kLocationAliasCount> kLocationAliases{
+            mergeAliasKeys<kLocationAliasCount>(kBuiltinLocationKeys)};
 
-            return alias_to_location_.find(lower_location) != alias_to_location_.end();
-        }
+    }
 
-        std::vector<std::string> getLocationAliases(const std::string& location) const {
-            std::string lower_location = location;
-            std::transform(lower_location.begin(), lower_location.end(), lower_location.begin(), ::tolower);
+    // built-in locations live in a compile time perfect hash, so constructing a map is free and a
+    // lookup is a single probe. addLocation entries go into a small runtime overlay that is
+    // checked first and can replace a built-in location by name. the overlay keeps its strings in
+    // a StringPool and its rows as parallel arrays of pool ids, a zone name shared by many
+    // locations is stored once. names neither of those know fall through to the gazetteer when
+    // one is set, which is shared (not copied) between copies of the map.
+    class LocationMap {
+    public:
+        LocationMap() = default;
 
-            if (const auto it = alias_to_location_.find(lower_location); it != alias_to_location_.end()) {
-                if (const auto loc_it = locations_.find(it->second); loc_it != locations_.end()) {
-                    return loc_it->second.aliases;
-                }
-            }
+        // timezone for a name or alias, empty when unknown. case is ignored and nothing is copied.
+        // views stay valid for as long as the map does. `places` false leaves the gazetteer out
+        std::string_view findTimezone(const std::string_view location, const bool places = true) const {
+            const Match match = find(location, places);
+            if (match.runtime != kNone) return pool_.view(zones_[match.runtime]);
+            if (match.builtin) return match.builtin->timezone;
+            if (match.place != Gazetteer::kNone) return gazetteer_->timezone(match.place);
             return {};
         }
 
-        const LocationInfo* getLocationInfo(const std::string& location) const {
-            std::string lower_location = location;
-            std::transform(lower_location.begin(), lower_location.end(), lower_location.begin(), ::tolower);
+        std::string getTimezone(const std::string_view location) const {
+            return std::string(findTimezone(location));
+        }
+
+        bool hasLocation(const std::string_view location) const {
+            const Match match = find(location);
+            return match.runtime != kNone || match.builtin || match.place != Gazetteer::kNone;
+        }
 
-            if (const auto it = alias_to_location_.find(lower_location); it != alias_to_location_.end()) {
-                const auto loc_it = locations_.find(it->second);
-                if (loc_it != locations_.end()) {
-                    return &loc_it->second;
-                }
+        std::vector<std::string> getLocationAliases(const std::string_view location) const {
+            const Match match = find(location);
+            if (match.runtime != kNone) return runtimeAliases(match.runtime);
+            if (match.builtin) return splitAliases(match.builtin->aliases);
+            if (match.place != Gazetteer::kNone) return gazetteer_->aliases(match.place);
+            return {};
+        }
+
+        std::optional<LocationInfo> getLocationInfo(const std::string_view location) const {
+            const Match match = find(location);
+            if (match.runtime != kNone) {
+                return LocationInfo{std::string(pool_.view(names_[match.runtime])), std::string(pool_.view(zones_[match.runtime])),
+                                    runtimeAliases(match.runtime)};
+            }
+            if (match.builtin) {
+                return LocationInfo{std::string(match.builtin->official_name), std::string(match.builtin->timezone),
+                                    splitAliases(match.builtin->aliases)};
+            }
+            if (match.place != Gazetteer::kNone) {
+                return LocationInfo{std::string(gazetteer_->name(match.place)), std::string(gazetteer_->timezone(match.place)),
+                                    gazetteer_->aliases(match.place)};
             }
-            return nullptr;
+            return std::nullopt;
         }
 
         void addLocation(const std::string& name, const std::string& timezone,
@@ -69,156 +245,121 @@ namespace timelib {
             addLocationInternal(name, timezone, aliases);
         }
 
+        // consulted after the runtime and built-in locations, nullptr to drop it again
+        void setGazetteer(std::shared_ptr<const Gazetteer> gazetteer) { gazetteer_ = std::move(gazetteer); }
+        const std::shared_ptr<const Gazetteer>& gazetteer() const { return gazetteer_; }
+
     private:
-        std::unordered_map<std::string, LocationInfo> locations_;
-        std::unordered_map<std::string, std::string> alias_to_location_;
-
-        void initializeLocations() {
-            addLocationInternal("new york", "America/New_York", {"nyc", "ny", "new york city", "manhattan", "eastern time", "et"});
-            addLocationInternal("los angeles", "America/Los_Angeles", {"la", "l.a.", "la county", "pacific time", "pt"});
-            addLocationInternal("chicago", "America/Chicago", {"chi", "central time", "ct"});
-            addLocationInternal("san francisco", "America/Los_Angeles", {"sf", "bay area", "san fran", "frisco"});
-            addLocationInternal("london", "Europe/London", {"london", "londn", "uk", "britain", "england", "great britain", "united kingdom"});
-            addLocationInternal("paris", "Europe/Paris", {"paris", "pari", "france"});
-            addLocationInternal("berlin", "Europe/Berlin", {"berlin", "berln", "germany"});
-            addLocationInternal("tokyo", "Asia/Tokyo", {"tokyo", "tokio", "japan"});
-            addLocationInternal("mumbai", "Asia/Kolkata", {"mumbai", "bombay", "bombai"});
-            addLocationInternal("delhi", "Asia/Kolkata", {"delhi", "new delhi", "india"});
-            addLocationInternal("sydney", "Australia/Sydney", {"sydney", "sydny", "australia"});
-            addLocationInternal("melbourne", "Australia/Melbourne", {"melbourne", "melbrn"});
-            addLocationInternal("houston", "America/Chicago", {"houston"});
-            addLocationInternal("phoenix", "America/Phoenix", {"phoenix", "arizona", "mountain time no dst"});
-            addLocationInternal("philadelphia", "America/New_York", {"philly"});
-            addLocationInternal("san antonio", "America/Chicago", {"san antonio"});
-            addLocationInternal("san diego", "America/Los_Angeles", {"san diego"});
-            addLocationInternal("dallas", "America/Chicago", {"dallas", "dfw"});
-            addLocationInternal("san jose", "America/Los_Angeles", {"san jose"});
-            addLocationInternal("austin", "America/Chicago", {"austin", "atx"});
-            addLocationInternal("jacksonville", "America/New_York", {"jacksonville", "jax"});
-            addLocationInternal("indianapolis", "America/Indiana/Indianapolis", {"indy"});
-            addLocationInternal("columbus", "America/New_York", {"columbus"});
-            addLocationInternal("seattle", "America/Los_Angeles", {"seattle"});
-            addLocationInternal("denver", "America/Denver", {"denver", "mountain time", "mt"});
-            addLocationInternal("washington dc", "America/New_York", {"washington", "dc", "d.c."});
-            addLocationInternal("boston", "America/New_York", {"boston"});
-            addLocationInternal("detroit", "America/Detroit", {"detroit"});
-            addLocationInternal("nashville", "America/Chicago", {"nashville"});
-            addLocationInternal("memphis", "America/Chicago", {"memphis"});
-            addLocationInternal("portland", "America/Los_Angeles", {"portland", "pdx"});
-            addLocationInternal("las vegas", "America/Los_Angeles", {"vegas"});
-            addLocationInternal("miami", "America/New_York", {"miami"});
-            addLocationInternal("atlanta", "America/New_York", {"atlanta", "atl"});
-            addLocationInternal("new orleans", "America/Chicago", {"nola"});
-            addLocationInternal("honolulu", "Pacific/Honolulu", {"honolulu", "hawaii", "hst"});
-            addLocationInternal("anchorage", "America/Anchorage", {"anchorage", "alaska", "akst"});
-            addLocationInternal("toronto", "America/Toronto", {"toronto", "the 6ix"});
-            addLocationInternal("montreal", "America/Toronto", {"montreal"});
-            addLocationInternal("vancouver", "America/Vancouver", {"vancouver", "yvr"});
-            addLocationInternal("calgary", "America/Edmonton", {"calgary"});
-            addLocationInternal("edmonton", "America/Edmonton", {"edmonton"});
-            addLocationInternal("ottawa", "America/Toronto", {"ottawa"});
-            addLocationInternal("quebec city", "America/Toronto", {"quebec"});
-            addLocationInternal("winnipeg", "America/Winnipeg", {"winnipeg"});
-            addLocationInternal("halifax", "America/Halifax", {"halifax"});
-            addLocationInternal("st johns", "America/St_Johns", {"st. john's", "newfoundland"});
-            addLocationInternal("sao paulo", "America/Sao_Paulo", {"sao paulo", "sp", "brazil"});
-            addLocationInternal("buenos aires", "America/Argentina/Buenos_Aires", {"buenos aires", "ba", "argentina"});
-            addLocationInternal("rio de janeiro", "America/Sao_Paulo", {"rio"});
-            addLocationInternal("bogota", "America/Bogota", {"bogota", "colombia"});
-            addLocationInternal("lima", "America/Lima", {"lima", "peru"});
-            addLocationInternal("santiago", "America/Santiago", {"santiago", "chile"});
-            addLocationInternal("caracas", "America/Caracas", {"caracas", "venezuela"});
-            addLocationInternal("quito", "America/Guayaquil", {"quito", "ecuador"});
-            addLocationInternal("la paz", "America/La_Paz", {"la paz", "bolivia"});
-            addLocationInternal("montevideo", "America/Montevideo", {"montevideo", "uruguay"});
-            addLocationInternal("asuncion", "America/Asuncion", {"asuncion", "paraguay"});
-            addLocationInternal("mexico city", "America/Mexico_City", {"mexico city", "cdmx", "mexico"});
-            addLocationInternal("havana", "America/Havana", {"havana", "cuba"});
-            addLocationInternal("panama city", "America/Panama", {"panama"});
-            addLocationInternal("san jose cr", "America/Costa_Rica", {"san jose", "costa rica"});
-            addLocationInternal("kingston", "America/Jamaica", {"kingston", "jamaica"});
-            addLocationInternal("santo domingo", "America/Santo_Domingo", {"santo domingo", "dominican republic"});
-            addLocationInternal("madrid", "Europe/Madrid", {"madrid", "spain"});
-            addLocationInternal("rome", "Europe/Rome", {"rome", "italy"});
-            addLocationInternal("moscow", "Europe/Moscow", {"moscow", "russia"});
-            addLocationInternal("kyiv", "Europe/Kyiv", {"kyiv", "kiev", "ukraine"});
-            addLocationInternal("amsterdam", "Europe/Amsterdam", {"amsterdam", "netherlands", "holland"});
-            addLocationInternal("brussels", "Europe/Brussels", {"brussels", "belgium"});
-            addLocationInternal("vienna", "Europe/Vienna", {"vienna", "austria"});
-            addLocationInternal("zurich", "Europe/Zurich", {"zurich", "switzerland"});
-            addLocationInternal("athens", "Europe/Athens", {"athens", "greece"});
-            addLocationInternal("stockholm", "Europe/Stockholm", {"stockholm", "sweden"});
-            addLocationInternal("oslo", "Europe/Oslo", {"oslo", "norway"});
-            addLocationInternal("copenhagen", "Europe/Copenhagen", {"copenhagen", "denmark"});
-            addLocationInternal("helsinki", "Europe/Helsinki", {"helsinki", "finland"});
-            addLocationInternal("dublin", "Europe/Dublin", {"dublin", "ireland"});
-            addLocationInternal("lisbon", "Europe/Lisbon", {"lisbon", "portugal"});
-            addLocationInternal("prague", "Europe/Prague", {"prague", "czech republic"});
-            addLocationInternal("warsaw", "Europe/Warsaw", {"warsaw", "poland"});
-            addLocationInternal("budapest", "Europe/Budapest", {"budapest", "hungary"});
-            addLocationInternal("bucharest", "Europe/Bucharest", {"bucharest", "romania"});
-            addLocationInternal("istanbul", "Europe/Istanbul", {"istanbul", "turkey"});
-            addLocationInternal("beijing", "Asia/Shanghai", {"beijing", "peking"});
-            addLocationInternal("shanghai", "Asia/Shanghai", {"shanghai", "china"});
-            addLocationInternal("hong kong", "Asia/Hong_Kong", {"hong kong", "hk"});
-            addLocationInternal("singapore", "Asia/Singapore", {"singapore", "sg"});
-            addLocationInternal("seoul", "Asia/Seoul", {"seoul", "south korea"});
-            addLocationInternal("bangkok", "Asia/Bangkok", {"bangkok", "thailand"});
-            addLocationInternal("dubai", "Asia/Dubai", {"dubai", "uae", "united arab emirates"});
-            addLocationInternal("jakarta", "Asia/Jakarta", {"jakarta", "indonesia"});
-            addLocationInternal("manila", "Asia/Manila", {"manila", "philippines"});
-            addLocationInternal("ho chi minh city", "Asia/Ho_Chi_Minh", {"saigon", "vietnam"});
-            addLocationInternal("taipei", "Asia/Taipei", {"taipei", "taiwan"});
-            addLocationInternal("kuala lumpur", "Asia/Kuala_Lumpur", {"kuala lumpur", "malaysia"});
-            addLocationInternal("karachi", "Asia/Karachi", {"karachi", "pakistan"});
-            addLocationInternal("dhaka", "Asia/Dhaka", {"dhaka", "bangladesh"});
-            addLocationInternal("riyadh", "Asia/Riyadh", {"riyadh", "saudi arabia"});
-            addLocationInternal("baghdad", "Asia/Baghdad", {"baghdad", "iraq"});
-            addLocationInternal("tehran", "Asia/Tehran", {"tehran", "iran"});
-            addLocationInternal("jerusalem", "Asia/Jerusalem", {"jerusalem", "israel"});
-            addLocationInternal("kabul", "Asia/Kabul", {"kabul", "afghanistan"});
-            addLocationInternal("yekaterinburg", "Asia/Yekaterinburg", {"yekaterinburg"});
-            addLocationInternal("vladivostok", "Asia/Vladivostok", {"vladivostok"});
-            addLocationInternal("cairo", "Africa/Cairo", {"cairo", "egypt"});
-            addLocationInternal("lagos", "Africa/Lagos", {"lagos", "nigeria"});
-            addLocationInternal("kinshasa", "Africa/Kinshasa", {"kinshasa", "drc"});
-            addLocationInternal("johannesburg", "Africa/Johannesburg", {"johannesburg", "joburg", "south africa"});
-            addLocationInternal("nairobi", "Africa/Nairobi", {"nairobi", "kenya"});
-            addLocationInternal("addis ababa", "Africa/Addis_Ababa", {"addis ababa", "ethiopia"});
-            addLocationInternal("casablanca", "Africa/Casablanca", {"casablanca", "morocco"});
-            addLocationInternal("accra", "Africa/Accra", {"accra", "ghana"});
-            addLocationInternal("algiers", "Africa/Algiers", {"algiers", "algeria"});
-            addLocationInternal("dakar", "Africa/Dakar", {"dakar", "senegal"});
-            addLocationInternal("brisbane", "Australia/Brisbane", {"brisbane"});
-            addLocationInternal("perth", "Australia/Perth", {"perth"});
-            addLocationInternal("adelaide", "Australia/Adelaide", {"adelaide"});
-            addLocationInternal("canberra", "Australia/Sydney", {"canberra"});
-            addLocationInternal("darwin", "Australia/Darwin", {"darwin"});
-            addLocationInternal("auckland", "Pacific/Auckland", {"auckland", "new zealand"});
-            addLocationInternal("wellington", "Pacific/Auckland", {"wellington"});
-            addLocationInternal("fiji", "Pacific/Fiji", {"fiji"});
-            addLocationInternal("papeete", "Pacific/Tahiti", {"tahiti"});
+        static constexpr std::uint32_t kNone = ~std::uint32_t{0};
+
+        struct Match {
+            // row in the runtime arrays, kNone when the built-in entry (if any) applies
+            std::uint32_t runtime = kNone;
+            const BuiltinLocation* builtin = nullptr;
+            // gazetteer place, when neither of the above know the name
+            std::uint32_t place = Gazetteer::kNone;
+        };
+
+        StringPool pool_;
+        // one row per added location
+        std::vector<StringPool::Id> names_;
+        std::vector<StringPool::Id> zones_;
+        // [alias_starts_, alias_starts_ + alias_counts_) in alias_ids_
+        std::vector<std::uint32_t> alias_starts_;
+        std::vector<std::uint32_t> alias_counts_;
+        std::vector<StringPool::Id> alias_ids_;
+        // lowercased alias -> row, sorted by alias
+        std::vector<std::pair<StringPool::Id, std::uint32_t>> runtime_aliases_;
+        std::shared_ptr<const Gazetteer> gazetteer_;
+
+        Match find(const std::string_view location, const bool places = true) const {
+            if (const std::uint32_t row = findRuntimeAlias(location); row != kNone) return {row, nullptr};
+
+            const int index = detail::kLocationAliases.find(location);
+            if (index < 0) {
+                if (places && gazetteer_) return {kNone, nullptr, gazetteer_->find(location)};
+                return {};
+            }
+
+            const auto& builtin = detail::kBuiltinLocations[detail::kLocationAliases[index].target];
+            if (const std::uint32_t row = findRuntimeLocation(builtin.official_name); row != kNone) return {row, nullptr};
+            return {kNone, &builtin};
+        }
+
+        std::uint32_t findRuntimeAlias(const std::string_view alias) const {
+            if (runtime_aliases_.empty()) return kNone;
+            const auto it = std::lower_bound(runtime_aliases_.begin(), runtime_aliases_.end(), alias,
+                [this](const auto& entry, const std::string_view key) { return detail::compareIgnoreCase(pool_.view(entry.first), key) < 0; });
+            if (it == runtime_aliases_.end() || !detail::equalsIgnoreCase(pool_.view(it->first), alias)) return kNone;
+            return it->second;
+        }
+
+        std::uint32_t findRuntimeLocation(const std::string_view name) const {
+            const auto id = pool_.find(name);
+            if (!id) return kNone;
+            const auto it = std::find(names_.begin(), names_.end(), *id);
+            return it != names_.end() ? static_cast<std::uint32_t>(it - names_.begin()) : kNone;
+        }
+
+        std::vector<std::string> runtimeAliases(const std::uint32_t row) const {
+            std::vector<std::string> aliases;
+            aliases.reserve(alias_counts_[row]);
+            for (std::uint32_t i = 0; i < alias_counts_[row]; ++i) aliases.emplace_back(pool_.view(alias_ids_[alias_starts_[row] + i]));
+            return aliases;
+        }
+
+        static std::vector<std::string> splitAliases(const std::string_view list) {
+            std::vector<std::string> aliases;
+            aliases.reserve(detail::aliasCount(list));
+            for (std::size_t i = 0; i < detail::aliasCount(list); ++i) aliases.emplace_back(detail::aliasAt(list, i));
+            return aliases;
+        }
+
+        // cuts a row's alias range out of alias_ids_ before it gets a new one, so replacing a
+        // location over and over doesn't grow the array
+        void releaseAliases(const std::uint32_t row) {
+            const std::uint32_t start = alias_starts_[row];
+            const std::uint32_t count = alias_counts_[row];
+            if (count == 0) return;
+            alias_ids_.erase(alias_ids_.begin() + start, alias_ids_.begin() + start + count);
+            for (auto& other : alias_starts_) {
+                if (other > start) other -= count;
+            }
+            alias_counts_[row] = 0;
         }
 
         void addLocationInternal(const std::string& name, const std::string& timezone,
                                 const std::vector<std::string>& aliases) {
-            LocationInfo info;
-            info.official_name = name;
-            info.timezone = timezone;
-            info.aliases = aliases;
-
-            locations_[name] = info;
+            std::uint32_t row = findRuntimeLocation(name);
+            if (row == kNone) {
+                row = static_cast<std::uint32_t>(names_.size());
+                names_.push_back(pool_.intern(name));
+                zones_.emplace_back();
+                alias_starts_.emplace_back();
+                alias_counts_.emplace_back();
+            }
 
-            std::string lower_name = name;
-            std::transform(lower_name.begin(), lower_name.end(), lower_name.begin(), ::tolower);
-            alias_to_location_[lower_name] = name;
+            zones_[row] = pool_.intern(timezone);
+            releaseAliases(row);
+            alias_starts_[row] = static_cast<std::uint32_t>(alias_ids_.size());
+            alias_counts_[row] = static_cast<std::uint32_t>(aliases.size());
+            for (const auto& alias : aliases) alias_ids_.push_back(pool_.intern(alias));
 
+            addRuntimeAlias(name, row);
             for (const auto& alias : aliases) {
-                std::string lower_alias = alias;
-                std::transform(lower_alias.begin(), lower_alias.end(), lower_alias.begin(), ::tolower);
-                alias_to_location_[lower_alias] = name;
+                addRuntimeAlias(alias, row);
             }
         }
+
+        void addRuntimeAlias(const std::string& alias, const std::uint32_t row) {
+            std::string lower_alias = alias;
+            std::transform(lower_alias.begin(), lower_alias.end(), lower_alias.begin(), detail::asciiLower);
+
+            const auto it = std::lower_bound(runtime_aliases_.begin(), runtime_aliases_.end(), lower_alias,
+                [this](const auto& entry, const std::string& key) { return pool_.view(entry.first) < key; });
+            if (it != runtime_aliases_.end() && pool_.view(it->first) == lower_alias) it->second = row;
+            else runtime_aliases_.emplace(it, pool_.intern(lower_alias), row);
+        }
     };
 
-}
\ No newline at end of file
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace timelib {
+
+    // plumbing shared by the compiled file formats (zone image, geo index, gazetteer): a header
+    // followed by sections that each start 8-byte aligned, so a file can be used straight out of
+    // an mmap. numbers are in the host's byte order, files are meant to be compiled on the
+    // machine (or arch) that loads them.
+    namespace detail {
+
+        constexpr std::size_t alignUp(const std::size_t offset) {
+            return (offset + 7) & ~static_cast<std::size_t>(7);
+        }
+
+        // a whole file, read-only. mapped, or read into a buffer where mmap isn't available.
+        // copies share the storage, which goes when the last of them does
+        class MappedFile {
+        public:
+            MappedFile() = default;
+
+            // empty when the file can't be opened or read
+            static MappedFile open(const std::string& path);
+
+            explicit operator bool() const { return storage_ != nullptr; }
+            const unsigned char* data() const { return storage_.get(); }
+            std::size_t size() const { return size_; }
+
+        private:
+            std::shared_ptr<const unsigned char> storage_;
+            std::size_t size_ = 0;
+        };
+
+        // hands out a file's sections in order, starting with the header
+        class SectionCursor {
+        public:
+            explicit SectionCursor(const MappedFile& file) : data_(file.data()), size_(file.size()) {}
+
+            // the next `count` items, nullptr when they don't fit in what's left of the file.
+            // checked by division so huge counts from a corrupt header can't overflow
+            template <class T>
+            const T* next(const std::size_t count) {
+                at_ = alignUp(at_);
+                if (!data_ || at_ > size_ || count > (size_ - at_) / sizeof(T)) return nullptr;
+                const unsigned char* start = data_ + at_;
+                at_ += count * sizeof(T);
+                return reinterpret_cast<const T*>(start);
+            }
+
+        private:
+            const unsigned char* data_;
+            std::size_t size_;
+            std::size_t at_ = 0;
+        };
+
+        // the writing side: pads to the next section boundary, then writes the items as they are
+        template <class T>
+        void writeSection(std::ostream& out, const std::vector<T>& items) {
+            static constexpr char kPadding[8] = {};
+            const auto at = static_cast<std::size_t>(out.tellp());
+            out.write(kPadding, static_cast<std::streamsize>(alignUp(at) - at));
+            out.write(reinterpret_cast<const char*>(items.data()), static_cast<std::streamsize>(items.size() * sizeof(T)));
+        }
+
+    }
+
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <date/date.h>
+#include <date/tz.h>
+
+namespace timelib {
+
+    class ZoneResolver;
+
+    // when one participant (or a whole office) works, in their own wall clock time
+    struct WorkingHours {
+        std::string location;
+        // from the start of the local day. an end at or before the start runs past midnight
+        std::chrono::minutes start{9 * 60};
+        std::chrono::minutes end{17 * 60};
+        // bit n set when date::weekday{n} is a working day (0 is sunday), monday to friday by default
+        std::uint8_t weekdays = 0b0111110;
+    };
+
+    // [begin, end) in utc
+    struct TimeInterval {
+        date::sys_seconds begin{};
+        date::sys_seconds end{};
+
+        std::chrono::seconds length() const { return end - begin; }
+    };
+
+    struct MeetingWindows {
+        // sorted and disjoint
+        std::vector<TimeInterval> windows;
+        // locations that didn't resolve. nothing is searched when there are any
+        std::vector<std::string> missing;
+    };
+
+    // finds the stretches of time in which everyone is inside their working hours. every distinct
+    // (zone, hours, weekdays) combination becomes a sorted list of utc intervals, one per working
+    // day with both ends mapped through the zone's offset table, and the lists are intersected
+    // pairwise with a linear merge. a hundred people spread over a handful of offices cost a
+    // handful of lists, so a month stays in the microseconds.
+    class MeetingPlanner {
+    public:
+        // windows shorter than min_length are dropped
+        static MeetingWindows find(const ZoneResolver& resolver, const std::vector<WorkingHours>& participants,
+                                   date::sys_seconds begin, date::sys_seconds end,
+                                   std::chrono::minutes min_length = std::chrono::minutes{0});
+
+        // the utc intervals one zone is at work in, clipped to [begin, end). wall times that fall
+        // into a gap map to the transition, ambiguous ones to the earlier instant
+        static std::vector<TimeInterval> workingIntervals(const date::time_zone* zone, const WorkingHours& hours,
+                                                          date::sys_seconds begin, date::sys_seconds end);
+        // both inputs sorted and disjoint
+        static std::vector<TimeInterval> intersect(const std::vector<TimeInterval>& a, const std::vector<TimeInterval>& b);
+    };
+
+}
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include "time.hpp"
+
+// build with TIMELIB_METRICS=1 (the cmake option of the same name) to record where queries
+// spend their time. without it the recording macros expand to nothing and Metrics::snapshot()
+// is all zeros.
+#ifndef TIMELIB_METRICS
+#define TIMELIB_METRICS 0
+#endif
+
+namespace timelib {
+
+    enum class MetricStage : std::uint8_t {
+        Parse,
+        Resolve,
+        // offsets and conversions against already resolved zones
+        ZoneLookup,
+        Format,
+        Count
+    };
+
+    enum class MetricCounter : std::uint8_t {
+        // how ZoneResolver found (or didn't find) a zone
+        ResolveCacheHit,
+        ResolveZoneName,
+        ResolveLocationAlias,
+        ResolveTimezoneAlias,
+        ResolveGazetteer,
+        ResolveCoordinates,
+        ResolveFuzzy,
+        ResolveMiss,
+        // which grammar rule accepted a query, tried in this order
+        ParseMeeting,
+        ParseDifference,
+        ParseConversion,
+        ParseImplicitConversion,
+        ParseQueryForm,
+        ParseRejected,
+        Count
+    };
+
+    inline constexpr std::size_t kMetricStageCount = static_cast<std::size_t>(MetricStage::Count);
+    inline constexpr std::size_t kMetricCounterCount = static_cast<std::size_t>(MetricCounter::Count);
+    inline constexpr std::size_t kErrorCodeCount = static_cast<std::size_t>(ErrorCode::NoTargetLocation) + 1;
+    // bucket i holds latencies in [2^(i-1), 2^i) ns, the last one everything slower
+    inline constexpr std::size_t kLatencyBuckets = 32;
+
+    struct StageStats {
+        std::uint64_t count = 0;
+        std::uint64_t total_ns = 0;
+        std::array<std::uint64_t, kLatencyBuckets> buckets{};
+
+        double meanNs() const { return count ? static_cast<double>(total_ns) / static_cast<double>(count) : 0.0; }
+        // upper bound of the bucket holding the p-th latency, p in [0, 1]
+        std::uint64_t percentileNs(double p) const;
+    };
+
+    struct MetricsSnapshot {
+        std::array<StageStats, kMetricStageCount> stages{};
+        std::array<std::uint64_t, kMetricCounterCount> counters{};
+        std::array<std::uint64_t, kErrorCodeCount> errors{};
+
+        const StageStats& stage(const MetricStage s) const { return stages[static_cast<std::size_t>(s)]; }
+        std::uint64_t counter(const MetricCounter c) const { return counters[static_cast<std::size_t>(c)]; }
+        // results evaluated with that code, Success included
+        std::uint64_t results(const ErrorCode code) const { return errors[static_cast<std::size_t>(code)]; }
+    };
+
+    // every thread records into its own block of relaxed atomics that only it writes, so
+    // recording is a load and a store with no contention. snapshot() sums the blocks of live
+    // threads and whatever exited threads left behind.
+    class Metrics {
+    public:
+        static constexpr bool enabled() { return TIMELIB_METRICS != 0; }
+
+        static MetricsSnapshot snapshot();
+        // later snapshots only count what happened after this call
+        static void reset();
+    };
+
+    namespace detail {
+
+        void recordCount(MetricCounter counter);
+        void recordResult(ErrorCode code);
+        void recordLatency(MetricStage stage, std::uint64_t ns);
+
+        class StageTimer {
+        public:
+            explicit StageTimer(const MetricStage stage) : stage_(stage), start_(std::chrono::steady_clock::now()) {}
+            ~StageTimer() {
+                const auto elapsed = std::chrono::steady_clock::now() - start_;
+                recordLatency(stage_, static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+            }
+
+            StageTimer(const StageTimer&) = delete;
+            StageTimer& operator=(const StageTimer&) = delete;
+
+        private:
+            MetricStage stage_;
+            std::chrono::steady_clock::time_point start_;
+        };
+
+    }
+
+}
+
+#define TIMELIB_METRIC_CONCAT_(a, b) a##b
+#define TIMELIB_METRIC_CONCAT(a, b) TIMELIB_METRIC_CONCAT_(a, b)
+
+#if TIMELIB_METRICS
+#define TIMELIB_METRIC_COUNT(counter) ::timelib::detail::recordCount(::timelib::MetricCounter::counter)
+#define TIMELIB_METRIC_RESULT(code) ::timelib::detail::recordResult(code)
+// times the rest of the enclosing scope
+#define TIMELIB_METRIC_TIME(stage) \
+    const ::timelib::detail::StageTimer TIMELIB_METRIC_CONCAT(timelib_stage_timer_, __LINE__)(::timelib::MetricStage::stage)
+#else
+#define TIMELIB_METRIC_COUNT(counter) ((void)0)
+#define TIMELIB_METRIC_RESULT(code) ((void)0)
+#define TIMELIB_METRIC_TIME(stage) ((void)0)
+#endif
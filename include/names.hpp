@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace timelib {
+
+    // ordered by how good a match of that kind is, higher wins
+    enum class NameKind : std::uint8_t {
+        ZoneName,
+        ZoneCity,
+        TimezoneAlias,
+        LocationAlias,
+        LocationName
+    };
+
+    struct NameEntry {
+        std::string_view name;
+        std::string_view timezone;
+        // what the name refers to: the location's official name, the official zone name for
+        // timezone aliases, or the zone itself. several names share one target
+        std::string_view target;
+        NameKind kind = NameKind::ZoneName;
+    };
+
+    // every name the library can resolve, for the indexes that search over all of them. built-in
+    // location and timezone aliases come first, then each tzdb zone and link by full name and by
+    // city ("America/Argentina/Buenos_Aires" also as "buenos aires").
+    class NameCatalog {
+    public:
+        NameCatalog() = default;
+
+        static NameCatalog builtin();
+
+        const std::vector<NameEntry>& entries() const { return entries_; }
+
+    private:
+        // backs the city names, the rest are views into static tables and the tzdb
+        std::deque<std::string> storage_;
+        std::vector<NameEntry> entries_;
+    };
+
+}
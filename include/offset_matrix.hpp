@@ -0,0 +1,76 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+#include <date/date.h>
+#include <date/tz.h>
+
+namespace timelib {
+
+    class ZoneResolver;
+
+    // an instant at which the offset difference between at least one pair of zones changes
+    struct DifferenceChange {
+        date::sys_seconds at{};
+        // zones whose offset moved at `at` and by how much. a pair's difference changed exactly
+        // when its two zones moved by different amounts (a zone that isn't listed didn't move)
+        std::vector<std::pair<std::size_t, std::chrono::seconds>> shifts;
+    };
+
+    // the offsets of a fixed set of locations over [begin, end) (an empty range is taken as just
+    // the instant begin). every zone's offset changes in the range are read once from its
+    // transition list, and the lists are merged in a single sweep to find the instants where some
+    // pair's difference changes: the cost follows the number of transitions, not the number of
+    // days or pairs. instants where every zone moves by the same amount (none in practice) and
+    // abbreviation-only changes aren't reported.
+    class OffsetMatrix {
+    public:
+        // locations can be anything ZoneResolver understands. ones that don't resolve are left
+        // out and listed in missing()
+        OffsetMatrix(const ZoneResolver& resolver, const std::vector<std::string>& locations, date::sys_seconds begin,
+                     date::sys_seconds end);
+
+        std::size_t size() const { return zones_.size(); }
+        const std::vector<std::string>& names() const { return names_; }
+        const std::vector<const date::time_zone*>& zones() const { return zones_; }
+        const std::vector<std::string>& missing() const { return missing_; }
+        date::sys_seconds begin() const { return begin_; }
+        date::sys_seconds end() const { return end_; }
+
+        // instants outside [begin, end) are clamped into it
+        std::chrono::seconds offset(std::size_t zone, date::sys_seconds tp) const;
+        // a's offset minus b's, positive when a is ahead
+        std::chrono::seconds difference(std::size_t a, std::size_t b, date::sys_seconds tp) const;
+        // the whole size() x size() matrix at tp, row major: out[a * size() + b] = difference(a, b, tp).
+        // reuses the capacity of `out`
+        void matrixAt(date::sys_seconds tp, std::vector<std::chrono::seconds>& out) const;
+        std::vector<std::chrono::seconds> matrixAt(date::sys_seconds tp) const;
+
+        // every instant in (begin, end) at which some pair's difference changes, in order
+        const std::vector<DifferenceChange>& changes() const { return changes_; }
+        // the instants at which the difference between a and b changes
+        std::vector<date::sys_seconds> changesBetween(std::size_t a, std::size_t b) const;
+
+    private:
+        std::vector<std::string> names_;
+        std::vector<const date::time_zone*> zones_;
+        std::vector<std::string> missing_;
+        date::sys_seconds begin_{};
+        date::sys_seconds end_{};
+
+        // zone z's offset intervals are [first_[z], first_[z + 1]) of starts_ / offsets_, the
+        // first one starting at begin_
+        std::vector<std::uint32_t> first_;
+        std::vector<std::int64_t> starts_;
+        std::vector<std::int32_t> offsets_;
+
+        std::vector<DifferenceChange> changes_;
+
+        std::size_t intervalAt(std::size_t zone, std::int64_t t) const;
+    };
+
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "completion.hpp"
+#include "time.hpp"
+
+namespace timelib {
+
+    struct Token {
+        std::string_view text;
+        std::size_t offset = 0;
+    };
+
+    // splits a query into whitespace separated words without copying anything. the tokens point
+    // into the input, so the input has to outlive the lexer.
+    class QueryLexer {
+    public:
+        static constexpr std::size_t kMaxTokens = 64;
+
+        explicit QueryLexer(std::string_view input);
+        // adopts tokens that were already lexed out of `input` (see IncrementalParser)
+        QueryLexer(std::string_view input, const std::vector<Token>& tokens);
+
+        // next token at or after `pos`, false when only whitespace is left
+        static bool next(std::string_view input, std::size_t pos, Token& token);
+
+        // false when the input had more than kMaxTokens words
+        bool ok() const { return !overflow_; }
+        std::size_t size() const { return count_; }
+        const Token& operator[](std::size_t index) const { return tokens_[index]; }
+        std::string_view input() const { return input_; }
+
+        // raw text covering tokens [first, last), spacing between them is kept as typed
+        std::string_view span(std::size_t first, std::size_t last) const;
+
+    private:
+        std::string_view input_;
+        std::array<Token, kMaxTokens> tokens_{};
+        std::size_t count_ = 0;
+        bool overflow_ = false;
+    };
+
+    // hand written replacement for the old regex cascade. the grammar works on whole words and is
+    // tried in the same order the regexes were: difference, conversion, implicit conversion and
+    // finally the "time in x" / "5pm in x" query form. meeting queries ("meeting times in london,
+    // nyc and tokyo") start with words none of those accept, they go first.
+    class QueryParser {
+    public:
+        // a query of more than QueryLexer::kMaxTokens (64) words is never looked at, it comes
+        // back invalid like any other input the grammar doesn't accept
+        static ParsedQuery parse(std::string_view input);
+        static ParsedQuery parse(const QueryLexer& tokens);
+
+        static void parseTimeString(std::string_view time_str, ParsedQuery& result);
+        static bool isValidTime(int hour, int minute);
+        static std::string normalizeLocation(std::string_view location);
+
+    private:
+        static bool parseMeeting(const QueryLexer& tokens, ParsedQuery& query);
+        static bool parseDifference(const QueryLexer& tokens, ParsedQuery& query);
+        static bool parseConversion(const QueryLexer& tokens, ParsedQuery& query);
+        static bool parseImplicitConversion(const QueryLexer& tokens, ParsedQuery& query);
+        static bool parseQuery(const QueryLexer& tokens, ParsedQuery& query);
+    };
+
+    // parse-as-you-type session for the launcher. each update only re-lexes from the first token
+    // the edit touched, and the grammar is skipped when the words didn't change (a typed space).
+    // completions come from a prefix index over every known name.
+    class IncrementalParser {
+    public:
+        IncrementalParser();
+        explicit IncrementalParser(const PrefixIndex& index);
+
+        // replaces the text with what the input box holds now
+        const ParsedQuery& update(std::string_view text);
+        const ParsedQuery& append(std::string_view text);
+        void clear();
+
+        const ParsedQuery& query() const { return query_; }
+        std::string_view text() const { return input_; }
+
+        // locations for the word(s) being typed, e.g. "san f" in "5pm in san f". a location can
+        // start after any of the grammar's link words, the earliest one that has completions wins
+        // so names with "of"/"in" in them still complete
+        std::vector<Completion> completions(std::size_t k = 5) const;
+
+    private:
+        const PrefixIndex* index_;
+        std::string input_;
+        // views into input_, re-pointed whenever it reallocates
+        std::vector<Token> tokens_;
+        ParsedQuery query_;
+        // the token span query_ was parsed from
+        std::string parsed_;
+
+        void reparse();
+    };
+
+}
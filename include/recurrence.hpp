@@ -0,0 +1,163 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <optional>
+#include <vector>
+#include <date/date.h>
+#include <date/tz.h>
+
+namespace timelib {
+
+    class CompiledZone;
+
+    enum class Frequency : std::uint8_t {
+        Daily,
+        Weekly,
+        Monthly
+    };
+
+    // what happens to an occurrence whose wall time doesn't exist (02:30 on a spring forward night)
+    enum class GapPolicy : std::uint8_t {
+        // read with the offset from before the gap, so 02:30 becomes 03:30 (what RFC 5545 does)
+        ShiftForward,
+        // the instant of the transition itself (what zoned_time and the rest of the library do)
+        Transition,
+        // no occurrence that day
+        Skip
+    };
+
+    // and to one whose wall time happens twice (01:30 on a fall back night)
+    enum class OverlapPolicy : std::uint8_t {
+        Earliest,
+        Latest
+    };
+
+    struct RecurrenceRule {
+        Frequency frequency = Frequency::Daily;
+        // every n-th day, week or month
+        std::uint32_t interval = 1;
+        // wall clock time of every occurrence, from the start of the local day (under 24h)
+        std::chrono::minutes time{9 * 60};
+        // bit n set for date::weekday{n} (0 is sunday), like WorkingHours. Daily: only on these
+        // days, 0 is every day. Weekly: these days of every week, weeks start on monday, 0 is the
+        // start's weekday. Monthly: these days of the month, or with an ordinal just the n-th of
+        // each ("second tuesday")
+        std::uint8_t weekdays = 0;
+        // Monthly without weekdays: the day of the month, negative counts from the end (-1 is the
+        // last day) and 0 takes the start's. months that don't have it are left out
+        int month_day = 0;
+        // Monthly with weekdays: 1 to 5 for the first to fifth, -1 to -5 from the end, 0 for all
+        int ordinal = 0;
+        // stop after this many occurrences (0 is no limit) and after `until` (inclusive)
+        std::size_t count = 0;
+        std::optional<date::sys_seconds> until;
+        GapPolicy gap = GapPolicy::ShiftForward;
+        OverlapPolicy overlap = OverlapPolicy::Earliest;
+    };
+
+    // a rule expanded into utc instants for one zone, lazily: iterating yields one occurrence at a
+    // time and nothing is computed ahead. candidate days come straight from calendar arithmetic,
+    // and each wall time is turned into an instant by walking the zone's compiled offset table
+    // forward from where the previous occurrence left off, so between two transitions that's one
+    // subtraction and the dst gap or overlap is seen (and handled by the rule's policy) right at the
+    // transition that causes it. wall times outside the table's years go through the date library.
+    class Recurrence {
+    private:
+        // everything expanding the rule needs. iterators carry their own copy, so one stays usable
+        // after the Recurrence it came from is gone (TimeConverter::recurrence(...).begin())
+        struct Source {
+            const date::time_zone* zone = nullptr;
+            date::local_days start;
+            RecurrenceRule rule;
+            const CompiledZone* table = nullptr;
+            // monday of the start's week, and the first of its month
+            date::local_days first_week;
+            date::year_month_day first_month;
+        };
+
+    public:
+        class iterator {
+        public:
+            using iterator_category = std::input_iterator_tag;
+            using value_type = date::sys_seconds;
+            using difference_type = std::ptrdiff_t;
+            using pointer = const date::sys_seconds*;
+            using reference = const date::sys_seconds&;
+
+            iterator() = default;
+
+            reference operator*() const { return current_; }
+            pointer operator->() const { return &current_; }
+            iterator& operator++() {
+                advance();
+                return *this;
+            }
+            iterator operator++(int) {
+                iterator old = *this;
+                advance();
+                return old;
+            }
+
+            // any two finished iterators are equal, so end() works for every one
+            friend bool operator==(const iterator& a, const iterator& b) {
+                return a.done_ == b.done_ && (a.done_ || (a.current_ == b.current_ && a.produced_ == b.produced_));
+            }
+            friend bool operator!=(const iterator& a, const iterator& b) { return !(a == b); }
+
+        private:
+            friend class Recurrence;
+
+            Source source_;
+            date::sys_seconds current_{};
+            bool done_ = true;
+            std::size_t produced_ = 0;
+
+            // the candidate days of the current period (a day, a week or a month)
+            std::int64_t period_ = 0;
+            std::array<date::local_days, 31> days_{};
+            std::size_t day_count_ = 0;
+            std::size_t next_day_ = 0;
+            std::size_t empty_periods_ = 0;
+            // offset table interval the last occurrence fell into
+            std::size_t interval_ = 0;
+            bool positioned_ = false;
+
+            // starting with period `period` (0 is the start's), which has to have no occurrences
+            // before it when the rule has a count
+            iterator(const Source& source, std::int64_t period);
+            void advance();
+            void fillPeriod();
+            std::optional<date::sys_seconds> toSys(date::local_seconds local);
+        };
+
+        // occurrences from `start` on, in `zone`. a null zone gives no occurrences
+        Recurrence(const date::time_zone* zone, date::local_days start, const RecurrenceRule& rule);
+
+        const date::time_zone* zone() const { return source_.zone; }
+        const RecurrenceRule& rule() const { return source_.rule; }
+
+        iterator begin() const { return iterator(source_, 0); }
+        iterator end() const { return iterator(); }
+
+        // the first `limit` occurrences (fewer when the rule runs out first)
+        std::vector<date::sys_seconds> expand(std::size_t limit) const;
+        // the occurrences in [from, to). without a count this starts at the period around `from`,
+        // so paging through consecutive windows doesn't walk everything before each one again
+        std::vector<date::sys_seconds> between(date::sys_seconds from, date::sys_seconds to) const;
+
+    private:
+        // a rule whose days never exist (february 30th) gives up after this many periods in a row
+        // without an occurrence
+        static constexpr std::size_t kMaxEmptyPeriods = 1000;
+
+        Source source_;
+
+        // the first period that can hold an occurrence on or after `day`
+        std::int64_t periodOf(date::local_days day) const;
+    };
+
+}
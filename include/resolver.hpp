@@ -0,0 +1,90 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <date/tz.h>
+#include "fuzzy.hpp"
+#include "snapshot.hpp"
+
+namespace timelib {
+
+    // turns user input ("nyc", "ist", "Europe/Paris") into a tzdb zone without going through
+    // exceptions. lookups read an immutable LookupSnapshot and never take a lock: each thread
+    // keeps the snapshot it last used from each resolver and only swaps it for the published one
+    // when the generation counter moved. changes (addLocation, reload, ...) build a new snapshot on the
+    // calling thread and publish it atomically, so queries running meanwhile finish on the old one.
+    // successful resolutions are memoized per snapshot by the exact input text.
+    class ZoneResolver {
+    public:
+        // misses aren't cached (launcher input is mostly half typed names), and once the cache
+        // holds this many names new ones are resolved without being remembered
+        static constexpr std::size_t kMaxCachedNames = LookupSnapshot::kMaxCachedNames;
+
+        ZoneResolver();
+
+        const date::time_zone* resolve(std::string_view location) const;
+        const date::time_zone* resolveUncached(std::string_view location) const;
+
+        // the state lookups currently run against
+        std::shared_ptr<const LookupSnapshot> snapshot() const;
+        // changes whenever a new snapshot is published, for caches built on top of lookups
+        std::uint64_t generation() const { return generation_.load(std::memory_order_acquire); }
+
+        // adds (or replaces, by name) a location and its aliases. takes effect for lookups that
+        // start after it returns
+        void addLocation(const std::string& name, const std::string& timezone, const std::vector<std::string>& aliases = {});
+        void addTimezoneAlias(const std::string& official_name, const std::vector<std::string>& aliases);
+
+        // re-reads the tz database (date::reload_tzdb) and publishes a snapshot over it. zones
+        // from the old database stay valid, the date library keeps every loaded version. false
+        // when the database couldn't be loaded, the current snapshot is kept then. with the os
+        // tzdb there is nothing to reload, the snapshot is just rebuilt
+        bool reload();
+
+        // names that didn't match exactly fall back to the fuzzy matcher, which is built the first
+        // time it's needed. changing the options forgets cached resolutions
+        void setFuzzyOptions(const FuzzyOptions& options);
+        FuzzyOptions fuzzyOptions() const;
+
+        // place names none of the other tables know are looked up in `gazetteer`, null turns
+        // that off again
+        void setGazetteer(std::shared_ptr<const Gazetteer> gazetteer);
+        // serves coordinates from `index` ("51.5,-0.12" resolves to Europe/London), null turns
+        // that off again. takes effect for lookups that start after it returns
+        void setGeoIndex(std::shared_ptr<const GeoIndex> index);
+        // the zone at a coordinate, nullptr without an index or where it has none
+        const date::time_zone* locate(double latitude, double longitude) const;
+        void locate(const Coordinate* coordinates, std::size_t count, const date::time_zone** out) const;
+
+        // ranked "did you mean" candidates, ignoring the confidence threshold
+        std::vector<FuzzyMatch> suggest(std::string_view location, std::size_t limit = 5) const;
+
+        // exact lookup in the current tzdb (zones, then links), nullptr when the name doesn't exist
+        static const date::time_zone* findZone(std::string_view name);
+
+    private:
+        // only read and written through std::atomic_load / std::atomic_store
+        std::shared_ptr<const LookupSnapshot> snapshot_;
+        // generation of snapshot_, checked by readers before they touch snapshot_ at all
+        std::atomic<std::uint64_t> generation_{0};
+        // serializes writers, readers never take it
+        std::mutex write_mutex_;
+
+        // resolvers a thread keeps the last snapshot of before it starts handing slots over
+        static constexpr std::size_t kThreadSlots = 8;
+
+        // the published snapshot, held by this thread's slot for this resolver. the reference is
+        // only good within the calling method: the slot moves on when the generation does, or
+        // when the thread has used kThreadSlots other resolvers since
+        const LookupSnapshot& current() const;
+        void publish(std::shared_ptr<const LookupSnapshot> snapshot);
+        static const date::time_zone* resolveIn(const LookupSnapshot& snapshot, std::string_view location);
+    };
+
+}
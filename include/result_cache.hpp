@@ -0,0 +1,88 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <date/date.h>
+#include "time.hpp"
+
+namespace timelib {
+
+    struct ResultCacheStats {
+        std::uint64_t hits = 0;
+        // includes lookups that found an expired or outdated entry
+        std::uint64_t misses = 0;
+        std::uint64_t evictions = 0;
+        std::size_t size = 0;
+        std::size_t capacity = 0;
+    };
+
+    // bounded lru of whole answers keyed by query text, split into shards so threads asking
+    // different questions rarely share a lock. an entry carries the instant it stops being right
+    // (end of the minute for "time in x", the next offset change for differences, the next utc
+    // day for conversions) and the resolver generation it was computed against, so adding a
+    // location or reloading tzdata retires everything older.
+    class ResultCache {
+    public:
+        static constexpr std::size_t kShards = 16;
+        // longer inputs aren't cached, nobody types a 256 character question
+        static constexpr std::size_t kMaxKeyLength = 256;
+
+        // 0 means off, lookups then return nothing without touching a lock
+        explicit ResultCache(std::size_t capacity = 0);
+
+        ResultCache(const ResultCache&) = delete;
+        ResultCache& operator=(const ResultCache&) = delete;
+
+        // shrinking evicts the least recently used entries right away
+        void setCapacity(std::size_t capacity);
+        bool enabled() const { return enabled_.load(std::memory_order_relaxed); }
+
+        std::shared_ptr<const QueryAnswer> find(std::string_view key, date::sys_seconds now, std::uint64_t generation);
+        void insert(std::string_view key, std::shared_ptr<const QueryAnswer> answer, date::sys_seconds expires,
+                    std::uint64_t generation);
+        void clear();
+
+        ResultCacheStats stats() const;
+
+        // the cache key for an input: surrounding whitespace dropped and ascii lowercased, which
+        // the parser ignores anyway. inner spacing is kept since it ends up in the rendered text.
+        // written into `buffer`, empty when the input doesn't fit
+        static std::string_view normalizeKey(std::string_view input, std::array<char, kMaxKeyLength>& buffer);
+
+    private:
+        struct Entry {
+            std::string key;
+            std::shared_ptr<const QueryAnswer> answer;
+            date::sys_seconds expires;
+            std::uint64_t generation;
+        };
+
+        struct alignas(64) Shard {
+            mutable std::mutex mutex;
+            // most recently used first
+            std::list<Entry> entries;
+            // keys point into the entries' own strings
+            std::unordered_map<std::string_view, std::list<Entry>::iterator> index;
+            std::size_t capacity = 0;
+            std::uint64_t hits = 0;
+            std::uint64_t misses = 0;
+            std::uint64_t evictions = 0;
+
+            void trim();
+        };
+
+        std::array<Shard, kShards> shards_;
+        std::atomic<bool> enabled_{false};
+
+        Shard& shardFor(std::string_view key);
+    };
+
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <date/tz.h>
+#include "fuzzy.hpp"
+#include "geo_index.hpp"
+#include "location.hpp"
+#include "zones.hpp"
+
+namespace timelib {
+
+    // everything a lookup reads: the tzdb, the alias tables, the fuzzy options and the coordinate
+    // index, if one is loaded. a snapshot is
+    // never changed once it's published, edits copy it into a new one that replaces it (see
+    // ZoneResolver), so readers can use it from any thread without taking a lock. the only
+    // mutable parts are the memo of resolved names and the lazily built fuzzy matcher, and
+    // both are safe to fill concurrently.
+    class LookupSnapshot {
+    public:
+        // memoized names per snapshot, see NameCache
+        static constexpr std::size_t kMaxCachedNames = 4096;
+
+        // db may be null when no tzdb could be loaded, get_tzdb() is tried again on every lookup
+        // then. `fuzzy` hands over an already built matcher over the same tzdb
+        LookupSnapshot(const date::tzdb* db, LocationMap locations, TimezoneMap timezones, const FuzzyOptions& fuzzy_options,
+                       std::shared_ptr<const FuzzyMatcher> fuzzy = nullptr, std::shared_ptr<const GeoIndex> geo = nullptr);
+        ~LookupSnapshot();
+
+        LookupSnapshot(const LookupSnapshot&) = delete;
+        LookupSnapshot& operator=(const LookupSnapshot&) = delete;
+
+        // unique across every snapshot in the process, newer ones have larger numbers
+        std::uint64_t generation() const { return generation_; }
+
+        const date::tzdb* tzdb() const { return db_; }
+        const LocationMap& locations() const { return locations_; }
+        const TimezoneMap& timezones() const { return timezones_; }
+        const FuzzyOptions& fuzzyOptions() const { return fuzzy_options_; }
+        // null when no coordinate index is loaded
+        const std::shared_ptr<const GeoIndex>& geoIndex() const { return geo_; }
+
+        // exact tzdb lookup (zones, then links), nullptr when the name doesn't exist
+        const date::time_zone* findZone(std::string_view name) const;
+        static const date::time_zone* findZone(const date::tzdb& db, std::string_view name);
+
+        // built the first time it's needed
+        const FuzzyMatcher& fuzzyMatcher() const;
+        // the matcher if some reader already built it, for handing on to the next snapshot
+        std::shared_ptr<const FuzzyMatcher> builtFuzzyMatcher() const;
+
+        // memo of names resolved against this snapshot. nullptr when the name isn't in it
+        const date::time_zone* cached(std::string_view name) const;
+        void remember(std::string_view name, const date::time_zone* zone) const;
+
+    private:
+        struct CachedName {
+            std::string name;
+            const date::time_zone* zone;
+        };
+
+        // insert-only open addressing table. a slot goes from empty to its final entry with one
+        // compare-exchange and never changes again, so finds are plain atomic loads. the table is
+        // allocated by the first remember(), a snapshot that is replaced before anyone resolves a
+        // name against it (addLocation in a loop) never pays for one
+        static constexpr std::size_t kCacheSlots = kMaxCachedNames * 2;
+        using CacheSlot = std::atomic<const CachedName*>;
+
+        const std::uint64_t generation_;
+        const date::tzdb* db_;
+        const LocationMap locations_;
+        const TimezoneMap timezones_;
+        const FuzzyOptions fuzzy_options_;
+        const std::shared_ptr<const GeoIndex> geo_;
+
+        mutable std::once_flag fuzzy_once_;
+        mutable std::shared_ptr<const FuzzyMatcher> fuzzy_owner_;
+        mutable std::atomic<const FuzzyMatcher*> fuzzy_{nullptr};
+
+        mutable std::atomic<CacheSlot*> cache_{nullptr};
+        mutable std::atomic<std::size_t> cache_size_{0};
+    };
+
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <istream>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <date/tz.h>
+
+namespace timelib {
+
+    class ThreadPool;
+
+    struct StreamConvertOptions {
+        // zone of timestamps that don't carry an offset of their own. without one such lines are
+        // passed through unchanged
+        const date::time_zone* source = nullptr;
+        const date::time_zone* target = nullptr;
+        // with no delimiter the first timestamp anywhere in the line is converted, otherwise the
+        // one at the start of field `field` (0-based). a quote or bracket opening the field is skipped
+        char delimiter = '\0';
+        std::size_t field = 0;
+        // roughly how much input one task converts, cut at the next line end
+        std::size_t block_size = std::size_t{1} << 20;
+    };
+
+    struct StreamConvertStats {
+        std::size_t lines = 0;
+        // lines whose timestamp was rewritten
+        std::size_t converted = 0;
+        std::size_t bytes_in = 0;
+        std::size_t bytes_out = 0;
+    };
+
+    // rewrites the timestamp column of logs and csv files from one zone to another and leaves the
+    // rest of every line as it was. two shapes are recognized:
+    //
+    //   iso 8601:           2024-03-10T01:30:00[.123][Z|+01:00|+0100|+01], 'T' or a space between
+    //   common log format:  10/Oct/2000:13:55:36 -0700
+    //
+    // a timestamp with an offset is moved to the target zone and written with the target's offset,
+    // one without is taken as source wall time and written as target wall time. candidates are
+    // checked eight bytes at a time, offsets come from the zone's compiled table and the interval
+    // found last is reused, so a log in time order mostly skips the lookup. input is cut into
+    // blocks at line ends that are converted on a thread pool and handed to the sink in order.
+    class StreamConverter {
+    public:
+        using Sink = std::function<void(std::string_view)>;
+
+        explicit StreamConverter(const StreamConvertOptions& options);
+
+        const StreamConvertOptions& options() const { return options_; }
+
+        // single threaded, appends the converted text to `out`
+        StreamConvertStats convert(std::string_view text, std::string& out) const;
+        // a whole buffer, typically a mapped file. a last line without a newline is converted too.
+        // each block goes to the sink as soon as it and the ones before it are done, so the sink
+        // is called from the pool's threads, one call at a time
+        StreamConvertStats convert(std::string_view text, const Sink& sink, ThreadPool& pool) const;
+        // reads the stream in large blocks until it ends. nullopt when a read fails (badbit), what
+        // was converted up to then has been handed to the sink
+        std::optional<StreamConvertStats> convert(std::istream& in, const Sink& sink, ThreadPool& pool) const;
+        // maps the file where mmap is available and reads it otherwise, nullopt when it can't be
+        // opened or reading it fails
+        std::optional<StreamConvertStats> convertFile(const std::string& path, const Sink& sink, ThreadPool& pool) const;
+
+    private:
+        StreamConvertOptions options_;
+    };
+
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <optional>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace timelib {
+
+    // append-only interned strings behind 32-bit ids. equal strings share an id, so a zone name
+    // used by a hundred locations is stored once. the text lives in fixed size chunks that never
+    // move, views handed out stay valid for as long as the pool does.
+    class StringPool {
+    public:
+        using Id = std::uint32_t;
+        // the empty string, never stored
+        static constexpr Id kEmpty = 0;
+
+        StringPool() = default;
+
+        StringPool(const StringPool& other) {
+            for (const auto text : other.views_) intern(text);
+        }
+
+        StringPool(StringPool&& other) noexcept
+            : chunks_(std::move(other.chunks_)),
+              cursor_(std::exchange(other.cursor_, nullptr)),
+              left_(std::exchange(other.left_, 0)),
+              views_(std::move(other.views_)),
+              ids_(std::move(other.ids_)) {
+            other.chunks_.clear();
+            other.views_.clear();
+            other.ids_.clear();
+        }
+
+        StringPool& operator=(StringPool other) noexcept {
+            std::swap(chunks_, other.chunks_);
+            std::swap(cursor_, other.cursor_);
+            std::swap(left_, other.left_);
+            std::swap(views_, other.views_);
+            std::swap(ids_, other.ids_);
+            return *this;
+        }
+
+        Id intern(const std::string_view text) {
+            if (text.empty()) return kEmpty;
+            if (const auto it = ids_.find(text); it != ids_.end()) return it->second;
+
+            const std::string_view stored = store(text);
+            views_.push_back(stored);
+            const auto id = static_cast<Id>(views_.size());
+            ids_.emplace(stored, id);
+            return id;
+        }
+
+        std::optional<Id> find(const std::string_view text) const {
+            if (text.empty()) return kEmpty;
+            const auto it = ids_.find(text);
+            if (it == ids_.end()) return std::nullopt;
+            return it->second;
+        }
+
+        std::string_view view(const Id id) const { return id == kEmpty ? std::string_view() : views_[id - 1]; }
+        // distinct non-empty strings
+        std::size_t size() const { return views_.size(); }
+
+    private:
+        static constexpr std::size_t kChunkSize = 4096;
+
+        std::vector<std::unique_ptr<char[]>> chunks_;
+        // free space at the end of the chunk being filled
+        char* cursor_ = nullptr;
+        std::size_t left_ = 0;
+        // id - 1 -> text
+        std::vector<std::string_view> views_;
+        std::unordered_map<std::string_view, Id> ids_;
+
+        std::string_view store(const std::string_view text) {
+            // long strings get a chunk of their own so the open one isn't wasted
+            if (text.size() > kChunkSize / 4) {
+                char* dest = chunks_.emplace_back(std::make_unique<char[]>(text.size())).get();
+                std::memcpy(dest, text.data(), text.size());
+                return {dest, text.size()};
+            }
+
+            if (text.size() > left_) {
+                cursor_ = chunks_.emplace_back(std::make_unique<char[]>(kChunkSize)).get();
+                left_ = kChunkSize;
+            }
+            char* dest = cursor_;
+            std::memcpy(dest, text.data(), text.size());
+            cursor_ += text.size();
+            left_ -= text.size();
+            return {dest, text.size()};
+        }
+    };
+
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace timelib {
+
+    // fixed set of worker threads for batch work. a parallelFor splits the index range into chunks
+    // dealt round robin onto per-worker deques. each worker drains its own deque from the back and
+    // steals from the front of the others once it runs dry, so uneven chunks still balance out.
+    class ThreadPool {
+    public:
+        // 0 means one thread per core. the thread calling parallelFor always helps, so a pool of
+        // n threads runs n + 1 chunks at a time
+        explicit ThreadPool(std::size_t threads = 0);
+        ~ThreadPool();
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        std::size_t size() const { return workers_.size(); }
+
+        // calls body(first, last) over chunks of at most `grain` indices covering [0, count) and
+        // returns once all of them ran. the first exception a chunk throws is rethrown here.
+        // calls from several threads are run one after another
+        void parallelFor(std::size_t count, std::size_t grain, const std::function<void(std::size_t, std::size_t)>& body);
+
+    private:
+        using Range = std::pair<std::size_t, std::size_t>;
+
+        struct Queue {
+            std::mutex mutex;
+            std::deque<Range> ranges;
+        };
+
+        std::vector<std::thread> workers_;
+        // one per worker plus one for the calling thread
+        std::vector<std::unique_ptr<Queue>> queues_;
+
+        std::mutex batch_mutex_;
+        std::mutex mutex_;
+        std::condition_variable wake_;
+        std::condition_variable done_;
+        std::size_t generation_ = 0;
+        bool stopping_ = false;
+
+        const std::function<void(std::size_t, std::size_t)>* body_ = nullptr;
+        std::atomic<std::size_t> pending_{0};
+        std::exception_ptr error_;
+
+        void workerLoop(std::size_t index);
+        void drain(std::size_t index);
+        bool take(std::size_t index, Range& range);
+    };
+
+}
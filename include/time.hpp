@@ -1,20 +1,50 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <optional>
 #include <chrono>
-#include <regex>
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <vector>
 #include <date/date.h>
 #include <date/tz.h>
+#include "clock.hpp"
+#include "compiled_zone.hpp"
+#include "format.hpp"
+#include "fuzzy.hpp"
+#include "geo_index.hpp"
+#include "meeting.hpp"
+#include "offset_matrix.hpp"
+#include "recurrence.hpp"
+#include "world_clock.hpp"
 
 namespace timelib {
+    class ResultCache;
+    class ThreadPool;
+    class ZoneResolver;
+
     enum class QueryType {
         Conversion,
         CurrentTime,
         Difference,
+        Meeting,
         Invalid
     };
 
+    // the days a meeting query looks at, counted in the first location's days from its today
+    enum class MeetingSpan {
+        Today,
+        Tomorrow,
+        // today and the six days after it
+        Week,
+        // today up to sunday
+        ThisWeek,
+        // next monday to sunday
+        NextWeek
+    };
+
     enum class ErrorCode {
         Success = 0,
         InvalidQuery,
@@ -31,38 +61,217 @@ namespace timelib {
         std::string location_a;
         std::optional<std::string> location_b;
         bool is_valid = false;
+        // Meeting only: every location named (location_a / location_b are the first two), the
+        // working hours hour:minute to end_hour:end_minute and the days to search
+        std::vector<std::string> locations;
+        int end_hour = -1;
+        int end_minute = -1;
+        MeetingSpan span = MeetingSpan::Week;
+        // ids (see ZoneTables::zoneId) of the zones for location_a / location_b once
+        // TimeConverter::resolve has run. evaluating a resolved query skips the name lookups,
+        // kNoZone means not resolved (or unknown)
+        std::uint32_t zone_a = ZoneTables::kNoZone;
+        std::uint32_t zone_b = ZoneTables::kNoZone;
     };
 
     struct QueryResult {
+        // the rendered sentence. processQuery fills it, evaluate leaves it empty
         std::string result;
         ErrorCode code = ErrorCode::Success;
         std::string error_message;
+
+        // the answer itself, set whenever code is Success. `time` is the instant the query is
+        // about (the converted time, or now), source is location_a and target location_b. for
+        // CurrentTime there is no target. a Meeting has the start of the first day searched (the
+        // first location's midnight) as time and the overlapping working hours in windows
+        QueryType type = QueryType::Invalid;
+        date::sys_seconds time{};
+        const date::time_zone* source_zone = nullptr;
+        const date::time_zone* target_zone = nullptr;
+        ZoneOffset source_offset;
+        ZoneOffset target_offset;
+        // source_offset - target_offset, positive when the source is ahead
+        std::chrono::seconds offset_delta{0};
+        std::vector<TimeInterval> windows;
+
+        bool ok() const { return code == ErrorCode::Success; }
+        date::local_seconds sourceLocalTime() const { return date::local_seconds{time.time_since_epoch() + source_offset.offset}; }
+        date::local_seconds targetLocalTime() const { return date::local_seconds{time.time_since_epoch() + target_offset.offset}; }
+    };
+
+    // a parsed query together with its processed result, what processInput hands back
+    struct QueryAnswer {
+        ParsedQuery query;
+        QueryResult result;
+    };
+
+    struct ResultCacheStats;
+
+    struct WarmupOptions {
+        // offset tables (see ZoneTables) for every zone in the tzdb, not just the ones built-in
+        // names point at
+        bool all_zones = false;
+        // the typo tolerant matcher, which indexes every zone name
+        bool fuzzy = true;
+        // the prefix index IncrementalParser completes locations from
+        bool completion = true;
+    };
+
+    // what TimeConverter::warmup did and how long each part took
+    struct WarmupReport {
+        bool tzdb_loaded = false;
+        std::size_t zones_compiled = 0;
+        std::chrono::microseconds tzdb{0};
+        std::chrono::microseconds fuzzy{0};
+        std::chrono::microseconds completion{0};
+        std::chrono::microseconds tables{0};
+        // from the call until everything was ready
+        std::chrono::microseconds total{0};
     };
 
     class TimeConverter {
     public:
-        TimeConverter();
-        ParsedQuery parseInput(const std::string& input) const;
+        TimeConverter() = default;
+        ParsedQuery parseInput(std::string_view input) const;
+
+        // batch versions of parseInput / processQuery, results come back in input order. the work
+        // is split over a thread pool (one thread per core unless a pool is passed in), every
+        // distinct location in the batch is resolved once and "now" is read once for the whole
+        // batch. with render_text off only the typed fields are filled, like evaluate
+        std::vector<ParsedQuery> parseBatch(const std::vector<std::string_view>& inputs) const;
+        std::vector<ParsedQuery> parseBatch(const std::vector<std::string_view>& inputs, ThreadPool& pool) const;
+        std::vector<ParsedQuery> parseBatch(const std::vector<std::string>& inputs) const;
+        static std::vector<QueryResult> processBatch(const std::vector<ParsedQuery>& queries, bool render_text = true);
+        static std::vector<QueryResult> processBatch(const std::vector<ParsedQuery>& queries, ThreadPool& pool,
+                                                     bool render_text = true);
+        // the same, answered as of `as_of` instead of the clock's now
+        static std::vector<QueryResult> processBatch(const std::vector<ParsedQuery>& queries, date::sys_seconds as_of,
+                                                     bool render_text = true);
+        static std::vector<QueryResult> processBatch(const std::vector<ParsedQuery>& queries, ThreadPool& pool,
+                                                     date::sys_seconds as_of, bool render_text = true);
         static QueryResult processQuery(const ParsedQuery& query);
+        static QueryResult processQuery(const ParsedQuery& query, date::sys_seconds as_of);
+        // looks the query's locations up once and keeps the zones in it, so a query that is
+        // evaluated many times doesn't resolve its names every time. false when one is unknown
+        static bool resolve(ParsedQuery& query);
+        // the typed answer only, no text is built (error messages aside). render it later if a
+        // sentence is needed after all
+        static QueryResult evaluate(const ParsedQuery& query);
+        static QueryResult evaluate(const ParsedQuery& query, date::sys_seconds as_of);
+        // renders the answer (or the error message) into `out`, reusing its capacity. once the
+        // zones involved have been resolved before, a query allocates nothing
+        static ErrorCode processQuery(const ParsedQuery& query, std::string& out);
+
+        // parseInput and processQuery in one call. repeated inputs are answered from the result
+        // cache while it's on and the answer hasn't gone stale
+        static std::shared_ptr<const QueryAnswer> processInput(std::string_view input);
+        // sizes the cache processInput uses (see ResultCache), 0 turns it off. off by default
+        static void setResultCacheCapacity(std::size_t capacity);
+        static ResultCacheStats resultCacheStats();
+
+        // one instant in many places at once, see WorldClock. the locations are resolved here,
+        // once, against the converter's lookup data
+        static WorldClock worldClock(const std::vector<std::string>& locations);
+        // the offset difference between every pair of locations over a range of time, and the
+        // instants where any of them changes, see OffsetMatrix
+        static OffsetMatrix offsetMatrix(const std::vector<std::string>& locations, date::sys_seconds begin,
+                                         date::sys_seconds end);
+
+        // when everyone is inside their working hours between begin and end, see MeetingPlanner
+        static MeetingWindows meetingWindows(const std::vector<WorkingHours>& participants, date::sys_seconds begin,
+                                             date::sys_seconds end, std::chrono::minutes min_length = std::chrono::minutes{0});
+
+        // where "now" comes from for every query that isn't given an instant, see Clock. null goes
+        // back to the system clock. cached answers are dropped, they were right for the old clock,
+        // and the old clock itself is let go of once no query is reading it any more
+        static void setClock(std::shared_ptr<const Clock> clock);
+        // one reading of the current clock
+        static date::sys_seconds now();
+
+        // the occurrences of a repeating wall clock time in a location ("every weekday at 09:30 in
+        // new york") from `start` on, generated as they're iterated, see Recurrence. an unknown
+        // location has none, zone() is null then
+        static Recurrence recurrence(std::string_view location, date::local_days start, const RecurrenceRule& rule);
+
+        // loads the tzdb and builds the lookup tables on a background thread, so the first query
+        // doesn't pay for them. queries can be issued meanwhile: each one only waits for the part
+        // it needs (the tzdb, one zone's tables, the fuzzy matcher) and never for the rest. later
+        // calls hand back the first call's future. a program that exits while it runs waits for it
+        static std::shared_future<WarmupReport> warmup(const WarmupOptions& options = {});
+        // true once a warmup has finished, for callers that would rather not wait at all. nothing
+        // else sets it, so it stays false in a program that never calls warmup()
+        static bool ready();
+
+        // a compiled gazetteer (see Gazetteer and timelib_gazcompile) for place names beyond the
+        // built-in ones, "zurich" is fine without it but "winterthur" needs it. false when the
+        // file can't be used, the previous one stays then
+        static bool loadGazetteer(const std::string& path);
+
+        // timezone by coordinates from a compiled boundary index (see GeoIndex and
+        // timelib_geocompile). once one is loaded, locations like "35.68,139.69" resolve in queries
+        // too. false when the file can't be used, the previous index stays then
+        static bool loadGeoIndex(const std::string& path);
+        // nullptr without an index, or where it has no zone
+        static const date::time_zone* timezoneAt(double latitude, double longitude);
+        // large arrays are split over the batch thread pool
+        static std::vector<const date::time_zone*> timezonesAt(const std::vector<Coordinate>& coordinates);
+
+        // how forgiving location lookups are about typos, see FuzzyOptions
+        static void setFuzzyOptions(const FuzzyOptions& options);
+
+        // runtime additions to the location table and a tzdata reload. both are safe to call
+        // while other threads are querying, queries already running finish on the old data
+        static void addLocation(const std::string& name, const std::string& timezone,
+                                const std::vector<std::string>& aliases = {});
+        static bool reload();
+
+        // the sentence processQuery would have produced for an evaluated result, written into any
+        // output iterator. `query` has to be the one the result was evaluated from
+        template <class Out>
+        static Out render(Out out, const QueryResult& result, const ParsedQuery& query) {
+            if (!result.ok()) return detail::write(out, result.error_message);
+            switch (result.type) {
+                case QueryType::CurrentTime:
+                    return TimeFormatter::currentTime(out, query.location_a, result.time, result.source_offset);
+                case QueryType::Conversion:
+                    return TimeFormatter::conversion(out, query.location_a, query.location_b.value_or(""), result.time,
+                                                     result.source_offset, result.target_offset);
+                case QueryType::Difference:
+                    return TimeFormatter::difference(out, query.location_a, query.location_b.value_or(""),
+                                                     result.source_offset, result.target_offset);
+                case QueryType::Meeting:
+                    return TimeFormatter::meeting(out, query.locations, query.hour, query.minute, query.end_hour, query.end_minute,
+                                                  result.windows);
+                case QueryType::Invalid:
+                default:
+                    return out;
+            }
+        }
+        static std::string render(const QueryResult& result, const ParsedQuery& query);
 
     private:
-        std::regex conversion_pattern_;
-        std::regex query_pattern_;
-        std::regex difference_pattern_;
-        std::regex implicit_conversion_pattern_;
-
-        static QueryResult getCurrentTimeIn(const std::string& location);
-        static QueryResult convertTime(const ParsedQuery& query);
-        static QueryResult calculateTimeDifference(const ParsedQuery& query);
-        static std::string formatTime(const date::zoned_time<std::chrono::seconds>& zt);
-        static void parseTimeString(const std::string& time_str, ParsedQuery& result);
-        static std::optional<std::string> resolveTimezone(const std::string& location_or_zone);
-        static date::year_month_day getCurrentDate();
-
-        static bool isValidTime(int hour, int minute);
-        static std::optional<int> parseHour(const std::string& hour_str);
-        static std::optional<int> parseMinute(const std::string& minute_str);
-        static std::string normalizeLocation(const std::string& location);
+        // queries per chunk handed to a pool thread
+        static constexpr std::size_t kBatchGrain = 64;
+        // coordinates per chunk, a lookup is a lot cheaper than a query
+        static constexpr std::size_t kCoordinateGrain = 16384;
+
+        static QueryResult evaluate(const ParsedQuery& query, date::sys_seconds now,
+                                    const date::time_zone* zone_a, const date::time_zone* zone_b);
+        static QueryResult getCurrentTimeIn(const std::string& location, const date::time_zone* zone, date::sys_seconds now);
+        static QueryResult convertTime(const ParsedQuery& query, const date::time_zone* source_zone,
+                                       const date::time_zone* target_zone, date::sys_seconds now);
+        static QueryResult calculateTimeDifference(const ParsedQuery& query, const date::time_zone* zone_a,
+                                                   const date::time_zone* zone_b, date::sys_seconds now);
+        static QueryResult findMeetingWindows(const ParsedQuery& query, const date::time_zone* first_zone, date::sys_seconds now);
+        static const date::time_zone* resolveTimezone(std::string_view location_or_zone);
+        struct WarmupState;
+        struct ClockState;
+
+        static ZoneResolver& resolver();
+        static WarmupState& warmupState();
+        static ClockState& clockState();
+        static ThreadPool& batchPool();
+        static ResultCache& resultCache();
     };
 
 }
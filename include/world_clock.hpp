@@ -0,0 +1,72 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <date/date.h>
+#include <date/tz.h>
+#include "clock.hpp"
+#include "compiled_zone.hpp"
+
+namespace timelib {
+
+    class ZoneResolver;
+
+    // one instant seen from every target of a WorldClock, in target order. parallel arrays so a
+    // dashboard can hand them straight to whatever draws the table
+    struct WorldClockReadings {
+        date::sys_seconds instant{};
+        // local seconds since the epoch
+        std::vector<std::int64_t> local_times;
+        std::vector<std::int32_t> offsets;
+        // CompiledZone abbreviation ids
+        std::vector<std::uint16_t> abbrevs;
+
+        std::size_t size() const { return local_times.size(); }
+        date::local_seconds localTime(const std::size_t i) const { return date::local_seconds{std::chrono::seconds{local_times[i]}}; }
+        std::chrono::seconds offset(const std::size_t i) const { return std::chrono::seconds{offsets[i]}; }
+        std::string_view abbrev(const std::size_t i) const { return CompiledZone::abbrev(abbrevs[i]); }
+    };
+
+    // a fixed list of target locations, resolved once, that instants are fanned out to. every
+    // target keeps the offset interval around the time the clock was built in flat arrays, so a
+    // reading for any instant inside those intervals (months, usually) is a compare and a copy per
+    // target in a loop the compiler vectorizes. targets whose interval doesn't cover the instant
+    // fall back to their compiled zone table.
+    class WorldClock {
+    public:
+        // locations can be anything ZoneResolver understands. ones that don't resolve are left
+        // out of the targets and listed in missing(). the intervals are taken around `around`, or
+        // around what `clock` reads
+        WorldClock(const ZoneResolver& resolver, const std::vector<std::string>& locations, const Clock& clock);
+        WorldClock(const ZoneResolver& resolver, const std::vector<std::string>& locations, date::sys_seconds around);
+
+        std::size_t size() const { return zones_.size(); }
+        const std::vector<std::string>& names() const { return names_; }
+        const std::vector<const date::time_zone*>& zones() const { return zones_; }
+        const std::vector<std::string>& missing() const { return missing_; }
+
+        // reuses the capacity of `out`
+        void at(date::sys_seconds instant, WorldClockReadings& out) const;
+        WorldClockReadings at(date::sys_seconds instant) const;
+        // a wall clock time in `source`, with zoned_time's choose::earliest semantics
+        WorldClockReadings at(const date::time_zone* source, date::local_seconds local) const;
+        // the instant `clock` reads, e.g. a SystemClock. TimeConverter::now() is the converter's
+        WorldClockReadings now(const Clock& clock) const;
+
+    private:
+        std::vector<std::string> names_;
+        std::vector<const date::time_zone*> zones_;
+        std::vector<std::string> missing_;
+
+        // the cached interval per target, [window_starts_, window_ends_)
+        std::vector<std::int64_t> window_starts_;
+        std::vector<std::int64_t> window_ends_;
+        std::vector<std::int32_t> window_offsets_;
+        std::vector<std::uint16_t> window_abbrevs_;
+    };
+
+}
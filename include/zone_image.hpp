@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <date/date.h>
+#include <date/tz.h>
+#include "compiled_zone.hpp"
+#include "mapped_file.hpp"
+
+namespace timelib {
+
+    // on-disk layout of a compiled zone image, as written by timelib_tzcompile. sections follow
+    // the header in this order: zone entries (sorted by name), abbreviations, interval starts,
+    // interval offsets, interval abbreviation ids, then the string blob (see mapped_file.hpp for
+    // alignment and byte order).
+    namespace image {
+        constexpr char kMagic[4] = {'T', 'L', 'Z', 'I'};
+        constexpr std::uint32_t kVersion = 2;
+        // room for the tzdata release ("2024a"), zero padded
+        constexpr std::size_t kTzdataSize = 16;
+
+        struct Header {
+            char magic[4];
+            std::uint32_t version;
+            char tzdata[kTzdataSize];
+            std::int32_t first_year;
+            std::int32_t last_year;
+            std::uint32_t zone_count;
+            std::uint32_t abbrev_count;
+            std::uint32_t interval_count;
+            std::uint32_t strings_size;
+        };
+
+        struct StringRef {
+            std::uint32_t offset;
+            std::uint32_t size;
+        };
+
+        struct ZoneEntry {
+            StringRef name;
+            std::uint32_t first_interval;
+            std::uint32_t interval_count;
+        };
+    }
+
+    // a read-only compiled zone image. the file is mapped (or read, where mmap isn't available)
+    // once and zones are copied out of it the first time they're used, so loading it costs a
+    // header check and nothing touches the text tzdb for offset lookups.
+    class ZoneImage {
+    public:
+        // nullptr when the file is missing, truncated or from another format version. the tzdata
+        // release isn't checked here, see ZoneTables::loadImage
+        static std::unique_ptr<const ZoneImage> open(const std::string& path);
+
+        // compiles every zone in the loaded tzdb for [first, last) years, and records its release.
+        // returns the number of zones written, 0 on failure
+        static std::size_t write(const std::string& path, date::year first, date::year last);
+
+        ZoneImage(const ZoneImage&) = delete;
+        ZoneImage& operator=(const ZoneImage&) = delete;
+
+        date::year firstYear() const { return date::year{header().first_year}; }
+        date::year lastYear() const { return date::year{header().last_year}; }
+        std::size_t size() const { return header().zone_count; }
+        // the tzdata release the image was compiled from, its offsets are only right for that one
+        std::string_view tzdataVersion() const;
+
+        // nullptr when the zone isn't in the image
+        std::unique_ptr<const CompiledZone> compile(const date::time_zone* zone) const;
+
+    private:
+        ZoneImage() = default;
+
+        detail::MappedFile file_;
+
+        const image::ZoneEntry* zones_ = nullptr;
+        const image::StringRef* abbrevs_ = nullptr;
+        const std::int64_t* starts_ = nullptr;
+        const std::int32_t* offsets_ = nullptr;
+        const std::uint16_t* abbrev_ids_ = nullptr;
+        const char* strings_ = nullptr;
+
+        const image::Header& header() const { return *reinterpret_cast<const image::Header*>(file_.data()); }
+        std::string_view string(image::StringRef ref) const { return {strings_ + ref.offset, ref.size}; }
+        bool validate();
+    };
+
+}
@@ -1,10 +1,17 @@
 // NOTE: a majority of this file was "generated" using AI tools (specifically, using Gemini 2.5 Pro).
 #pragma once
 
-#include <unordered_map>
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <iterator>
+#include <optional>
 #include <string>
+#include <string_view>
+#include <utility>
 #include <vector>
-#include <algorithm>
+#include "alias_table.hpp"
+#include "string_pool.hpp"
 
 namespace timelib {
 
@@ -14,54 +21,188 @@ namespace timelib {
         std::string description;
     };
 
-    class TimezoneMap {
-    public:
-        TimezoneMap() {
-            initializeTimezones();
-        }
+    struct BuiltinTimezone {
+        std::string_view official_name;
+        std::string_view aliases;
+        std::string_view description;
+    };
 
-        std::string getOfficialName(const std::string& alias) const {
-            std::string lower_alias = alias;
-            std::transform(lower_alias.begin(), lower_alias.end(), lower_alias.begin(), ::tolower);
+    namespace detail {
 
-            if (const auto it = alias_to_official_.find(lower_alias); it != alias_to_official_.end()) {
-                return it->second;
-            }
-            return alias;
+        inline constexpr BuiltinTimezone kBuiltinTimezones[] = {
+            // the only reasonable timezone
+            {"UTC", "utc|gmt|zulu|z|coordinated universal time", "Coordinated Universal Time"},
+
+            // us timezones
+            {"America/New_York", "est|edt|eastern|et|eastern time", "Eastern Time (US)"},
+            {"America/Chicago", "cst|cdt|central|ct|central time", "Central Time (US)"},
+            {"America/Denver", "mst|mdt|mountain|mt|mountain time", "Mountain Time (US)"},
+            {"America/Los_Angeles", "pst|pdt|pacific|pt|pacific time", "Pacific Time (US)"},
+            {"America/Phoenix", "mst|arizona time", "Mountain Standard Time (Arizona, no DST)"},
+            {"America/Anchorage", "akst|akdt|alaska|alaska time", "Alaska Time"},
+            {"Pacific/Honolulu", "hst|hast|hawaii", "Hawaii-Aleutian Standard Time"},
+
+            // eu timezone
+            {"Europe/London", "bst|gmt|wet|western european time", "Western European Time"},
+            {"Europe/Paris", "cet|cest|central european time", "Central European Time"},
+            {"Europe/Helsinki", "eet|eest|eastern european time", "Eastern European Time"},
+            {"Europe/Moscow", "msk|moscow time", "Moscow Time"},
+
+            // asian timezones
+            {"Asia/Kolkata", "ist|india standard time", "India Standard Time"},
+            {"Asia/Shanghai", "cst|china standard time", "China Standard Time"},
+            {"Asia/Tokyo", "jst|japan standard time", "Japan Standard Time"},
+            {"Asia/Dubai", "gst|gulf standard time", "Gulf Standard Time"},
+            {"Asia/Seoul", "kst|korea standard time", "Korea Standard Time"},
+            {"Asia/Singapore", "sgt|singapore time", "Singapore Time"},
+
+            // oceanic timezones
+            {"Australia/Sydney", "aest|aedt|australian eastern time", "Australian Eastern Time (Sydney, Melbourne)"},
+            {"Australia/Brisbane", "aest|brisbane time", "Australian Eastern Standard Time (Brisbane)"},
+            {"Australia/Adelaide", "acst|acdt|australian central time", "Australian Central Time (Adelaide)"},
+            {"Australia/Darwin", "acst|darwin time", "Australian Central Standard Time (Darwin)"},
+            {"Australia/Perth", "awst|australian western time", "Australian Western Standard Time (Perth)"},
+
+            // south american timezones
+            {"America/Sao_Paulo", "brt|brst|brasilia time", "Brasilia Time"},
+            {"America/Argentina/Buenos_Aires", "art|argentina time", "Argentina Time"},
+
+            // military timezones
+            {"Etc/GMT-1", "a|alpha", "Alpha Time Zone (UTC+1)"},
+            {"Etc/GMT-2", "b|bravo", "Bravo Time Zone (UTC+2)"},
+            {"Etc/GMT-3", "c|charlie", "Charlie Time Zone (UTC+3)"},
+            {"Etc/GMT-4", "d|delta", "Delta Time Zone (UTC+4)"},
+            {"Etc/GMT-5", "e|echo", "Echo Time Zone (UTC+5)"},
+            {"Etc/GMT-6", "f|foxtrot", "Foxtrot Time Zone (UTC+6)"},
+            {"Etc/GMT-7", "g|golf", "Golf Time Zone (UTC+7)"},
+            {"Etc/GMT-8", "h|hotel", "Hotel Time Zone (UTC+8)"},
+            {"Etc/GMT-9", "i|india", "India Time Zone (UTC+9)"},
+            {"Etc/GMT-10", "k|kilo", "Kilo Time Zone (UTC+10)"},
+            {"Etc/GMT-11", "l|lima", "Lima Time Zone (UTC+11)"},
+            {"Etc/GMT-12", "m|mike", "Mike Time Zone (UTC+12)"},
+            {"Etc/GMT+1", "n|november", "November Time Zone (UTC-1)"},
+            {"Etc/GMT+2", "o|oscar", "Oscar Time Zone (UTC-2)"},
+            {"Etc/GMT+3", "p|papa", "Papa Time Zone (UTC-3)"},
+            {"Etc/GMT+4", "q|quebec", "Quebec Time Zone (UTC-4)"},
+            {"Etc/GMT+5", "r|romeo", "Romeo Time Zone (UTC-5)"},
+            {"Etc/GMT+6", "s|sierra", "Sierra Time Zone (UTC-6)"},
+            {"Etc/GMT+7", "t|tango", "Tango Time Zone (UTC-7)"},
+            {"Etc/GMT+8", "u|uniform", "Uniform Time Zone (UTC-8)"},
+            {"Etc/GMT+9", "v|victor", "Victor Time Zone (UTC-9)"},
+            {"Etc/GMT+10", "w|whiskey", "Whiskey Time Zone (UTC-10)"},
+            {"Etc/GMT+11", "x|x-ray", "X-ray Time Zone (UTC-11)"},
+            {"Etc/GMT+12", "y|yankee", "Yankee Time Zone (UTC-12)"},
+
+            // etc
+            {"Etc/GMT+12", "utc-12", "UTC-12:00"},
+            {"Etc/GMT+11", "utc-11", "UTC-11:00"},
+            {"Etc/GMT+10", "utc-10", "UTC-10:00"},
+            {"Etc/GMT+9", "utc-9", "UTC-09:00"},
+            {"Etc/GMT+8", "utc-8", "UTC-08:00"},
+            {"Etc/GMT+7", "utc-7", "UTC-07:00"},
+            {"Etc/GMT+6", "utc-6", "UTC-06:00"},
+            {"Etc/GMT+5", "utc-5", "UTC-05:00"},
+            {"Etc/GMT+4", "utc-4", "UTC-04:00"},
+            {"Etc/GMT+3", "utc-3", "UTC-03:00"},
+            {"Etc/GMT+2", "utc-2", "UTC-02:00"},
+            {"Etc/GMT+1", "utc-1", "UTC-01:00"},
+            {"Etc/GMT-1", "utc+1", "UTC+01:00"},
+            {"Etc/GMT-2", "utc+2", "UTC+02:00"},
+            {"Etc/GMT-3", "utc+3", "UTC+03:00"},
+            {"Etc/GMT-4", "utc+4", "UTC+04:00"},
+            {"Etc/GMT-5", "utc+5", "UTC+05:00"},
+            {"Etc/GMT-6", "utc+6", "UTC+06:00"},
+            {"Etc/GMT-7", "utc+7", "UTC+07:00"},
+            {"Etc/GMT-8", "utc+8", "UTC+08:00"},
+            {"Etc/GMT-9", "utc+9", "UTC+09:00"},
+            {"Etc/GMT-10", "utc+10", "UTC+10:00"},
+            {"Etc/GMT-11", "utc+11", "UTC+11:00"},
+            {"Etc/GMT-12", "utc+12", "UTC+12:00"},
+            {"Etc/GMT-13", "utc+13", "UTC+13:00"},
+            {"Etc/GMT-14", "utc+14", "UTC+14:00"},
+
+        };
+
+        constexpr std::size_t builtinTimezoneKeyCount() {
+            std::size_t count = 0;
+            for (const auto& timezone : kBuiltinTimezones) count += 1 + aliasCount(timezone.aliases);
+            return count;
         }
 
-        bool hasTimezone(const std::string& name) const {
-            std::string lower_name = name;
-            std::transform(lower_name.begin(), lower_name.end(), lower_name.begin(), ::tolower);
+        // the last entry for a zone is the one whose aliases and description are reported
+        constexpr std::uint16_t lastTimezoneEntry(const std::string_view official_name) {
+            std::size_t last = 0;
+            for (std::size_t i = 0; i < std::size(kBuiltinTimezones); ++i) {
+                if (kBuiltinTimezones[i].official_name == official_name) last = i;
+            }
+            return static_cast<std::uint16_t>(last);
+        }
 
-            return alias_to_official_.find(lower_name) != alias_to_official_.end();
+        // official names always take their key, aliases only claim keys nobody has yet
+        // ("mst" stays with denver even though phoenix lists it too)
+        constexpr std::array<AliasKey, builtinTimezoneKeyCount()> builtinTimezoneKeys() {
+            std::array<AliasKey, builtinTimezoneKeyCount()> keys{};
+            std::size_t count = 0;
+            for (const auto& timezone : kBuiltinTimezones) {
+                const std::uint16_t target = lastTimezoneEntry(timezone.official_name);
+                keys[count++] = {timezone.official_name, target, true};
+                for (std::size_t a = 0; a < aliasCount(timezone.aliases); ++a) {
+                    keys[count++] = {aliasAt(timezone.aliases, a), target, false};
+                }
+            }
+            return keys;
         }
 
-        std::vector<std::string> getTimezoneAliases(const std::string& timezone) const {
-            std::string lower_timezone = timezone;
-            std::transform(lower_timezone.begin(), lower_timezone.end(), lower_timezone.begin(), ::tolower);
+        inline constexpr auto kBuiltinTimezoneKeys = builtinTimezoneKeys();
+        inline constexpr std::size_t kTimezoneAliasCount = uniqueKeyCount(kBuiltinTimezoneKeys);
+        inline constexpr AliasTable<kTimezoneAliasCount> kTimezoneAliases{
+            mergeAliasKeys<kTimezoneAliasCount>(kBuiltinTimezoneKeys)};
 
-            const auto it = alias_to_official_.find(lower_timezone);
-            const std::string official_name = (it != alias_to_official_.end()) ? it->second : timezone;
+    }
 
-            if (const auto tz_it = timezones_.find(official_name); tz_it != timezones_.end()) {
-                return tz_it->second.aliases;
-            }
+    // same layout as LocationMap: a compile time perfect hash for the built-in aliases and a
+    // pooled runtime overlay for addTimezoneAlias that is checked first.
+    class TimezoneMap {
+    public:
+        TimezoneMap() = default;
+
+        // official zone name for an alias (or for the official name in any case), empty when
+        // unknown. views stay valid for as long as the map does
+        std::string_view findOfficialName(const std::string_view alias) const {
+            const Match match = find(alias);
+            if (match.runtime != kNone) return pool_.view(names_[match.runtime]);
+            if (match.builtin) return match.builtin->official_name;
             return {};
         }
 
-        const TimezoneInfo* getTimezoneInfo(const std::string& name) const {
-            std::string lower_name = name;
-            std::transform(lower_name.begin(), lower_name.end(), lower_name.begin(), ::tolower);
+        std::string getOfficialName(const std::string_view alias) const {
+            const std::string_view official_name = findOfficialName(alias);
+            return std::string(official_name.empty() ? alias : official_name);
+        }
+
+        bool hasTimezone(const std::string_view name) const {
+            const Match match = find(name);
+            return match.runtime != kNone || match.builtin;
+        }
 
-            const auto it = alias_to_official_.find(lower_name);
-            const std::string official_name = (it != alias_to_official_.end()) ? it->second : name;
+        std::vector<std::string> getTimezoneAliases(const std::string_view timezone) const {
+            const Match match = find(timezone);
+            if (match.runtime != kNone) return runtimeAliases(match.runtime);
+            if (match.builtin) return splitAliases(match.builtin->aliases);
+            return {};
+        }
 
-            const auto tz_it = timezones_.find(official_name);
-            if (tz_it != timezones_.end()) {
-                return &tz_it->second;
+        std::optional<TimezoneInfo> getTimezoneInfo(const std::string_view name) const {
+            const Match match = find(name);
+            if (match.runtime != kNone) {
+                return TimezoneInfo{std::string(pool_.view(names_[match.runtime])), runtimeAliases(match.runtime),
+                                    std::string(pool_.view(descriptions_[match.runtime]))};
             }
-            return nullptr;
+            if (match.builtin) {
+                return TimezoneInfo{std::string(match.builtin->official_name), splitAliases(match.builtin->aliases),
+                                    std::string(match.builtin->description)};
+            }
+            return std::nullopt;
         }
 
         void addTimezoneAlias(const std::string& official_name,
@@ -70,123 +211,113 @@ namespace timelib {
         }
 
     private:
-        std::unordered_map<std::string, TimezoneInfo> timezones_;
-        std::unordered_map<std::string, std::string> alias_to_official_;
+        static constexpr std::uint32_t kNone = ~std::uint32_t{0};
 
-        void initializeTimezones() {
-            // the only reasonable timezone
-            addTimezoneInternal("UTC", {"utc", "gmt", "zulu", "z", "coordinated universal time"}, "Coordinated Universal Time");
+        struct Match {
+            // row in the runtime arrays, kNone when the built-in entry (if any) applies
+            std::uint32_t runtime = kNone;
+            const BuiltinTimezone* builtin = nullptr;
+        };
 
-            // us timezones
-            addTimezoneInternal("America/New_York", {"est", "edt", "eastern", "et", "eastern time"}, "Eastern Time (US)");
-            addTimezoneInternal("America/Chicago", {"cst", "cdt", "central", "ct", "central time"}, "Central Time (US)");
-            addTimezoneInternal("America/Denver", {"mst", "mdt", "mountain", "mt", "mountain time"}, "Mountain Time (US)");
-            addTimezoneInternal("America/Los_Angeles", {"pst", "pdt", "pacific", "pt", "pacific time"}, "Pacific Time (US)");
-            addTimezoneInternal("America/Phoenix", {"mst", "arizona time"}, "Mountain Standard Time (Arizona, no DST)");
-            addTimezoneInternal("America/Anchorage", {"akst", "akdt", "alaska", "alaska time"}, "Alaska Time");
-            addTimezoneInternal("Pacific/Honolulu", {"hst", "hast", "hawaii"}, "Hawaii-Aleutian Standard Time");
+        StringPool pool_;
+        // one row per zone given to addTimezoneAlias
+        std::vector<StringPool::Id> names_;
+        std::vector<StringPool::Id> descriptions_;
+        // [alias_starts_, alias_starts_ + alias_counts_) in alias_ids_
+        std::vector<std::uint32_t> alias_starts_;
+        std::vector<std::uint32_t> alias_counts_;
+        std::vector<StringPool::Id> alias_ids_;
+        // lowercased alias -> row, sorted by alias
+        std::vector<std::pair<StringPool::Id, std::uint32_t>> runtime_aliases_;
 
-            // eu timezone
-            addTimezoneInternal("Europe/London", {"bst", "gmt", "wet", "western european time"}, "Western European Time");
-            addTimezoneInternal("Europe/Paris", {"cet", "cest", "central european time"}, "Central European Time");
-            addTimezoneInternal("Europe/Helsinki", {"eet", "eest", "eastern european time"}, "Eastern European Time");
-            addTimezoneInternal("Europe/Moscow", {"msk", "moscow time"}, "Moscow Time");
+        Match find(const std::string_view name) const {
+            if (const std::uint32_t row = findRuntimeAlias(name); row != kNone) return {row, nullptr};
 
-            // asian timezones
-            addTimezoneInternal("Asia/Kolkata", {"ist", "india standard time"}, "India Standard Time");
-            addTimezoneInternal("Asia/Shanghai", {"cst", "china standard time"}, "China Standard Time");
-            addTimezoneInternal("Asia/Tokyo", {"jst", "japan standard time"}, "Japan Standard Time");
-            addTimezoneInternal("Asia/Dubai", {"gst", "gulf standard time"}, "Gulf Standard Time");
-            addTimezoneInternal("Asia/Seoul", {"kst", "korea standard time"}, "Korea Standard Time");
-            addTimezoneInternal("Asia/Singapore", {"sgt", "singapore time"}, "Singapore Time");
+            const int index = detail::kTimezoneAliases.find(name);
+            if (index < 0) return {};
 
-            // oceanic timezones
-            addTimezoneInternal("Australia/Sydney", {"aest", "aedt", "australian eastern time"}, "Australian Eastern Time (Sydney, Melbourne)");
-            addTimezoneInternal("Australia/Brisbane", {"aest", "brisbane time"}, "Australian Eastern Standard Time (Brisbane)");
-            addTimezoneInternal("Australia/Adelaide", {"acst", "acdt", "australian central time"}, "Australian Central Time (Adelaide)");
-            addTimezoneInternal("Australia/Darwin", {"acst", "darwin time"}, "Australian Central Standard Time (Darwin)");
-            addTimezoneInternal("Australia/Perth", {"awst", "australian western time"}, "Australian Western Standard Time (Perth)");
+            const auto& builtin = detail::kBuiltinTimezones[detail::kTimezoneAliases[index].target];
+            if (const std::uint32_t row = findRuntimeTimezone(builtin.official_name); row != kNone) return {row, nullptr};
+            return {kNone, &builtin};
+        }
 
-            // south american timezones
-            addTimezoneInternal("America/Sao_Paulo", {"brt", "brst", "brasilia time"}, "Brasilia Time");
-            addTimezoneInternal("America/Argentina/Buenos_Aires", {"art", "argentina time"}, "Argentina Time");
+        std::uint32_t findRuntimeAlias(const std::string_view alias) const {
+            if (runtime_aliases_.empty()) return kNone;
+            const auto it = std::lower_bound(runtime_aliases_.begin(), runtime_aliases_.end(), alias,
+                [this](const auto& entry, const std::string_view key) { return detail::compareIgnoreCase(pool_.view(entry.first), key) < 0; });
+            if (it == runtime_aliases_.end() || !detail::equalsIgnoreCase(pool_.view(it->first), alias)) return kNone;
+            return it->second;
+        }
 
-            // military timezones
-            addTimezoneInternal("Etc/GMT-1", {"a", "alpha"}, "Alpha Time Zone (UTC+1)");
-            addTimezoneInternal("Etc/GMT-2", {"b", "bravo"}, "Bravo Time Zone (UTC+2)");
-            addTimezoneInternal("Etc/GMT-3", {"c", "charlie"}, "Charlie Time Zone (UTC+3)");
-            addTimezoneInternal("Etc/GMT-4", {"d", "delta"}, "Delta Time Zone (UTC+4)");
-            addTimezoneInternal("Etc/GMT-5", {"e", "echo"}, "Echo Time Zone (UTC+5)");
-            addTimezoneInternal("Etc/GMT-6", {"f", "foxtrot"}, "Foxtrot Time Zone (UTC+6)");
-            addTimezoneInternal("Etc/GMT-7", {"g", "golf"}, "Golf Time Zone (UTC+7)");
-            addTimezoneInternal("Etc/GMT-8", {"h", "hotel"}, "Hotel Time Zone (UTC+8)");
-            addTimezoneInternal("Etc/GMT-9", {"i", "india"}, "India Time Zone (UTC+9)");
-            addTimezoneInternal("Etc/GMT-10", {"k", "kilo"}, "Kilo Time Zone (UTC+10)");
-            addTimezoneInternal("Etc/GMT-11", {"l", "lima"}, "Lima Time Zone (UTC+11)");
-            addTimezoneInternal("Etc/GMT-12", {"m", "mike"}, "Mike Time Zone (UTC+12)");
-            addTimezoneInternal("Etc/GMT+1", {"n", "november"}, "November Time Zone (UTC-1)");
-            addTimezoneInternal("Etc/GMT+2", {"o", "oscar"}, "Oscar Time Zone (UTC-2)");
-            addTimezoneInternal("Etc/GMT+3", {"p", "papa"}, "Papa Time Zone (UTC-3)");
-            addTimezoneInternal("Etc/GMT+4", {"q", "quebec"}, "Quebec Time Zone (UTC-4)");
-            addTimezoneInternal("Etc/GMT+5", {"r", "romeo"}, "Romeo Time Zone (UTC-5)");
-            addTimezoneInternal("Etc/GMT+6", {"s", "sierra"}, "Sierra Time Zone (UTC-6)");
-            addTimezoneInternal("Etc/GMT+7", {"t", "tango"}, "Tango Time Zone (UTC-7)");
-            addTimezoneInternal("Etc/GMT+8", {"u", "uniform"}, "Uniform Time Zone (UTC-8)");
-            addTimezoneInternal("Etc/GMT+9", {"v", "victor"}, "Victor Time Zone (UTC-9)");
-            addTimezoneInternal("Etc/GMT+10", {"w", "whiskey"}, "Whiskey Time Zone (UTC-10)");
-            addTimezoneInternal("Etc/GMT+11", {"x", "x-ray"}, "X-ray Time Zone (UTC-11)");
-            addTimezoneInternal("Etc/GMT+12", {"y", "yankee"}, "Yankee Time Zone (UTC-12)");
+        std::uint32_t findRuntimeTimezone(const std::string_view official_name) const {
+            const auto id = pool_.find(official_name);
+            if (!id) return kNone;
+            const auto it = std::find(names_.begin(), names_.end(), *id);
+            return it != names_.end() ? static_cast<std::uint32_t>(it - names_.begin()) : kNone;
+        }
 
-            // etc
-            addTimezoneInternal("Etc/GMT+12", {"utc-12"}, "UTC-12:00");
-            addTimezoneInternal("Etc/GMT+11", {"utc-11"}, "UTC-11:00");
-            addTimezoneInternal("Etc/GMT+10", {"utc-10"}, "UTC-10:00");
-            addTimezoneInternal("Etc/GMT+9", {"utc-9"}, "UTC-09:00");
-            addTimezoneInternal("Etc/GMT+8", {"utc-8"}, "UTC-08:00");
-            addTimezoneInternal("Etc/GMT+7", {"utc-7"}, "UTC-07:00");
-            addTimezoneInternal("Etc/GMT+6", {"utc-6"}, "UTC-06:00");
-            addTimezoneInternal("Etc/GMT+5", {"utc-5"}, "UTC-05:00");
-            addTimezoneInternal("Etc/GMT+4", {"utc-4"}, "UTC-04:00");
-            addTimezoneInternal("Etc/GMT+3", {"utc-3"}, "UTC-03:00");
-            addTimezoneInternal("Etc/GMT+2", {"utc-2"}, "UTC-02:00");
-            addTimezoneInternal("Etc/GMT+1", {"utc-1"}, "UTC-01:00");
-            addTimezoneInternal("Etc/GMT-1", {"utc+1"}, "UTC+01:00");
-            addTimezoneInternal("Etc/GMT-2", {"utc+2"}, "UTC+02:00");
-            addTimezoneInternal("Etc/GMT-3", {"utc+3"}, "UTC+03:00");
-            addTimezoneInternal("Etc/GMT-4", {"utc+4"}, "UTC+04:00");
-            addTimezoneInternal("Etc/GMT-5", {"utc+5"}, "UTC+05:00");
-            addTimezoneInternal("Etc/GMT-6", {"utc+6"}, "UTC+06:00");
-            addTimezoneInternal("Etc/GMT-7", {"utc+7"}, "UTC+07:00");
-            addTimezoneInternal("Etc/GMT-8", {"utc+8"}, "UTC+08:00");
-            addTimezoneInternal("Etc/GMT-9", {"utc+9"}, "UTC+09:00");
-            addTimezoneInternal("Etc/GMT-10", {"utc+10"}, "UTC+10:00");
-            addTimezoneInternal("Etc/GMT-11", {"utc+11"}, "UTC+11:00");
-            addTimezoneInternal("Etc/GMT-12", {"utc+12"}, "UTC+12:00");
-            addTimezoneInternal("Etc/GMT-13", {"utc+13"}, "UTC+13:00");
-            addTimezoneInternal("Etc/GMT-14", {"utc+14"}, "UTC+14:00");
+        std::vector<std::string> runtimeAliases(const std::uint32_t row) const {
+            std::vector<std::string> aliases;
+            aliases.reserve(alias_counts_[row]);
+            for (std::uint32_t i = 0; i < alias_counts_[row]; ++i) aliases.emplace_back(pool_.view(alias_ids_[alias_starts_[row] + i]));
+            return aliases;
+        }
+
+        static std::vector<std::string> splitAliases(const std::string_view list) {
+            std::vector<std::string> aliases;
+            aliases.reserve(detail::aliasCount(list));
+            for (std::size_t i = 0; i < detail::aliasCount(list); ++i) aliases.emplace_back(detail::aliasAt(list, i));
+            return aliases;
+        }
+
+        // cuts a row's alias range out of alias_ids_ before it gets a new one, so replacing a
+        // zone over and over doesn't grow the array
+        void releaseAliases(const std::uint32_t row) {
+            const std::uint32_t start = alias_starts_[row];
+            const std::uint32_t count = alias_counts_[row];
+            if (count == 0) return;
+            alias_ids_.erase(alias_ids_.begin() + start, alias_ids_.begin() + start + count);
+            for (auto& other : alias_starts_) {
+                if (other > start) other -= count;
+            }
+            alias_counts_[row] = 0;
         }
 
         void addTimezoneInternal(const std::string& official_name,
                                 const std::vector<std::string>& aliases,
                                 const std::string& description) {
-            TimezoneInfo info;
-            info.official_name = official_name;
-            info.aliases = aliases;
-            info.description = description;
-            timezones_[official_name] = info;
+            std::uint32_t row = findRuntimeTimezone(official_name);
+            if (row == kNone) {
+                row = static_cast<std::uint32_t>(names_.size());
+                names_.push_back(pool_.intern(official_name));
+                descriptions_.emplace_back();
+                alias_starts_.emplace_back();
+                alias_counts_.emplace_back();
+            }
 
-            std::string lower_official = official_name;
-            std::transform(lower_official.begin(), lower_official.end(), lower_official.begin(), ::tolower);
-            alias_to_official_[lower_official] = official_name;
+            descriptions_[row] = pool_.intern(description);
+            releaseAliases(row);
+            alias_starts_[row] = static_cast<std::uint32_t>(alias_ids_.size());
+            alias_counts_[row] = static_cast<std::uint32_t>(aliases.size());
+            for (const auto& alias : aliases) alias_ids_.push_back(pool_.intern(alias));
 
+            setRuntimeAlias(official_name, row);
             for (const auto& alias : aliases) {
-                std::string lower_alias = alias;
-                std::transform(lower_alias.begin(), lower_alias.end(), lower_alias.begin(), ::tolower);
-                if (alias_to_official_.find(lower_alias) == alias_to_official_.end()) {
-                    alias_to_official_[lower_alias] = official_name;
+                if (findRuntimeAlias(alias) == kNone && detail::kTimezoneAliases.find(alias) < 0) {
+                    setRuntimeAlias(alias, row);
                 }
             }
         }
+
+        void setRuntimeAlias(const std::string& alias, const std::uint32_t row) {
+            std::string lower_alias = alias;
+            std::transform(lower_alias.begin(), lower_alias.end(), lower_alias.begin(), detail::asciiLower);
+
+            const auto it = std::lower_bound(runtime_aliases_.begin(), runtime_aliases_.end(), lower_alias,
+                [this](const auto& entry, const std::string& key) { return pool_.view(entry.first) < key; });
+            if (it != runtime_aliases_.end() && pool_.view(it->first) == lower_alias) it->second = row;
+            else runtime_aliases_.emplace(it, pool_.intern(lower_alias), row);
+        }
     };
 
-}
\ No newline at end of file
+}
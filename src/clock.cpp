@@ -0,0 +1,32 @@
+#include "clock.hpp"
+#include <algorithm>
+
+namespace timelib {
+
+CoarseClock::CoarseClock(const std::chrono::milliseconds interval)
+    : interval_(std::max(interval, std::chrono::milliseconds{1})) {
+    // right from the start, a reader never sees the epoch
+    refresh();
+    ticker_ = std::thread([this] { tick(); });
+}
+
+CoarseClock::~CoarseClock() {
+    {
+        std::lock_guard lock(mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    ticker_.join();
+}
+
+void CoarseClock::refresh() {
+    const auto now = date::floor<std::chrono::seconds>(std::chrono::system_clock::now());
+    seconds_.store(now.time_since_epoch().count(), std::memory_order_relaxed);
+}
+
+void CoarseClock::tick() {
+    std::unique_lock lock(mutex_);
+    while (!wake_.wait_for(lock, interval_, [this] { return stopping_; })) refresh();
+}
+
+}
@@ -0,0 +1,312 @@
+#include "compiled_zone.hpp"
+#include "zone_image.hpp"
+#include <algorithm>
+#include <array>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+
+namespace timelib {
+
+namespace {
+
+// utc offsets stay well inside a day, so a local time is always within this of its instant
+constexpr std::int64_t kMaxOffset = 26 * 3600;
+
+// tzdb uses a few hundred distinct abbreviations. views are published into a fixed array so
+// readers holding an id never race with a later intern growing the pool
+constexpr std::size_t kMaxAbbrevs = 4096;
+
+// id 0 is the empty abbreviation, handed out if the pool ever fills up
+struct AbbrevPool {
+    std::shared_mutex mutex;
+    std::deque<std::string> names{std::string()};
+    std::unordered_map<std::string_view, std::uint16_t> ids{{std::string_view(), 0}};
+    std::array<std::string_view, kMaxAbbrevs> views{};
+};
+
+AbbrevPool& abbrevPool() {
+    static AbbrevPool pool;
+    return pool;
+}
+
+// zone ids are published the same way. every tzdb has a few hundred zones, this leaves room for
+// a good number of reloads
+constexpr std::size_t kMaxZoneIds = 8192;
+
+// id 0 is no zone, handed out if the pool ever fills up
+struct ZoneIdPool {
+    std::shared_mutex mutex;
+    std::unordered_map<const date::time_zone*, std::uint32_t> ids;
+    std::array<const date::time_zone*, kMaxZoneIds> zones{};
+};
+
+ZoneIdPool& zoneIdPool() {
+    static ZoneIdPool pool;
+    return pool;
+}
+
+// an image compiled from another tzdata release has other offsets wherever the rules changed
+bool fromLoadedTzdb(const ZoneImage& image) {
+    try {
+        return image.tzdataVersion() == date::get_tzdb().version;
+    } catch (const std::exception&) {
+        return false;
+    }
+}
+
+struct Registry {
+    std::shared_mutex mutex;
+    date::year first{1970};
+    date::year last{2100};
+    std::unordered_map<const date::time_zone*, std::unique_ptr<const CompiledZone>> tables;
+    std::vector<std::unique_ptr<const CompiledZone>> retired;
+    // only consulted while the range still matches the image's
+    std::unique_ptr<const ZoneImage> image;
+
+    Registry() {
+#ifdef TIMELIB_ZONE_IMAGE_PATH
+        if (auto loaded = ZoneImage::open(TIMELIB_ZONE_IMAGE_PATH); loaded && fromLoadedTzdb(*loaded)) {
+            first = loaded->firstYear();
+            last = loaded->lastYear();
+            image = std::move(loaded);
+        }
+#endif
+    }
+};
+
+Registry& registry() {
+    static Registry instance;
+    return instance;
+}
+
+std::int64_t startOfYear(const date::year y) {
+    const date::sys_days day = date::year_month_day{y, date::January, date::day{1}};
+    return std::chrono::duration_cast<std::chrono::seconds>(day.time_since_epoch()).count();
+}
+
+date::sys_seconds toSysSeconds(const std::int64_t seconds) {
+    return date::sys_seconds{std::chrono::seconds{seconds}};
+}
+
+}
+
+CompiledZone::CompiledZone(const date::time_zone* zone, const date::year first, const date::year last)
+    : zone_(zone), begin_(startOfYear(first)), end_(startOfYear(last)) {
+    if (begin_ >= end_) return;
+
+    date::sys_seconds tp = toSysSeconds(begin_);
+    while (tp.time_since_epoch().count() < end_) {
+        const auto info = zone_->get_info(tp);
+        const auto offset = static_cast<std::int32_t>(info.offset.count());
+        const auto abbrev = internAbbrev(info.abbrev);
+
+        if (offsets_.empty() || offsets_.back() != offset || abbrevs_.back() != abbrev) {
+            starts_.push_back(tp.time_since_epoch().count());
+            offsets_.push_back(offset);
+            abbrevs_.push_back(abbrev);
+        }
+
+        if (info.end <= tp) break;
+        tp = date::floor<std::chrono::seconds>(info.end);
+    }
+}
+
+CompiledZone::CompiledZone(const date::time_zone* zone, const std::int64_t begin, const std::int64_t end,
+                           std::vector<std::int64_t> starts, std::vector<std::int32_t> offsets,
+                           std::vector<std::uint16_t> abbrevs)
+    : zone_(zone), begin_(begin), end_(end),
+      starts_(std::move(starts)), offsets_(std::move(offsets)), abbrevs_(std::move(abbrevs)) {}
+
+bool CompiledZone::covers(const date::sys_seconds tp) const {
+    const std::int64_t seconds = tp.time_since_epoch().count();
+    return !starts_.empty() && seconds >= begin_ && seconds < end_;
+}
+
+ZoneOffset CompiledZone::offsetAt(const date::sys_seconds tp) const {
+    const std::size_t i = intervalAt(tp.time_since_epoch().count());
+    return {std::chrono::seconds{offsets_[i]}, abbrev(abbrevs_[i])};
+}
+
+std::optional<date::sys_seconds> CompiledZone::toSys(const date::local_seconds tp, const date::choose z) const {
+    const std::int64_t local = tp.time_since_epoch().count();
+    if (starts_.empty() || local - kMaxOffset < begin_ || local + kMaxOffset >= end_) return std::nullopt;
+
+    // every interval that could contain the instant lies between these two
+    const std::size_t first = intervalAt(local - kMaxOffset);
+    const std::size_t last = intervalAt(local + kMaxOffset);
+
+    // lower intervals give earlier instants, so the first hit is choose::earliest's answer
+    std::optional<date::sys_seconds> found;
+    for (std::size_t i = first; i <= last; ++i) {
+        const std::int64_t utc = local - offsets_[i];
+        const std::int64_t next = i + 1 < starts_.size() ? starts_[i + 1] : end_;
+        if (utc < starts_[i] || utc >= next) continue;
+
+        found = toSysSeconds(utc);
+        if (z == date::choose::earliest) break;
+    }
+    if (found) return found;
+
+    // skipped over by a forward transition, zoned_time maps these onto the transition itself
+    for (std::size_t i = first + 1; i <= last; ++i) {
+        if (local - offsets_[i - 1] >= starts_[i] && local - offsets_[i] < starts_[i]) return toSysSeconds(starts_[i]);
+    }
+    return std::nullopt;
+}
+
+std::size_t CompiledZone::intervalAt(const std::int64_t seconds) const {
+    const std::int64_t* base = starts_.data();
+    std::size_t count = starts_.size();
+
+    if (count <= kLinearSearchLimit) {
+        std::size_t passed = 0;
+        for (std::size_t i = 0; i < count; ++i) passed += base[i] <= seconds;
+        return passed - 1;
+    }
+
+    while (count > 1) {
+        const std::size_t half = count / 2;
+        base = base[half] <= seconds ? base + half : base;
+        count -= half;
+    }
+    return static_cast<std::size_t>(base - starts_.data());
+}
+
+std::uint16_t CompiledZone::internAbbrev(const std::string_view abbrev) {
+    auto& pool = abbrevPool();
+    {
+        std::shared_lock lock(pool.mutex);
+        if (const auto it = pool.ids.find(abbrev); it != pool.ids.end()) return it->second;
+    }
+
+    std::unique_lock lock(pool.mutex);
+    if (const auto it = pool.ids.find(abbrev); it != pool.ids.end()) return it->second;
+    if (pool.names.size() == kMaxAbbrevs) return 0;
+
+    const auto id = static_cast<std::uint16_t>(pool.names.size());
+    const std::string_view name = pool.names.emplace_back(abbrev);
+    pool.views[id] = name;
+    pool.ids.emplace(name, id);
+    return id;
+}
+
+std::string_view CompiledZone::abbrev(const std::uint16_t id) {
+    return abbrevPool().views[id];
+}
+
+void ZoneTables::setYearRange(const date::year first, const date::year last) {
+    auto& tables = registry();
+    std::unique_lock lock(tables.mutex);
+    tables.first = first;
+    tables.last = last;
+    for (auto& [zone, table] : tables.tables) tables.retired.push_back(std::move(table));
+    tables.tables.clear();
+}
+
+bool ZoneTables::loadImage(const std::string& path) {
+    auto image = ZoneImage::open(path);
+    if (!image || !fromLoadedTzdb(*image)) return false;
+
+    auto& tables = registry();
+    std::unique_lock lock(tables.mutex);
+    tables.first = image->firstYear();
+    tables.last = image->lastYear();
+    for (auto& [zone, table] : tables.tables) tables.retired.push_back(std::move(table));
+    tables.tables.clear();
+    // tables are copied out of the image under the lock, so a replaced one can be unmapped now
+    tables.image = std::move(image);
+    return true;
+}
+
+void ZoneTables::unloadImage() {
+    auto& tables = registry();
+    std::unique_lock lock(tables.mutex);
+    tables.image.reset();
+}
+
+void ZoneTables::prepare() {
+    registry();
+    abbrevPool();
+    zoneIdPool();
+}
+
+std::uint32_t ZoneTables::zoneId(const date::time_zone* zone) {
+    if (!zone) return kNoZone;
+    auto& pool = zoneIdPool();
+    {
+        std::shared_lock lock(pool.mutex);
+        if (const auto it = pool.ids.find(zone); it != pool.ids.end()) return it->second;
+    }
+
+    std::unique_lock lock(pool.mutex);
+    if (const auto it = pool.ids.find(zone); it != pool.ids.end()) return it->second;
+    const std::size_t id = pool.ids.size() + 1;
+    if (id == kMaxZoneIds) return kNoZone;
+
+    pool.zones[id] = zone;
+    pool.ids.emplace(zone, static_cast<std::uint32_t>(id));
+    return static_cast<std::uint32_t>(id);
+}
+
+const date::time_zone* ZoneTables::zoneById(const std::uint32_t id) {
+    return id < kMaxZoneIds ? zoneIdPool().zones[id] : nullptr;
+}
+
+const CompiledZone* ZoneTables::find(const date::time_zone* zone) {
+    auto& tables = registry();
+    date::year first, last;
+    const ZoneImage* image = nullptr;
+    {
+        std::shared_lock lock(tables.mutex);
+        if (const auto it = tables.tables.find(zone); it != tables.tables.end()) return it->second.get();
+        first = tables.first;
+        last = tables.last;
+        if (tables.image && tables.image->firstYear() == first && tables.image->lastYear() == last) {
+            image = tables.image.get();
+        }
+    }
+    if (first >= last) return nullptr;
+
+    // built outside the lock, a racing builder for the same zone just loses the emplace. the
+    // image is only swapped under the unique lock, so it can't go away while copying out of it
+    std::unique_ptr<const CompiledZone> table;
+    if (image) {
+        std::shared_lock lock(tables.mutex);
+        if (tables.image.get() == image) table = image->compile(zone);
+    }
+    if (!table) table = std::make_unique<const CompiledZone>(zone, first, last);
+
+    std::unique_lock lock(tables.mutex);
+    if (tables.first != first || tables.last != last) return nullptr;
+    return tables.tables.emplace(zone, std::move(table)).first->second.get();
+}
+
+ZoneOffset ZoneTables::offsetAt(const date::time_zone* zone, const date::sys_seconds tp) {
+    if (const auto* table = find(zone); table && table->covers(tp)) return table->offsetAt(tp);
+
+    const auto info = zone->get_info(tp);
+    return {info.offset, CompiledZone::abbrev(CompiledZone::internAbbrev(info.abbrev))};
+}
+
+date::sys_seconds ZoneTables::toSys(const date::time_zone* zone, const date::local_seconds tp, const date::choose z) {
+    if (const auto* table = find(zone)) {
+        if (const auto sys = table->toSys(tp, z)) return *sys;
+    }
+    return zone->to_sys(tp, z);
+}
+
+date::sys_seconds ZoneTables::nextTransition(const date::time_zone* zone, const date::sys_seconds tp) {
+    if (const auto* table = find(zone); table && table->covers(tp)) {
+        const auto& starts = table->starts();
+        const auto next = std::upper_bound(starts.begin(), starts.end(), tp.time_since_epoch().count());
+        // past the last change in the table the zone may still change after the range ends
+        return toSysSeconds(next != starts.end() ? *next : table->rangeEnd());
+    }
+    return date::floor<std::chrono::seconds>(zone->get_info(tp).end);
+}
+
+}
@@ -0,0 +1,136 @@
+#include "completion.hpp"
+#include "alias_table.hpp"
+#include <algorithm>
+#include <queue>
+#include <tuple>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace timelib {
+
+namespace {
+
+std::string toLower(const std::string_view text) {
+    std::string lower(text);
+    std::transform(lower.begin(), lower.end(), lower.begin(), detail::asciiLower);
+    return lower;
+}
+
+// kind first, then shorter names
+std::uint32_t weightOf(const NameKind kind, const std::size_t size) {
+    return static_cast<std::uint32_t>(kind) << 8 | static_cast<std::uint32_t>(255 - std::min<std::size_t>(size, 255));
+}
+
+}
+
+PrefixIndex::PrefixIndex(const std::vector<NameEntry>& entries) {
+    std::unordered_set<std::string> seen;
+    std::unordered_map<std::string_view, Ref> interned;
+    std::vector<std::pair<std::string, std::size_t>> names;
+
+    const auto intern = [&](const std::string_view value) {
+        if (const auto it = interned.find(value); it != interned.end()) return it->second;
+        const Ref ref{static_cast<std::uint32_t>(text_.size()), static_cast<std::uint32_t>(value.size())};
+        text_.append(value);
+        interned.emplace(value, ref);
+        return ref;
+    };
+
+    for (std::size_t i = 0; i < entries.size(); ++i) {
+        std::string lower = toLower(entries[i].name);
+        if (lower.empty() || !seen.insert(lower).second) continue;
+        names.emplace_back(std::move(lower), i);
+    }
+    std::sort(names.begin(), names.end());
+
+    entries_.reserve(names.size());
+    weights_.reserve(names.size());
+    for (const auto& [lower, index] : names) {
+        const auto& source = entries[index];
+        const Ref name{static_cast<std::uint32_t>(text_.size()), static_cast<std::uint32_t>(lower.size())};
+        text_.append(lower);
+        entries_.push_back({name, intern(source.timezone), intern(source.target), source.kind});
+        weights_.push_back(weightOf(source.kind, lower.size()));
+    }
+
+    if (entries_.empty()) return;
+    levels_.emplace_back(entries_.size());
+    for (std::uint32_t i = 0; i < entries_.size(); ++i) levels_[0][i] = i;
+    for (std::size_t width = 1; width * 2 <= entries_.size(); width *= 2) {
+        const auto& previous = levels_.back();
+        std::vector<std::uint32_t> level(entries_.size() - width * 2 + 1);
+        for (std::size_t i = 0; i < level.size(); ++i) level[i] = better(previous[i], previous[i + width]);
+        levels_.push_back(std::move(level));
+    }
+}
+
+PrefixIndex PrefixIndex::builtin() {
+    return PrefixIndex(NameCatalog::builtin().entries());
+}
+
+std::uint32_t PrefixIndex::better(const std::uint32_t a, const std::uint32_t b) const {
+    if (weights_[a] != weights_[b]) return weights_[a] > weights_[b] ? a : b;
+    return std::min(a, b);
+}
+
+std::uint32_t PrefixIndex::best(const std::size_t first, const std::size_t last) const {
+    std::size_t level = 0;
+    while (std::size_t{2} << level <= last - first) ++level;
+    return better(levels_[level][first], levels_[level][last - (std::size_t{1} << level)]);
+}
+
+std::pair<std::size_t, std::size_t> PrefixIndex::range(const std::string_view lower) const {
+    const auto first = std::lower_bound(entries_.begin(), entries_.end(), lower, [this](const Entry& entry, const std::string_view key) {
+        return view(entry.name) < key;
+    });
+    const auto last = std::partition_point(first, entries_.end(), [this, lower](const Entry& entry) {
+        return view(entry.name).substr(0, lower.size()) == lower;
+    });
+    return {static_cast<std::size_t>(first - entries_.begin()), static_cast<std::size_t>(last - entries_.begin())};
+}
+
+bool PrefixIndex::hasPrefix(const std::string_view prefix) const {
+    if (prefix.empty()) return false;
+    const auto [first, last] = range(toLower(prefix));
+    return first < last;
+}
+
+std::vector<Completion> PrefixIndex::complete(const std::string_view prefix, const std::size_t k) const {
+    if (prefix.empty() || k == 0) return {};
+    const auto [first, last] = range(toLower(prefix));
+    if (first == last) return {};
+
+    // best-first over subranges: the best entry of a range is emitted, then the two halves around
+    // it are queued, so only about k ranges (plus skipped duplicates) are ever looked at
+    using Candidate = std::tuple<std::uint32_t, std::size_t, std::size_t, std::size_t>;
+    const auto worse = [](const Candidate& a, const Candidate& b) {
+        if (std::get<0>(a) != std::get<0>(b)) return std::get<0>(a) < std::get<0>(b);
+        return std::get<1>(a) > std::get<1>(b);
+    };
+    std::priority_queue<Candidate, std::vector<Candidate>, decltype(worse)> queue(worse);
+
+    const auto push = [&](const std::size_t lo, const std::size_t hi) {
+        if (lo >= hi) return;
+        const std::uint32_t index = best(lo, hi);
+        queue.emplace(weights_[index], index, lo, hi);
+    };
+    push(first, last);
+
+    std::vector<Completion> completions;
+    while (!queue.empty() && completions.size() < k) {
+        const auto [weight, index, lo, hi] = queue.top();
+        queue.pop();
+
+        const Entry& entry = entries_[index];
+        const std::string_view target = view(entry.target);
+        const bool duplicate = std::any_of(completions.begin(), completions.end(),
+                                           [target](const Completion& c) { return c.target == target; });
+        if (!duplicate) completions.push_back({view(entry.name), view(entry.timezone), target, entry.kind});
+
+        push(lo, index);
+        push(index + 1, hi);
+    }
+    return completions;
+}
+
+}
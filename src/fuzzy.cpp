@@ -0,0 +1,201 @@
+#include "fuzzy.hpp"
+#include "alias_table.hpp"
+#include <algorithm>
+#include <array>
+#include <unordered_set>
+#include <utility>
+
+namespace timelib {
+
+namespace {
+
+constexpr char kPad = '\x01';
+
+std::uint32_t packGram(const char a, const char b, const char c) {
+    return static_cast<std::uint32_t>(static_cast<unsigned char>(a)) << 16 |
+           static_cast<std::uint32_t>(static_cast<unsigned char>(b)) << 8 |
+           static_cast<std::uint32_t>(static_cast<unsigned char>(c));
+}
+
+// distinct trigrams of the string padded with two markers on each side, sorted
+std::vector<std::uint32_t> gramsOf(const std::string_view text) {
+    std::string padded;
+    padded.reserve(text.size() + 4);
+    padded.append(2, kPad).append(text).append(2, kPad);
+
+    std::vector<std::uint32_t> grams;
+    grams.reserve(padded.size() - 2);
+    for (std::size_t i = 0; i + 2 < padded.size(); ++i) grams.push_back(packGram(padded[i], padded[i + 1], padded[i + 2]));
+    std::sort(grams.begin(), grams.end());
+    grams.erase(std::unique(grams.begin(), grams.end()), grams.end());
+    return grams;
+}
+
+std::string toLower(const std::string_view text) {
+    std::string lower(text);
+    std::transform(lower.begin(), lower.end(), lower.begin(), detail::asciiLower);
+    return lower;
+}
+
+// hyyrö's formulation of myers' algorithm, one column of the dp matrix per text character.
+// the pattern has to fit in 64 bits
+std::size_t bitParallelDistance(const std::string_view pattern, const std::string_view text) {
+    std::array<std::uint64_t, 256> peq{};
+    for (std::size_t i = 0; i < pattern.size(); ++i) peq[static_cast<unsigned char>(pattern[i])] |= std::uint64_t{1} << i;
+
+    const std::uint64_t high = std::uint64_t{1} << (pattern.size() - 1);
+    std::uint64_t pv = ~std::uint64_t{0};
+    std::uint64_t mv = 0;
+    std::size_t score = pattern.size();
+
+    for (const char c : text) {
+        const std::uint64_t eq = peq[static_cast<unsigned char>(c)];
+        const std::uint64_t xv = eq | mv;
+        const std::uint64_t xh = (((eq & pv) + pv) ^ pv) | eq;
+        std::uint64_t ph = mv | ~(xh | pv);
+        std::uint64_t mh = pv & xh;
+
+        if (ph & high) ++score;
+        else if (mh & high) --score;
+
+        // the top row of the matrix grows by one per column
+        ph = (ph << 1) | 1;
+        mh <<= 1;
+        pv = mh | ~(xv | ph);
+        mv = ph & xv;
+    }
+    return score;
+}
+
+std::size_t tableDistance(const std::string_view a, const std::string_view b) {
+    std::vector<std::size_t> row(b.size() + 1);
+    for (std::size_t j = 0; j <= b.size(); ++j) row[j] = j;
+    for (std::size_t i = 1; i <= a.size(); ++i) {
+        std::size_t diagonal = row[0];
+        row[0] = i;
+        for (std::size_t j = 1; j <= b.size(); ++j) {
+            const std::size_t above = row[j];
+            row[j] = std::min({row[j] + 1, row[j - 1] + 1, diagonal + (a[i - 1] != b[j - 1])});
+            diagonal = above;
+        }
+    }
+    return row[b.size()];
+}
+
+}
+
+FuzzyMatcher::FuzzyMatcher(const std::vector<NameEntry>& entries) {
+    std::unordered_set<std::string> seen;
+    std::vector<std::pair<std::uint32_t, std::uint32_t>> pairs;
+
+    for (const auto& source : entries) {
+        std::string lower = toLower(source.name);
+        if (lower.empty() || !seen.insert(lower).second) continue;
+
+        const auto index = static_cast<std::uint32_t>(entries_.size());
+        for (const std::uint32_t gram : gramsOf(lower)) pairs.emplace_back(gram, index);
+
+        Entry entry{};
+        entry.name_offset = static_cast<std::uint32_t>(text_.size());
+        entry.name_size = static_cast<std::uint32_t>(lower.size());
+        text_.append(lower);
+        entry.timezone_offset = static_cast<std::uint32_t>(text_.size());
+        entry.timezone_size = static_cast<std::uint32_t>(source.timezone.size());
+        text_.append(source.timezone);
+        entries_.push_back(entry);
+    }
+
+    std::sort(pairs.begin(), pairs.end());
+    postings_.reserve(pairs.size());
+    for (const auto& [gram, index] : pairs) {
+        if (grams_.empty() || grams_.back() != gram) {
+            grams_.push_back(gram);
+            gram_starts_.push_back(static_cast<std::uint32_t>(postings_.size()));
+        }
+        postings_.push_back(index);
+    }
+    gram_starts_.push_back(static_cast<std::uint32_t>(postings_.size()));
+}
+
+FuzzyMatcher FuzzyMatcher::builtin() {
+    return FuzzyMatcher(NameCatalog::builtin().entries());
+}
+
+std::vector<FuzzyMatch> FuzzyMatcher::search(const std::string_view query, const FuzzyOptions& options, const std::size_t limit) const {
+    const std::string lower = toLower(query);
+    if (lower.empty() || entries_.empty() || limit == 0) return {};
+
+    const std::size_t k = options.chars_per_edit ? std::min(options.max_distance, lower.size() / options.chars_per_edit) : options.max_distance;
+    const auto grams = gramsOf(lower);
+
+    // an edit touches at most three trigrams, so a name within k edits still shares this many of
+    // the query's distinct trigrams
+    const std::size_t needed = grams.size() > 3 * k ? grams.size() - 3 * k : 0;
+
+    thread_local std::vector<std::uint16_t> counts;
+    thread_local std::vector<std::uint32_t> touched;
+    if (counts.size() < entries_.size()) counts.resize(entries_.size());
+    touched.clear();
+
+    if (needed == 0) {
+        for (std::uint32_t i = 0; i < entries_.size(); ++i) touched.push_back(i);
+    } else {
+        for (const std::uint32_t gram : grams) {
+            const auto it = std::lower_bound(grams_.begin(), grams_.end(), gram);
+            if (it == grams_.end() || *it != gram) continue;
+
+            const std::size_t slot = static_cast<std::size_t>(it - grams_.begin());
+            for (std::uint32_t p = gram_starts_[slot]; p < gram_starts_[slot + 1]; ++p) {
+                if (counts[postings_[p]]++ == 0) touched.push_back(postings_[p]);
+            }
+        }
+    }
+
+    std::vector<FuzzyMatch> matches;
+    for (const std::uint32_t index : touched) {
+        const std::size_t shared = counts[index];
+        counts[index] = 0;
+        if (shared < needed) continue;
+
+        const std::string_view candidate = name(entries_[index]);
+        const std::size_t longer = std::max(candidate.size(), lower.size());
+        if (longer - std::min(candidate.size(), lower.size()) > k) continue;
+
+        const std::size_t distance = editDistance(lower, candidate);
+        if (distance > k) continue;
+
+        const double confidence = 1.0 - static_cast<double>(distance) / static_cast<double>(longer);
+        matches.push_back({candidate, timezone(entries_[index]), distance, confidence});
+    }
+
+    std::sort(matches.begin(), matches.end(), [](const FuzzyMatch& a, const FuzzyMatch& b) {
+        if (a.distance != b.distance) return a.distance < b.distance;
+        if (a.confidence != b.confidence) return a.confidence > b.confidence;
+        return a.name < b.name;
+    });
+    if (matches.size() > limit) matches.resize(limit);
+    return matches;
+}
+
+std::optional<FuzzyMatch> FuzzyMatcher::best(const std::string_view query, const FuzzyOptions& options) const {
+    if (!options.enabled) return std::nullopt;
+
+    const auto matches = search(query, options, 8);
+    if (matches.empty() || matches.front().confidence < options.min_confidence) return std::nullopt;
+
+    // equally close names in different zones means the input is ambiguous, don't guess
+    const auto& top = matches.front();
+    for (std::size_t i = 1; i < matches.size() && matches[i].distance == top.distance; ++i) {
+        if (matches[i].timezone != top.timezone) return std::nullopt;
+    }
+    return top;
+}
+
+std::size_t FuzzyMatcher::editDistance(std::string_view a, std::string_view b) {
+    if (a.size() > b.size()) std::swap(a, b);
+    if (a.empty()) return b.size();
+    if (a.size() <= 64) return bitParallelDistance(a, b);
+    return tableDistance(a, b);
+}
+
+}
@@ -0,0 +1,243 @@
+#include "gazetteer.hpp"
+#include "alias_table.hpp"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <unordered_map>
+
+namespace timelib {
+
+namespace {
+
+// geonames columns
+constexpr std::size_t kNameColumn = 1;
+constexpr std::size_t kAsciiNameColumn = 2;
+constexpr std::size_t kAlternateNamesColumn = 3;
+constexpr std::size_t kCountryColumn = 8;
+constexpr std::size_t kPopulationColumn = 14;
+constexpr std::size_t kTimezoneColumn = 17;
+
+// longer alternate names are descriptions rather than something anyone types
+constexpr std::size_t kMaxKeyLength = 64;
+
+std::string_view trim(std::string_view text) {
+    while (!text.empty() && (text.front() == ' ' || text.front() == '\r')) text.remove_prefix(1);
+    while (!text.empty() && (text.back() == ' ' || text.back() == '\r')) text.remove_suffix(1);
+    return text;
+}
+
+std::string lower(const std::string_view text) {
+    std::string lowered(text);
+    std::transform(lowered.begin(), lowered.end(), lowered.begin(), detail::asciiLower);
+    return lowered;
+}
+
+struct Row {
+    std::string name;
+    std::string zone;
+    std::uint32_t population;
+    std::vector<std::string> keys;
+};
+
+}
+
+std::unique_ptr<const Gazetteer> Gazetteer::open(const std::string& path) {
+    std::unique_ptr<Gazetteer> gazetteer(new Gazetteer());
+    gazetteer->file_ = detail::MappedFile::open(path);
+    if (!gazetteer->file_ || !gazetteer->validate()) return nullptr;
+    return gazetteer;
+}
+
+bool Gazetteer::validate() {
+    detail::SectionCursor sections(file_);
+    if (!sections.next<places::Header>(1)) return false;
+    const auto& head = header();
+    if (std::memcmp(head.magic, places::kMagic, sizeof(head.magic)) != 0) return false;
+    if (head.version != places::kVersion) return false;
+
+    zones_ = sections.next<places::StringRef>(head.zone_count);
+    places_ = sections.next<places::Place>(head.place_count);
+    keys_ = sections.next<places::Key>(head.key_count);
+    postings_ = sections.next<std::uint32_t>(head.posting_count);
+    place_keys_ = sections.next<std::uint32_t>(head.place_key_count);
+    strings_ = sections.next<char>(head.strings_size);
+    if (!zones_ || !places_ || !keys_ || !postings_ || !place_keys_ || !strings_) return false;
+
+    // every reference is dereferenced without checks later, so they're all vetted here in one
+    // linear pass. the keys also have to be in order for the binary search
+    const auto in_blob = [&](const places::StringRef ref) {
+        return ref.offset <= head.strings_size && ref.size <= head.strings_size - ref.offset;
+    };
+    const auto in_range = [](const std::uint32_t first, const std::uint32_t count, const std::uint32_t total) {
+        return first <= total && count <= total - first;
+    };
+
+    if (!std::all_of(zones_, zones_ + head.zone_count, in_blob)) return false;
+    for (std::uint32_t i = 0; i < head.place_count; ++i) {
+        const auto& place = places_[i];
+        if (!in_blob(place.name) || place.zone >= head.zone_count) return false;
+        if (!in_range(place.first_key, place.key_count, head.place_key_count)) return false;
+    }
+    for (std::uint32_t i = 0; i < head.key_count; ++i) {
+        const auto& key = keys_[i];
+        if (!in_blob(key.text) || !in_range(key.first_posting, key.posting_count, head.posting_count)) return false;
+        if (i > 0 && string(keys_[i - 1].text) >= string(key.text)) return false;
+    }
+    return std::all_of(postings_, postings_ + head.posting_count, [&head](const std::uint32_t p) { return p < head.place_count; }) &&
+           std::all_of(place_keys_, place_keys_ + head.place_key_count, [&head](const std::uint32_t k) { return k < head.key_count; });
+}
+
+const places::Key* Gazetteer::findKey(const std::string_view name) const {
+    const auto* end = keys_ + header().key_count;
+    const auto* key = std::lower_bound(keys_, end, name, [this](const places::Key& entry, const std::string_view text) {
+        return detail::compareIgnoreCase(string(entry.text), text) < 0;
+    });
+    if (key == end || !detail::equalsIgnoreCase(string(key->text), name) || key->posting_count == 0) return nullptr;
+    return key;
+}
+
+std::uint32_t Gazetteer::find(const std::string_view name) const {
+    const places::Key* key = findKey(name);
+    return key ? postings_[key->first_posting] : kNone;
+}
+
+std::vector<std::uint32_t> Gazetteer::findAll(const std::string_view name, const std::size_t limit) const {
+    const places::Key* key = findKey(name);
+    if (!key) return {};
+    const std::uint32_t* first = postings_ + key->first_posting;
+    return std::vector<std::uint32_t>(first, first + std::min<std::size_t>(key->posting_count, limit));
+}
+
+std::vector<std::string> Gazetteer::aliases(const std::uint32_t place) const {
+    const auto& row = places_[place];
+    std::vector<std::string> aliases;
+    aliases.reserve(row.key_count);
+    for (std::uint32_t i = row.first_key; i < row.first_key + row.key_count; ++i) {
+        const std::string_view text = string(keys_[place_keys_[i]].text);
+        if (!detail::equalsIgnoreCase(text, string(row.name))) aliases.emplace_back(text);
+    }
+    return aliases;
+}
+
+std::size_t Gazetteer::write(const std::string& tsv_path, const std::string& path, const GazetteerOptions& options) {
+    std::ifstream in(tsv_path);
+    if (!in) return 0;
+
+    std::vector<Row> rows;
+    std::vector<std::string_view> columns;
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.empty() || line[0] == '#') continue;
+
+        columns.clear();
+        for (std::size_t start = 0;;) {
+            const std::size_t tab = line.find('\t', start);
+            columns.push_back(std::string_view(line).substr(start, tab == std::string::npos ? std::string::npos : tab - start));
+            if (tab == std::string::npos) break;
+            start = tab + 1;
+        }
+        if (columns.size() <= kTimezoneColumn) continue;
+
+        const std::string_view zone = trim(columns[kTimezoneColumn]);
+        const std::string_view name = trim(columns[kNameColumn]);
+        if (zone.empty() || name.empty()) continue;
+        const unsigned long long population = std::strtoull(std::string(columns[kPopulationColumn]).c_str(), nullptr, 10);
+        if (population < options.min_population) continue;
+
+        Row row{std::string(name), std::string(zone), static_cast<std::uint32_t>(std::min<unsigned long long>(population, ~0u)), {}};
+        const auto add_key = [&row](const std::string_view text) {
+            const std::string_view trimmed = trim(text);
+            if (trimmed.empty() || trimmed.size() > kMaxKeyLength) return;
+            std::string key = lower(trimmed);
+            if (std::find(row.keys.begin(), row.keys.end(), key) == row.keys.end()) row.keys.push_back(std::move(key));
+        };
+
+        add_key(name);
+        const std::string_view ascii = trim(columns[kAsciiNameColumn]);
+        add_key(ascii);
+        // "paris, us" for telling same-named places apart by country
+        if (const std::string_view country = trim(columns[kCountryColumn]); !country.empty()) {
+            add_key(std::string(ascii.empty() ? name : ascii).append(", ").append(country));
+        }
+        if (options.alternate_names) {
+            const std::string_view alternates = columns[kAlternateNamesColumn];
+            for (std::size_t start = 0; start <= alternates.size();) {
+                const std::size_t comma = std::min(alternates.find(',', start), alternates.size());
+                add_key(alternates.substr(start, comma - start));
+                start = comma + 1;
+            }
+        }
+        rows.push_back(std::move(row));
+    }
+    if (rows.empty()) return 0;
+
+    // place ids go by population, so a key's postings sorted by id are already ranked
+    std::stable_sort(rows.begin(), rows.end(), [](const Row& a, const Row& b) { return a.population > b.population; });
+
+    std::string strings;
+    std::unordered_map<std::string, places::StringRef> interned;
+    const auto intern = [&](const std::string& text) {
+        const auto [it, added] = interned.emplace(text, places::StringRef{static_cast<std::uint32_t>(strings.size()),
+                                                                          static_cast<std::uint32_t>(text.size())});
+        if (added) strings.append(text);
+        return it->second;
+    };
+
+    std::map<std::string, std::uint32_t> zone_ids;
+    std::map<std::string, std::vector<std::uint32_t>> key_postings;
+    for (std::uint32_t p = 0; p < rows.size(); ++p) {
+        zone_ids.emplace(rows[p].zone, 0);
+        for (const auto& key : rows[p].keys) key_postings[key].push_back(p);
+    }
+
+    std::vector<places::StringRef> zones;
+    for (auto& [zone, id] : zone_ids) {
+        id = static_cast<std::uint32_t>(zones.size());
+        zones.push_back(intern(zone));
+    }
+
+    std::vector<places::Key> keys;
+    std::vector<std::uint32_t> postings;
+    std::unordered_map<std::string_view, std::uint32_t> key_ids;
+    for (const auto& [text, list] : key_postings) {
+        key_ids.emplace(text, static_cast<std::uint32_t>(keys.size()));
+        keys.push_back({intern(text), static_cast<std::uint32_t>(postings.size()), static_cast<std::uint32_t>(list.size())});
+        postings.insert(postings.end(), list.begin(), list.end());
+    }
+
+    std::vector<places::Place> place_rows;
+    std::vector<std::uint32_t> place_keys;
+    place_rows.reserve(rows.size());
+    for (const auto& row : rows) {
+        place_rows.push_back({intern(row.name), zone_ids[row.zone], row.population, static_cast<std::uint32_t>(place_keys.size()),
+                              static_cast<std::uint32_t>(row.keys.size())});
+        for (const auto& key : row.keys) place_keys.push_back(key_ids.at(key));
+    }
+
+    places::Header head{};
+    std::memcpy(head.magic, places::kMagic, sizeof(head.magic));
+    head.version = places::kVersion;
+    head.zone_count = static_cast<std::uint32_t>(zones.size());
+    head.place_count = static_cast<std::uint32_t>(place_rows.size());
+    head.key_count = static_cast<std::uint32_t>(keys.size());
+    head.posting_count = static_cast<std::uint32_t>(postings.size());
+    head.place_key_count = static_cast<std::uint32_t>(place_keys.size());
+    head.strings_size = static_cast<std::uint32_t>(strings.size());
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) return 0;
+
+    out.write(reinterpret_cast<const char*>(&head), sizeof(head));
+    detail::writeSection(out, zones);
+    detail::writeSection(out, place_rows);
+    detail::writeSection(out, keys);
+    detail::writeSection(out, postings);
+    detail::writeSection(out, place_keys);
+    detail::writeSection(out, std::vector<char>(strings.begin(), strings.end()));
+
+    out.close();
+    return out ? place_rows.size() : 0;
+}
+
+}
@@ -0,0 +1,629 @@
+#include "geo_index.hpp"
+#include "snapshot.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <sstream>
+
+namespace timelib {
+
+namespace {
+
+struct Point {
+    std::int32_t x;
+    std::int32_t y;
+
+    bool operator==(const Point& other) const { return x == other.x && y == other.y; }
+};
+
+using Ring = std::vector<Point>;
+
+constexpr std::int64_t kHalfTurn = 180LL * geo::kScale;
+constexpr std::int64_t kQuarterTurn = 90LL * geo::kScale;
+
+// > 0 when c is left of a -> b. points on the globe in microdegrees (validate() sees to it)
+// keep every product well inside 64 bits
+std::int64_t orient(const std::int64_t ax, const std::int64_t ay, const std::int64_t bx, const std::int64_t by,
+                    const std::int64_t cx, const std::int64_t cy) {
+    return (bx - ax) * (cy - ay) - (by - ay) * (cx - ax);
+}
+
+// just enough json for geojson feature collections: the features' "tzid" property and their
+// coordinates, whatever the nesting. everything else is skipped. the text has to be null
+// terminated (numbers are read with strtod)
+class GeoJsonReader {
+public:
+    explicit GeoJsonReader(const std::string& text) : text_(text) {}
+
+    bool read(std::map<std::string, std::vector<Ring>>& zones) {
+        return readObject([&](const std::string& key) {
+            if (key != "features") return skipValue();
+            return readArray([&] { return readFeature(zones); });
+        });
+    }
+
+private:
+    const std::string& text_;
+    std::size_t pos_ = 0;
+
+    void skipSpace() {
+        while (pos_ < text_.size() && (text_[pos_] == ' ' || text_[pos_] == '\n' || text_[pos_] == '\r' || text_[pos_] == '\t')) ++pos_;
+    }
+
+    bool consume(const char c) {
+        skipSpace();
+        if (pos_ >= text_.size() || text_[pos_] != c) return false;
+        ++pos_;
+        return true;
+    }
+
+    bool peek(const char c) {
+        skipSpace();
+        return pos_ < text_.size() && text_[pos_] == c;
+    }
+
+    // escapes other than \uXXXX are unescaped, those are kept as typed (tzids are plain ascii)
+    bool readString(std::string& out) {
+        out.clear();
+        if (!consume('"')) return false;
+        while (pos_ < text_.size() && text_[pos_] != '"') {
+            if (text_[pos_] == '\\' && pos_ + 1 < text_.size() && text_[pos_ + 1] != 'u') ++pos_;
+            out += text_[pos_++];
+        }
+        return consume('"');
+    }
+
+    bool readNumber(double& out) {
+        skipSpace();
+        char* end = nullptr;
+        out = std::strtod(text_.c_str() + pos_, &end);
+        if (end == text_.c_str() + pos_) return false;
+        pos_ = static_cast<std::size_t>(end - text_.c_str());
+        return true;
+    }
+
+    template <class OnKey>
+    bool readObject(OnKey&& on_key) {
+        if (!consume('{')) return false;
+        if (consume('}')) return true;
+        std::string key;
+        do {
+            if (!readString(key) || !consume(':') || !on_key(key)) return false;
+        } while (consume(','));
+        return consume('}');
+    }
+
+    template <class OnItem>
+    bool readArray(OnItem&& on_item) {
+        if (!consume('[')) return false;
+        if (consume(']')) return true;
+        do {
+            if (!on_item()) return false;
+        } while (consume(','));
+        return consume(']');
+    }
+
+    bool skipValue() {
+        skipSpace();
+        if (peek('{')) return readObject([this](const std::string&) { return skipValue(); });
+        if (peek('[')) return readArray([this] { return skipValue(); });
+        if (peek('"')) {
+            std::string ignored;
+            return readString(ignored);
+        }
+        // numbers, true, false, null
+        const std::size_t start = pos_;
+        while (pos_ < text_.size() && std::strchr(",]} \n\r\t", text_[pos_]) == nullptr) ++pos_;
+        return pos_ > start;
+    }
+
+    bool readFeature(std::map<std::string, std::vector<Ring>>& zones) {
+        std::string tzid;
+        std::vector<Ring> rings;
+        const bool ok = readObject([&](const std::string& key) {
+            if (key == "properties") {
+                return readObject([&](const std::string& property) {
+                    return property == "tzid" ? readString(tzid) : skipValue();
+                });
+            }
+            if (key == "geometry") {
+                return readObject([&](const std::string& field) {
+                    return field == "coordinates" ? readCoordinates(rings) : skipValue();
+                });
+            }
+            return skipValue();
+        });
+        if (!ok) return false;
+
+        if (!tzid.empty()) {
+            auto& zone = zones[tzid];
+            zone.insert(zone.end(), std::make_move_iterator(rings.begin()), std::make_move_iterator(rings.end()));
+        }
+        return true;
+    }
+
+    // an array of positions is a ring, anything nested deeper is walked down to those
+    bool readCoordinates(std::vector<Ring>& rings) {
+        if (!consume('[')) return false;
+        if (consume(']')) return true;
+
+        skipSpace();
+        const std::size_t saved = pos_;
+        const bool positions = consume('[') && (skipSpace(), pos_ < text_.size() && std::strchr("-+.0123456789", text_[pos_]));
+        pos_ = saved;
+        if (!positions) {
+            do {
+                if (!readCoordinates(rings)) return false;
+            } while (consume(','));
+            return consume(']');
+        }
+
+        Ring ring;
+        do {
+            double lon = 0, lat = 0;
+            if (!consume('[') || !readNumber(lon) || !consume(',') || !readNumber(lat)) return false;
+            // altitude, when there is one
+            while (consume(',')) {
+                if (double ignored = 0; !readNumber(ignored)) return false;
+            }
+            if (!consume(']')) return false;
+            ring.push_back({static_cast<std::int32_t>(std::clamp<std::int64_t>(std::llround(lon * geo::kScale), -kHalfTurn, kHalfTurn)),
+                            static_cast<std::int32_t>(std::clamp<std::int64_t>(std::llround(lat * geo::kScale), -kQuarterTurn, kQuarterTurn))});
+        } while (consume(','));
+        rings.push_back(std::move(ring));
+        return consume(']');
+    }
+};
+
+double distanceToSegment(const Point p, const Point a, const Point b) {
+    const double dx = static_cast<double>(b.x) - a.x;
+    const double dy = static_cast<double>(b.y) - a.y;
+    const double length = dx * dx + dy * dy;
+    double t = length > 0 ? ((static_cast<double>(p.x) - a.x) * dx + (static_cast<double>(p.y) - a.y) * dy) / length : 0;
+    t = std::clamp(t, 0.0, 1.0);
+    return std::hypot(a.x + t * dx - p.x, a.y + t * dy - p.y);
+}
+
+// douglas-peucker over points [first, last] of a polyline, marking the ones to keep
+void simplify(const Ring& points, const std::size_t first, const std::size_t last, const double tolerance,
+              std::vector<char>& keep) {
+    std::vector<std::pair<std::size_t, std::size_t>> stack{{first, last}};
+    while (!stack.empty()) {
+        const auto [from, to] = stack.back();
+        stack.pop_back();
+        if (to <= from + 1) continue;
+
+        std::size_t farthest = from;
+        double distance = 0;
+        for (std::size_t i = from + 1; i < to; ++i) {
+            if (const double d = distanceToSegment(points[i], points[from], points[to % points.size()]); d > distance) {
+                distance = d;
+                farthest = i;
+            }
+        }
+        if (distance <= tolerance) continue;
+        keep[farthest] = 1;
+        stack.push_back({from, farthest});
+        stack.push_back({farthest, to});
+    }
+}
+
+// the closing point is dropped, the edge back to the first point is implied
+Ring cleanRing(Ring ring, const double tolerance) {
+    ring.erase(std::unique(ring.begin(), ring.end()), ring.end());
+    while (ring.size() > 1 && ring.front() == ring.back()) ring.pop_back();
+    if (ring.size() < 3 || tolerance <= 0) return ring.size() < 3 ? Ring{} : ring;
+
+    // a closed ring is split at the point farthest from its first one, both halves are
+    // simplified as open lines (the second one wraps back around to the first point)
+    std::size_t split = 0;
+    double distance = -1;
+    for (std::size_t i = 1; i < ring.size(); ++i) {
+        if (const double d = std::hypot(static_cast<double>(ring[i].x) - ring[0].x, static_cast<double>(ring[i].y) - ring[0].y);
+            d > distance) {
+            distance = d;
+            split = i;
+        }
+    }
+
+    std::vector<char> keep(ring.size(), 0);
+    keep[0] = keep[split] = 1;
+    simplify(ring, 0, split, tolerance, keep);
+    simplify(ring, split, ring.size(), tolerance, keep);
+
+    Ring simplified;
+    for (std::size_t i = 0; i < ring.size(); ++i) {
+        if (keep[i]) simplified.push_back(ring[i]);
+    }
+    return simplified.size() < 3 ? Ring{} : simplified;
+}
+
+}
+
+std::unique_ptr<const GeoIndex> GeoIndex::open(const std::string& path, const date::tzdb* db) {
+    std::unique_ptr<GeoIndex> index(new GeoIndex());
+    index->file_ = detail::MappedFile::open(path);
+    if (!index->file_ || !index->validate()) return nullptr;
+    index->bind(db);
+    return index;
+}
+
+std::unique_ptr<const GeoIndex> GeoIndex::rebind(const date::tzdb* db) const {
+    std::unique_ptr<GeoIndex> index(new GeoIndex());
+    index->file_ = file_;
+    index->names_ = names_;
+    index->cells_ = cells_;
+    index->entries_ = entries_;
+    index->edges_ = edges_;
+    index->strings_ = strings_;
+    index->width_ = width_;
+    index->height_ = height_;
+    index->bind(db);
+    return index;
+}
+
+void GeoIndex::bind(const date::tzdb* db) {
+    db_ = db;
+    zones_.clear();
+    zones_.reserve(size());
+    for (std::uint32_t i = 0; i < size(); ++i) zones_.push_back(db ? LookupSnapshot::findZone(*db, string(names_[i])) : nullptr);
+}
+
+bool GeoIndex::validate() {
+    detail::SectionCursor sections(file_);
+    if (!sections.next<geo::Header>(1)) return false;
+    const auto& head = header();
+    if (std::memcmp(head.magic, geo::kMagic, sizeof(head.magic)) != 0) return false;
+    if (head.version != geo::kVersion) return false;
+    if (head.cells_per_degree == 0 || head.cells_per_degree > 40 || geo::kScale % head.cells_per_degree != 0) return false;
+
+    width_ = 360 * head.cells_per_degree;
+    height_ = 180 * head.cells_per_degree;
+
+    names_ = sections.next<geo::StringRef>(head.zone_count);
+    cells_ = sections.next<geo::Cell>(static_cast<std::size_t>(width_) * height_);
+    entries_ = sections.next<geo::CellEntry>(head.entry_count);
+    edges_ = sections.next<geo::Edge>(head.edge_count);
+    strings_ = sections.next<char>(head.strings_size);
+    if (!names_ || !cells_ || !entries_ || !edges_ || !strings_) return false;
+
+    // lookups index straight through all of these, so every reference is vetted once here. it's
+    // a linear pass over the cells, entries and edges. points have to be on the globe, that's
+    // what keeps orient() inside 64 bits
+    for (std::uint32_t i = 0; i < head.zone_count; ++i) {
+        if (names_[i].offset > head.strings_size || names_[i].size > head.strings_size - names_[i].offset) return false;
+    }
+    for (std::size_t i = 0; i < static_cast<std::size_t>(width_) * height_; ++i) {
+        const geo::Cell& cell = cells_[i];
+        if (cell.count == 0) {
+            if (cell.first != geo::kNoZone && cell.first >= head.zone_count) return false;
+        } else if (cell.first > head.entry_count || cell.count > head.entry_count - cell.first) {
+            return false;
+        }
+    }
+    const auto on_globe = [](const std::int64_t x, const std::int64_t y) {
+        return x >= -kHalfTurn && x <= kHalfTurn && y >= -kQuarterTurn && y <= kQuarterTurn;
+    };
+    const bool valid_entries = std::all_of(entries_, entries_ + head.entry_count, [&head, &on_globe](const geo::CellEntry& entry) {
+        return entry.zone < head.zone_count && entry.first_edge <= head.edge_count &&
+               entry.edge_count <= head.edge_count - entry.first_edge && on_globe(entry.ref_x, entry.ref_y);
+    });
+    return valid_entries && std::all_of(edges_, edges_ + head.edge_count, [&on_globe](const geo::Edge& edge) {
+        return on_globe(edge.x1, edge.y1) && on_globe(edge.x2, edge.y2);
+    });
+}
+
+std::uint32_t GeoIndex::find(const double latitude, double longitude) const {
+    if (!(latitude >= -90 && latitude <= 90) || !std::isfinite(longitude)) return geo::kNoZone;
+    if (longitude < -180 || longitude > 180) longitude = std::remainder(longitude, 360.0);
+
+    const std::int64_t x = std::llround(longitude * geo::kScale);
+    const std::int64_t y = std::llround(latitude * geo::kScale);
+    const std::int64_t cell_size = geo::kScale / header().cells_per_degree;
+    const auto column = std::min<std::int64_t>((x + kHalfTurn) / cell_size, width_ - 1);
+    const auto row = std::min<std::int64_t>((y + kQuarterTurn) / cell_size, height_ - 1);
+
+    const geo::Cell& cell = cells_[static_cast<std::size_t>(row) * width_ + static_cast<std::size_t>(column)];
+    if (cell.count == 0) return cell.first;
+
+    for (const geo::CellEntry* entry = entries_ + cell.first; entry != entries_ + cell.first + cell.count; ++entry) {
+        // parity along the segment from the reference point. a vertex exactly on that line is
+        // counted as left of it, which is the same as nudging the line a hair to the right, so
+        // passing through a vertex counts once and running along an edge doesn't count at all
+        bool inside = entry->inside != 0;
+        const std::int64_t rx = entry->ref_x;
+        const std::int64_t ry = entry->ref_y;
+        for (const geo::Edge* edge = edges_ + entry->first_edge; edge != edges_ + entry->first_edge + entry->edge_count; ++edge) {
+            const bool left1 = orient(rx, ry, x, y, edge->x1, edge->y1) >= 0;
+            const bool left2 = orient(rx, ry, x, y, edge->x2, edge->y2) >= 0;
+            if (left1 == left2) continue;
+            if ((orient(edge->x1, edge->y1, edge->x2, edge->y2, rx, ry) < 0) != (orient(edge->x1, edge->y1, edge->x2, edge->y2, x, y) < 0)) {
+                inside = !inside;
+            }
+        }
+        if (inside) return entry->zone;
+    }
+    return geo::kNoZone;
+}
+
+const date::time_zone* GeoIndex::lookup(const double latitude, const double longitude) const {
+    const std::uint32_t zone = find(latitude, longitude);
+    return zone == geo::kNoZone ? nullptr : zones_[zone];
+}
+
+std::string_view GeoIndex::name(const double latitude, const double longitude) const {
+    const std::uint32_t zone = find(latitude, longitude);
+    return zone == geo::kNoZone ? std::string_view() : string(names_[zone]);
+}
+
+void GeoIndex::lookup(const Coordinate* coordinates, const std::size_t count, const date::time_zone** out) const {
+    for (std::size_t i = 0; i < count; ++i) {
+        const std::uint32_t zone = find(coordinates[i].latitude, coordinates[i].longitude);
+        out[i] = zone == geo::kNoZone ? nullptr : zones_[zone];
+    }
+}
+
+std::vector<const date::time_zone*> GeoIndex::lookup(const std::vector<Coordinate>& coordinates) const {
+    std::vector<const date::time_zone*> zones(coordinates.size());
+    lookup(coordinates.data(), coordinates.size(), zones.data());
+    return zones;
+}
+
+std::optional<Coordinate> GeoIndex::parseCoordinate(const std::string_view text) {
+    std::size_t pos = 0;
+    const auto skip_space = [&] {
+        while (pos < text.size() && (text[pos] == ' ' || text[pos] == '\t')) ++pos;
+    };
+    // [+-]digits[.digits], no exponents
+    const auto number = [&](double& out) {
+        skip_space();
+        const bool negative = pos < text.size() && text[pos] == '-';
+        if (pos < text.size() && (text[pos] == '-' || text[pos] == '+')) ++pos;
+
+        const std::size_t start = pos;
+        double value = 0;
+        while (pos < text.size() && text[pos] >= '0' && text[pos] <= '9') value = value * 10 + (text[pos++] - '0');
+        if (pos < text.size() && text[pos] == '.') {
+            ++pos;
+            for (double scale = 0.1; pos < text.size() && text[pos] >= '0' && text[pos] <= '9'; scale /= 10) {
+                value += (text[pos++] - '0') * scale;
+            }
+        }
+        if (pos == start || (pos == start + 1 && text[start] == '.')) return false;
+        out = negative ? -value : value;
+        return true;
+    };
+
+    Coordinate coordinate;
+    if (!number(coordinate.latitude)) return std::nullopt;
+    skip_space();
+    const bool comma = pos < text.size() && text[pos] == ',';
+    if (comma) ++pos;
+    else if (pos == 0 || (text[pos - 1] != ' ' && text[pos - 1] != '\t')) return std::nullopt;
+    if (!number(coordinate.longitude)) return std::nullopt;
+    skip_space();
+
+    if (pos != text.size() || std::abs(coordinate.latitude) > 90 || std::abs(coordinate.longitude) > 180) return std::nullopt;
+    return coordinate;
+}
+
+std::size_t GeoIndex::write(const std::string& geojson_path, const std::string& path, const GeoIndexOptions& options) {
+    const std::uint32_t per_degree = options.cells_per_degree;
+    if (per_degree == 0 || per_degree > 40 || geo::kScale % per_degree != 0) return 0;
+
+    std::string text;
+    {
+        std::ifstream in(geojson_path, std::ios::binary);
+        if (!in) return 0;
+        std::ostringstream buffer;
+        buffer << in.rdbuf();
+        text = std::move(buffer).str();
+    }
+
+    std::map<std::string, std::vector<Ring>> polygons;
+    if (!GeoJsonReader(text).read(polygons) || polygons.empty()) return 0;
+    std::string().swap(text);
+
+    // every zone's rings as one edge list. holes and separate polygons need no bookkeeping,
+    // inside is just an odd number of crossings over all of them
+    const double tolerance = options.tolerance * geo::kScale;
+    std::vector<std::string> names;
+    std::vector<std::vector<geo::Edge>> zone_edges;
+    for (auto& [name, rings] : polygons) {
+        std::vector<geo::Edge> edges;
+        for (auto& ring : rings) {
+            const Ring cleaned = cleanRing(std::move(ring), tolerance);
+            for (std::size_t i = 0; i < cleaned.size(); ++i) {
+                const Point a = cleaned[i];
+                const Point b = cleaned[(i + 1) % cleaned.size()];
+                edges.push_back({a.x, a.y, b.x, b.y});
+            }
+        }
+        if (edges.empty()) continue;
+        names.push_back(name);
+        zone_edges.push_back(std::move(edges));
+    }
+    polygons.clear();
+    if (names.empty()) return 0;
+
+    const std::int64_t cell_size = geo::kScale / per_degree;
+    const std::uint32_t width = 360 * per_degree;
+    const std::uint32_t height = 180 * per_degree;
+    const auto column_of = [&](const std::int64_t x) {
+        return static_cast<std::uint32_t>(std::clamp<std::int64_t>((x + kHalfTurn) / cell_size, 0, width - 1));
+    };
+    const auto row_of = [&](const std::int64_t y) {
+        return static_cast<std::uint32_t>(std::clamp<std::int64_t>((y + kQuarterTurn) / cell_size, 0, height - 1));
+    };
+
+    // edges by the rows they reach into. a unit of slack on both sides keeps edges lying on a
+    // row border in both rows
+    std::vector<std::vector<std::pair<std::uint32_t, std::uint32_t>>> rows(height);
+    for (std::uint32_t z = 0; z < zone_edges.size(); ++z) {
+        for (std::uint32_t e = 0; e < zone_edges[z].size(); ++e) {
+            const auto& edge = zone_edges[z][e];
+            const std::uint32_t low = row_of(std::min(edge.y1, edge.y2) - 1);
+            const std::uint32_t high = row_of(std::max(edge.y1, edge.y2) + 1);
+            for (std::uint32_t r = low; r <= high; ++r) rows[r].emplace_back(z, e);
+        }
+    }
+
+    std::vector<geo::Cell> cells(static_cast<std::size_t>(width) * height, geo::Cell{geo::kNoZone, 0});
+    std::vector<geo::CellEntry> entries;
+    std::vector<geo::Edge> edges;
+
+    std::vector<std::vector<std::uint32_t>> local(width);
+    std::vector<std::vector<geo::CellEntry>> row_entries(width);
+    std::vector<std::vector<geo::Edge>> row_edges(width);
+    std::vector<std::uint32_t> interior(width);
+
+    for (std::uint32_t r = 0; r < height; ++r) {
+        auto& items = rows[r];
+        std::sort(items.begin(), items.end());
+        const std::int64_t y0 = static_cast<std::int64_t>(r) * cell_size - kQuarterTurn;
+        const std::int64_t y1 = y0 + cell_size;
+        const std::int64_t center_y = y0 + cell_size / 2;
+
+        std::fill(interior.begin(), interior.end(), geo::kNoZone);
+        for (auto& list : row_entries) list.clear();
+        for (auto& list : row_edges) list.clear();
+
+        for (std::size_t begin = 0, end = 0; begin < items.size(); begin = end) {
+            const std::uint32_t z = items[begin].first;
+            while (end < items.size() && items[end].first == z) ++end;
+            const auto& zone = zone_edges[z];
+
+            // exact parity along a ray to the east, over this row's edges of the zone (the only
+            // ones a horizontal ray inside the row can cross). the point can't be on an edge
+            const auto inside_at = [&](const std::int64_t px, const std::int64_t py) {
+                bool inside = false;
+                for (std::size_t i = begin; i < end; ++i) {
+                    const auto& edge = zone[items[i].second];
+                    if ((edge.y1 > py) == (edge.y2 > py)) continue;
+                    const std::int64_t side = orient(edge.x1, edge.y1, edge.x2, edge.y2, px, py);
+                    // the crossing is east of p when p is left of an upward edge or right of a downward one
+                    if ((side > 0) == (edge.y2 > edge.y1)) inside = !inside;
+                }
+                return inside;
+            };
+
+            // the edges that touch each cell: bounding boxes overlap and the cell isn't entirely
+            // on one side of the edge's line
+            for (auto& list : local) list.clear();
+            for (std::size_t i = begin; i < end; ++i) {
+                const auto& edge = zone[items[i].second];
+                if (std::max(edge.y1, edge.y2) < y0 || std::min(edge.y1, edge.y2) > y1) continue;
+                const std::uint32_t first = column_of(std::min(edge.x1, edge.x2) - 1);
+                const std::uint32_t last = column_of(std::max(edge.x1, edge.x2) + 1);
+                for (std::uint32_t c = first; c <= last; ++c) {
+                    const std::int64_t x0 = static_cast<std::int64_t>(c) * cell_size - kHalfTurn;
+                    const std::int64_t x1 = x0 + cell_size;
+                    if (std::max(edge.x1, edge.x2) < x0 || std::min(edge.x1, edge.x2) > x1) continue;
+                    const std::int64_t corners[4] = {orient(edge.x1, edge.y1, edge.x2, edge.y2, x0, y0),
+                                                     orient(edge.x1, edge.y1, edge.x2, edge.y2, x1, y0),
+                                                     orient(edge.x1, edge.y1, edge.x2, edge.y2, x0, y1),
+                                                     orient(edge.x1, edge.y1, edge.x2, edge.y2, x1, y1)};
+                    if (std::all_of(std::begin(corners), std::end(corners), [](const std::int64_t o) { return o > 0; }) ||
+                        std::all_of(std::begin(corners), std::end(corners), [](const std::int64_t o) { return o < 0; })) {
+                        continue;
+                    }
+                    local[c].push_back(items[i].second);
+                }
+            }
+
+            // crossings of the row's center line, for the cells no edge touches
+            std::vector<double> crossings;
+            for (std::size_t i = begin; i < end; ++i) {
+                const auto& edge = zone[items[i].second];
+                if ((edge.y1 > center_y) == (edge.y2 > center_y)) continue;
+                crossings.push_back(edge.x1 + static_cast<double>(edge.x2 - edge.x1) * static_cast<double>(center_y - edge.y1) /
+                                              static_cast<double>(edge.y2 - edge.y1));
+            }
+            std::sort(crossings.begin(), crossings.end());
+
+            std::size_t west = 0;
+            for (std::uint32_t c = 0; c < width; ++c) {
+                const std::int64_t x0 = static_cast<std::int64_t>(c) * cell_size - kHalfTurn;
+                const std::int64_t center_x = x0 + cell_size / 2;
+
+                if (local[c].empty()) {
+                    // nothing of this zone passes through, so its center decides for the whole cell
+                    while (west < crossings.size() && crossings[west] < static_cast<double>(center_x)) ++west;
+                    if ((crossings.size() - west) % 2 == 1 && interior[c] == geo::kNoZone) interior[c] = z;
+                    continue;
+                }
+
+                // the reference point starts at the center and moves off any edge it sits on
+                std::int64_t ref_x = center_x;
+                std::int64_t ref_y = center_y;
+                const auto on_edge = [&] {
+                    return std::any_of(local[c].begin(), local[c].end(), [&](const std::uint32_t e) {
+                        const auto& edge = zone[e];
+                        return orient(edge.x1, edge.y1, edge.x2, edge.y2, ref_x, ref_y) == 0 &&
+                               ref_x >= std::min(edge.x1, edge.x2) && ref_x <= std::max(edge.x1, edge.x2) &&
+                               ref_y >= std::min(edge.y1, edge.y2) && ref_y <= std::max(edge.y1, edge.y2);
+                    });
+                };
+                while (on_edge()) {
+                    ref_x += 7;
+                    ref_y += 3;
+                }
+
+                geo::CellEntry entry{z, static_cast<std::uint32_t>(row_edges[c].size()), static_cast<std::uint32_t>(local[c].size()),
+                                     inside_at(ref_x, ref_y) ? 1u : 0u, static_cast<std::int32_t>(ref_x), static_cast<std::int32_t>(ref_y)};
+                row_entries[c].push_back(entry);
+                for (const std::uint32_t e : local[c]) row_edges[c].push_back(zone[e]);
+            }
+        }
+
+        for (std::uint32_t c = 0; c < width; ++c) {
+            geo::Cell& cell = cells[static_cast<std::size_t>(r) * width + c];
+            // a zone covering the whole cell is the answer for all of it, whatever else overlaps
+            if (interior[c] != geo::kNoZone || row_entries[c].empty()) {
+                cell = {interior[c], 0};
+                continue;
+            }
+            cell = {static_cast<std::uint32_t>(entries.size()), static_cast<std::uint32_t>(row_entries[c].size())};
+            for (geo::CellEntry entry : row_entries[c]) {
+                entry.first_edge += static_cast<std::uint32_t>(edges.size());
+                entries.push_back(entry);
+            }
+            edges.insert(edges.end(), row_edges[c].begin(), row_edges[c].end());
+        }
+        std::vector<std::pair<std::uint32_t, std::uint32_t>>().swap(items);
+    }
+
+    std::vector<geo::StringRef> refs;
+    std::string strings;
+    for (const auto& name : names) {
+        refs.push_back({static_cast<std::uint32_t>(strings.size()), static_cast<std::uint32_t>(name.size())});
+        strings.append(name);
+    }
+
+    geo::Header head{};
+    std::memcpy(head.magic, geo::kMagic, sizeof(head.magic));
+    head.version = geo::kVersion;
+    head.cells_per_degree = per_degree;
+    head.zone_count = static_cast<std::uint32_t>(names.size());
+    head.entry_count = static_cast<std::uint32_t>(entries.size());
+    head.edge_count = static_cast<std::uint32_t>(edges.size());
+    head.strings_size = static_cast<std::uint32_t>(strings.size());
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) return 0;
+
+    out.write(reinterpret_cast<const char*>(&head), sizeof(head));
+    detail::writeSection(out, refs);
+    detail::writeSection(out, cells);
+    detail::writeSection(out, entries);
+    detail::writeSection(out, edges);
+    detail::writeSection(out, std::vector<char>(strings.begin(), strings.end()));
+
+    out.close();
+    return out ? names.size() : 0;
+}
+
+}
@@ -0,0 +1,54 @@
+#include "mapped_file.hpp"
+#include <fstream>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define TIMELIB_HAS_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#define TIMELIB_HAS_MMAP 0
+#endif
+
+namespace timelib {
+
+detail::MappedFile detail::MappedFile::open(const std::string& path) {
+    MappedFile file;
+
+#if TIMELIB_HAS_MMAP
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return file;
+
+    struct stat st{};
+    if (::fstat(fd, &st) != 0 || st.st_size <= 0) {
+        ::close(fd);
+        return file;
+    }
+
+    const auto size = static_cast<std::size_t>(st.st_size);
+    void* data = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (data == MAP_FAILED) return file;
+
+    file.storage_.reset(static_cast<const unsigned char*>(data),
+                        [size](const unsigned char* mapped) { ::munmap(const_cast<unsigned char*>(mapped), size); });
+#else
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    if (!in) return file;
+
+    const auto size = static_cast<std::size_t>(in.tellg());
+    if (size == 0) return file;
+
+    // whole words, so the sections come out 8-byte aligned like in a mapping
+    std::shared_ptr<std::uint64_t> buffer(new std::uint64_t[(size + 7) / 8], std::default_delete<std::uint64_t[]>());
+    in.seekg(0);
+    if (!in.read(reinterpret_cast<char*>(buffer.get()), static_cast<std::streamsize>(size))) return file;
+    file.storage_ = std::shared_ptr<const unsigned char>(buffer, reinterpret_cast<const unsigned char*>(buffer.get()));
+#endif
+
+    file.size_ = size;
+    return file;
+}
+
+}
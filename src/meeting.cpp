@@ -0,0 +1,92 @@
+#include "meeting.hpp"
+#include "compiled_zone.hpp"
+#include "resolver.hpp"
+#include <algorithm>
+#include <tuple>
+
+namespace timelib {
+
+MeetingWindows MeetingPlanner::find(const ZoneResolver& resolver, const std::vector<WorkingHours>& participants,
+                                    const date::sys_seconds begin, const date::sys_seconds end,
+                                    const std::chrono::minutes min_length) {
+    struct Group {
+        const date::time_zone* zone;
+        WorkingHours hours;
+
+        auto key() const { return std::make_tuple(zone, hours.start, hours.end, hours.weekdays); }
+    };
+
+    MeetingWindows result;
+    std::vector<Group> groups;
+    groups.reserve(participants.size());
+    for (const auto& participant : participants) {
+        const date::time_zone* zone = resolver.resolve(participant.location);
+        if (!zone) {
+            result.missing.push_back(participant.location);
+            continue;
+        }
+        groups.push_back({zone, {{}, participant.start, participant.end, participant.weekdays}});
+    }
+    if (!result.missing.empty() || groups.empty()) return result;
+
+    // people sharing an office and its hours only count once
+    std::sort(groups.begin(), groups.end(), [](const Group& a, const Group& b) { return a.key() < b.key(); });
+    groups.erase(std::unique(groups.begin(), groups.end(), [](const Group& a, const Group& b) { return a.key() == b.key(); }),
+                 groups.end());
+
+    std::vector<TimeInterval> overlap = workingIntervals(groups.front().zone, groups.front().hours, begin, end);
+    for (std::size_t i = 1; i < groups.size() && !overlap.empty(); ++i) {
+        overlap = intersect(overlap, workingIntervals(groups[i].zone, groups[i].hours, begin, end));
+    }
+
+    overlap.erase(std::remove_if(overlap.begin(), overlap.end(),
+                                 [min_length](const TimeInterval& window) { return window.length() < min_length; }),
+                  overlap.end());
+    result.windows = std::move(overlap);
+    return result;
+}
+
+std::vector<TimeInterval> MeetingPlanner::workingIntervals(const date::time_zone* zone, const WorkingHours& hours,
+                                                           const date::sys_seconds begin, const date::sys_seconds end) {
+    std::vector<TimeInterval> intervals;
+    if (!zone || begin >= end || hours.weekdays == 0) return intervals;
+
+    const std::chrono::minutes length = hours.end > hours.start ? hours.end - hours.start
+                                                                : hours.end - hours.start + std::chrono::minutes{24 * 60};
+
+    // offsets stay within a day of utc and a window is at most a day long, so these are all the
+    // local days whose window can reach into the range
+    const auto first = date::floor<date::days>(begin) - date::days{2};
+    const auto last = date::floor<date::days>(end) + date::days{1};
+    for (auto day = first; day <= last; day += date::days{1}) {
+        if (((hours.weekdays >> date::weekday{day}.c_encoding()) & 1) == 0) continue;
+
+        const date::local_seconds from = date::local_days{day.time_since_epoch()} + hours.start;
+        const auto window_begin = std::max(ZoneTables::toSys(zone, from, date::choose::earliest), begin);
+        const auto window_end = std::min(ZoneTables::toSys(zone, from + length, date::choose::earliest), end);
+        if (window_begin >= window_end) continue;
+
+        // overnight hours on consecutive days join up
+        if (!intervals.empty() && window_begin <= intervals.back().end) {
+            intervals.back().end = std::max(intervals.back().end, window_end);
+        } else {
+            intervals.push_back({window_begin, window_end});
+        }
+    }
+    return intervals;
+}
+
+std::vector<TimeInterval> MeetingPlanner::intersect(const std::vector<TimeInterval>& a, const std::vector<TimeInterval>& b) {
+    std::vector<TimeInterval> overlap;
+    std::size_t i = 0, j = 0;
+    while (i < a.size() && j < b.size()) {
+        const auto begin = std::max(a[i].begin, b[j].begin);
+        const auto end = std::min(a[i].end, b[j].end);
+        if (begin < end) overlap.push_back({begin, end});
+        if (a[i].end < b[j].end) ++i;
+        else ++j;
+    }
+    return overlap;
+}
+
+}
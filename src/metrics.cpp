@@ -0,0 +1,144 @@
+#include "metrics.hpp"
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+namespace timelib {
+
+namespace {
+
+// one flat array per thread: counters, then results by code, then per stage the buckets
+// followed by count and total
+constexpr std::size_t kStageSlots = kLatencyBuckets + 2;
+constexpr std::size_t kResultBase = kMetricCounterCount;
+constexpr std::size_t kStageBase = kResultBase + kErrorCodeCount;
+constexpr std::size_t kSlots = kStageBase + kMetricStageCount * kStageSlots;
+
+using Totals = std::array<std::uint64_t, kSlots>;
+
+struct ThreadBlock;
+
+struct Registry {
+    std::mutex mutex;
+    std::vector<const ThreadBlock*> live;
+    // what exited threads recorded
+    Totals retired{};
+    // subtracted from every snapshot, see Metrics::reset
+    Totals baseline{};
+};
+
+Registry& registry() {
+    static Registry instance;
+    return instance;
+}
+
+struct ThreadBlock {
+    std::array<std::atomic<std::uint64_t>, kSlots> values{};
+
+    ThreadBlock() {
+        auto& metrics = registry();
+        std::lock_guard lock(metrics.mutex);
+        metrics.live.push_back(this);
+    }
+
+    ~ThreadBlock() {
+        auto& metrics = registry();
+        std::lock_guard lock(metrics.mutex);
+        for (std::size_t i = 0; i < kSlots; ++i) metrics.retired[i] += values[i].load(std::memory_order_relaxed);
+        metrics.live.erase(std::find(metrics.live.begin(), metrics.live.end(), this));
+    }
+
+    // only the owning thread writes, so there's no need for a read-modify-write
+    void add(const std::size_t slot, const std::uint64_t value) {
+        auto& cell = values[slot];
+        cell.store(cell.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+    }
+};
+
+ThreadBlock& threadBlock() {
+    thread_local ThreadBlock block;
+    return block;
+}
+
+std::size_t bucketOf(const std::uint64_t ns) {
+    std::size_t bucket = 0;
+    for (std::uint64_t v = ns; v != 0 && bucket + 1 < kLatencyBuckets; v >>= 1) ++bucket;
+    return bucket;
+}
+
+// sum of every block. the caller holds the registry lock
+Totals collect(const Registry& metrics) {
+    Totals totals = metrics.retired;
+    for (const ThreadBlock* block : metrics.live) {
+        for (std::size_t i = 0; i < kSlots; ++i) totals[i] += block->values[i].load(std::memory_order_relaxed);
+    }
+    return totals;
+}
+
+}
+
+std::uint64_t StageStats::percentileNs(const double p) const {
+    if (count == 0) return 0;
+    const auto rank = static_cast<std::uint64_t>(std::clamp(p, 0.0, 1.0) * static_cast<double>(count - 1)) + 1;
+    std::uint64_t seen = 0;
+    for (std::size_t i = 0; i < kLatencyBuckets; ++i) {
+        seen += buckets[i];
+        if (seen >= rank) return std::uint64_t{1} << i;
+    }
+    return std::uint64_t{1} << (kLatencyBuckets - 1);
+}
+
+MetricsSnapshot Metrics::snapshot() {
+    MetricsSnapshot snapshot;
+    if (!enabled()) return snapshot;
+
+    auto& metrics = registry();
+    Totals totals;
+    {
+        std::lock_guard lock(metrics.mutex);
+        totals = collect(metrics);
+        for (std::size_t i = 0; i < kSlots; ++i) totals[i] -= metrics.baseline[i];
+    }
+
+    std::copy_n(totals.begin(), kMetricCounterCount, snapshot.counters.begin());
+    std::copy_n(totals.begin() + kResultBase, kErrorCodeCount, snapshot.errors.begin());
+    for (std::size_t s = 0; s < kMetricStageCount; ++s) {
+        const auto* slots = totals.data() + kStageBase + s * kStageSlots;
+        auto& stage = snapshot.stages[s];
+        std::copy_n(slots, kLatencyBuckets, stage.buckets.begin());
+        stage.count = slots[kLatencyBuckets];
+        stage.total_ns = slots[kLatencyBuckets + 1];
+    }
+    return snapshot;
+}
+
+void Metrics::reset() {
+    if (!enabled()) return;
+
+    auto& metrics = registry();
+    std::lock_guard lock(metrics.mutex);
+    metrics.baseline = collect(metrics);
+}
+
+namespace detail {
+
+void recordCount(const MetricCounter counter) {
+    threadBlock().add(static_cast<std::size_t>(counter), 1);
+}
+
+void recordResult(const ErrorCode code) {
+    threadBlock().add(kResultBase + static_cast<std::size_t>(code), 1);
+}
+
+void recordLatency(const MetricStage stage, const std::uint64_t ns) {
+    auto& block = threadBlock();
+    const std::size_t base = kStageBase + static_cast<std::size_t>(stage) * kStageSlots;
+    block.add(base + bucketOf(ns), 1);
+    block.add(base + kLatencyBuckets, 1);
+    block.add(base + kLatencyBuckets + 1, ns);
+}
+
+}
+
+}
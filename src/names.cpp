@@ -0,0 +1,47 @@
+#include "names.hpp"
+#include "location.hpp"
+#include "zones.hpp"
+#include <algorithm>
+#include <date/tz.h>
+
+namespace timelib {
+
+NameCatalog NameCatalog::builtin() {
+    NameCatalog catalog;
+    auto& entries = catalog.entries_;
+
+    for (std::size_t i = 0; i < detail::kLocationAliases.size(); ++i) {
+        const auto& key = detail::kLocationAliases[i];
+        const auto& location = detail::kBuiltinLocations[key.target];
+        const NameKind kind = detail::equalsIgnoreCase(key.key, location.official_name) ? NameKind::LocationName : NameKind::LocationAlias;
+        entries.push_back({key.key, location.timezone, location.official_name, kind});
+    }
+    for (std::size_t i = 0; i < detail::kTimezoneAliases.size(); ++i) {
+        const auto& key = detail::kTimezoneAliases[i];
+        const auto& timezone = detail::kBuiltinTimezones[key.target];
+        entries.push_back({key.key, timezone.official_name, timezone.official_name, NameKind::TimezoneAlias});
+    }
+
+    const date::tzdb* db = nullptr;
+    try {
+        db = &date::get_tzdb();
+    } catch (const std::exception&) {
+        return catalog;
+    }
+
+    const auto add_zone = [&](const std::string& name, const std::string& target) {
+        entries.push_back({name, target, target, NameKind::ZoneName});
+        std::string city = name.substr(name.find_last_of('/') + 1);
+        std::replace(city.begin(), city.end(), '_', ' ');
+        if (city != name) entries.push_back({catalog.storage_.emplace_back(std::move(city)), target, target, NameKind::ZoneCity});
+    };
+
+    for (const auto& zone : db->zones) add_zone(zone.name(), zone.name());
+#if !USE_OS_TZDB
+    for (const auto& link : db->links) add_zone(link.name(), link.target());
+#endif
+
+    return catalog;
+}
+
+}
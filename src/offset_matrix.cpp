@@ -0,0 +1,139 @@
+#include "offset_matrix.hpp"
+#include "compiled_zone.hpp"
+#include "resolver.hpp"
+#include <algorithm>
+#include <functional>
+#include <queue>
+
+namespace timelib {
+
+OffsetMatrix::OffsetMatrix(const ZoneResolver& resolver, const std::vector<std::string>& locations,
+                           const date::sys_seconds begin, const date::sys_seconds end)
+    : begin_(begin), end_(std::max<date::sys_seconds>(end, begin + std::chrono::seconds{1})) {
+    for (const auto& location : locations) {
+        const date::time_zone* zone = resolver.resolve(location);
+        if (!zone) {
+            missing_.push_back(location);
+            continue;
+        }
+        names_.push_back(location);
+        zones_.push_back(zone);
+    }
+
+    // each zone's own offset changes, walking its transitions (abbreviation-only ones included,
+    // those are dropped here)
+    first_.reserve(zones_.size() + 1);
+    for (const auto* zone : zones_) {
+        first_.push_back(static_cast<std::uint32_t>(starts_.size()));
+
+        date::sys_seconds t = begin_;
+        auto current = static_cast<std::int32_t>(ZoneTables::offsetAt(zone, t).offset.count());
+        starts_.push_back(t.time_since_epoch().count());
+        offsets_.push_back(current);
+
+        while (true) {
+            const date::sys_seconds next = ZoneTables::nextTransition(zone, t);
+            if (next >= end_ || next <= t) break;
+            t = next;
+
+            const auto offset = static_cast<std::int32_t>(ZoneTables::offsetAt(zone, t).offset.count());
+            if (offset == current) continue;
+            starts_.push_back(t.time_since_epoch().count());
+            offsets_.push_back(offset);
+            current = offset;
+        }
+    }
+    first_.push_back(static_cast<std::uint32_t>(starts_.size()));
+
+    // merge the lists, one cursor per zone on a min heap. everything changing at the same
+    // instant is looked at together
+    using Cursor = std::pair<std::int64_t, std::size_t>;
+    std::priority_queue<Cursor, std::vector<Cursor>, std::greater<>> heap;
+    std::vector<std::size_t> next(zones_.size());
+    for (std::size_t z = 0; z < zones_.size(); ++z) {
+        next[z] = first_[z] + 1;
+        if (next[z] < first_[z + 1]) heap.emplace(starts_[next[z]], z);
+    }
+
+    while (!heap.empty()) {
+        const std::int64_t at = heap.top().first;
+        DifferenceChange change{date::sys_seconds{std::chrono::seconds{at}}, {}};
+        while (!heap.empty() && heap.top().first == at) {
+            const std::size_t z = heap.top().second;
+            heap.pop();
+            const std::size_t i = next[z]++;
+            change.shifts.emplace_back(z, std::chrono::seconds{offsets_[i] - offsets_[i - 1]});
+            if (next[z] < first_[z + 1]) heap.emplace(starts_[next[z]], z);
+        }
+
+        // every difference stays the same only when all zones moved, and by the same amount
+        const bool uniform = change.shifts.size() == zones_.size() &&
+                             std::all_of(change.shifts.begin(), change.shifts.end(),
+                                         [&change](const auto& shift) { return shift.second == change.shifts.front().second; });
+        if (uniform) continue;
+
+        std::sort(change.shifts.begin(), change.shifts.end());
+        changes_.push_back(std::move(change));
+    }
+}
+
+std::size_t OffsetMatrix::intervalAt(const std::size_t zone, const std::int64_t t) const {
+    const auto first = starts_.begin() + first_[zone];
+    const auto last = starts_.begin() + first_[zone + 1];
+    // clamped into the range, the first interval starts at begin_
+    const std::int64_t clamped = std::min(t, end_.time_since_epoch().count() - 1);
+    const auto it = std::upper_bound(first + 1, last, clamped);
+    return static_cast<std::size_t>(it - starts_.begin()) - 1;
+}
+
+std::chrono::seconds OffsetMatrix::offset(const std::size_t zone, const date::sys_seconds tp) const {
+    return std::chrono::seconds{offsets_[intervalAt(zone, tp.time_since_epoch().count())]};
+}
+
+std::chrono::seconds OffsetMatrix::difference(const std::size_t a, const std::size_t b, const date::sys_seconds tp) const {
+    return offset(a, tp) - offset(b, tp);
+}
+
+void OffsetMatrix::matrixAt(const date::sys_seconds tp, std::vector<std::chrono::seconds>& out) const {
+    const std::size_t n = zones_.size();
+    const std::int64_t t = tp.time_since_epoch().count();
+
+    std::vector<std::int32_t> offsets(n);
+    for (std::size_t z = 0; z < n; ++z) offsets[z] = offsets_[intervalAt(z, t)];
+
+    out.resize(n * n);
+    for (std::size_t a = 0; a < n; ++a) {
+        for (std::size_t b = 0; b < n; ++b) out[a * n + b] = std::chrono::seconds{offsets[a] - offsets[b]};
+    }
+}
+
+std::vector<std::chrono::seconds> OffsetMatrix::matrixAt(const date::sys_seconds tp) const {
+    std::vector<std::chrono::seconds> out;
+    matrixAt(tp, out);
+    return out;
+}
+
+std::vector<date::sys_seconds> OffsetMatrix::changesBetween(const std::size_t a, const std::size_t b) const {
+    std::vector<date::sys_seconds> instants;
+    std::size_t i = first_[a] + 1;
+    std::size_t j = first_[b] + 1;
+    while (i < first_[a + 1] || j < first_[b + 1]) {
+        const std::int64_t at = std::min(i < first_[a + 1] ? starts_[i] : end_.time_since_epoch().count(),
+                                         j < first_[b + 1] ? starts_[j] : end_.time_since_epoch().count());
+
+        std::int32_t shift_a = 0;
+        std::int32_t shift_b = 0;
+        if (i < first_[a + 1] && starts_[i] == at) {
+            shift_a = offsets_[i] - offsets_[i - 1];
+            ++i;
+        }
+        if (j < first_[b + 1] && starts_[j] == at) {
+            shift_b = offsets_[j] - offsets_[j - 1];
+            ++j;
+        }
+        if (shift_a != shift_b) instants.emplace_back(std::chrono::seconds{at});
+    }
+    return instants;
+}
+
+}
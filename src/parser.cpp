@@ -0,0 +1,487 @@
+#include "parser.hpp"
+#include "metrics.hpp"
+#include <algorithm>
+#include <cctype>
+
+namespace timelib {
+
+namespace {
+
+constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+constexpr std::string_view kMeetingAsks[][2] = {{"find", ""}, {"show", ""}, {"when", "can"}};
+constexpr std::string_view kMeetingLeads[][2] = {{"meeting", "windows"}, {"meeting", "window"}, {"meeting", "times"},
+                                                 {"meeting", "time"}, {"meeting", ""}, {"meet", ""}, {"overlap", ""},
+                                                 {"overlapping", ""}};
+constexpr std::string_view kMeetingLinks[] = {"in", "for", "between", "across", "with"};
+constexpr std::string_view kMeetingHourJoins[] = {"to", "-", "until", "till"};
+constexpr std::string_view kMeetingJoins[] = {"and", "&"};
+constexpr std::string_view kMeetingFillers[] = {"on", "for", "during", "over"};
+
+constexpr std::string_view kDifferenceLeads[][2] = {{"what's", ""}, {"whats", ""}, {"wats", ""}, {"what", "is"}};
+constexpr std::string_view kDifferenceHeads[] = {"time", "times"};
+constexpr std::string_view kDifferenceKinds[] = {"difference", "diff", "offset"};
+constexpr std::string_view kDifferenceStarts[] = {"between", "b/w", "from"};
+constexpr std::string_view kDifferenceJoins[] = {"and", "&", "to", "2"};
+
+constexpr std::string_view kConversionVerbs[][2] = {{"convert", ""}, {"change", ""}, {"switch", ""}, {"make", ""}, {"what", "is"}, {"whats", ""}};
+constexpr std::string_view kConversionSources[] = {"from", "frm", "in", "at"};
+constexpr std::string_view kConversionTargets[] = {"to", "2", "in", "as"};
+constexpr std::string_view kImplicitSources[] = {"in", "at"};
+constexpr std::string_view kImplicitTargets[] = {"to", "as", "in"};
+
+constexpr std::string_view kQueryLeads[][2] = {{"what", "is"}, {"what's", ""}, {"whats", ""}, {"wats", ""}, {"tell", "me"}, {"show", "me"}};
+constexpr std::string_view kQueryModifiers[] = {"current", "local"};
+constexpr std::string_view kQueryLinks[] = {"in", "at", "for", "of"};
+
+bool isSpace(const char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f' || c == '\v';
+}
+
+bool isDigit(const char c) {
+    return c >= '0' && c <= '9';
+}
+
+char toLower(const char c) {
+    return static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+}
+
+// `lower` is always one of the keyword literals above, so only the input side needs folding
+bool equalsIgnoreCase(const std::string_view text, const std::string_view lower) {
+    if (text.size() != lower.size()) return false;
+    for (std::size_t i = 0; i < text.size(); ++i) {
+        if (toLower(text[i]) != lower[i]) return false;
+    }
+    return true;
+}
+
+template <std::size_t N>
+bool isOneOf(const std::string_view text, const std::string_view (&words)[N]) {
+    return std::any_of(std::begin(words), std::end(words),
+                       [text](const std::string_view word) { return equalsIgnoreCase(text, word); });
+}
+
+// number of tokens used by the first phrase matching at `at`, 0 when none does
+template <std::size_t N>
+std::size_t matchPhrase(const QueryLexer& tokens, const std::size_t at, const std::string_view (&phrases)[N][2]) {
+    for (const auto& phrase : phrases) {
+        const std::size_t length = phrase[1].empty() ? 1 : 2;
+        if (at + length > tokens.size()) continue;
+        if (!equalsIgnoreCase(tokens[at].text, phrase[0])) continue;
+        if (length == 2 && !equalsIgnoreCase(tokens[at + 1].text, phrase[1])) continue;
+        return length;
+    }
+    return 0;
+}
+
+// first index in [from, to) whose token is one of `words`
+template <std::size_t N>
+std::size_t findWord(const QueryLexer& tokens, const std::size_t from, const std::size_t to,
+                     const std::string_view (&words)[N]) {
+    for (std::size_t i = from; i < to; ++i) {
+        if (isOneOf(tokens[i].text, words)) return i;
+    }
+    return npos;
+}
+
+// "<time> <source word> <a> <target word> <b>" starting at `start`, every part at least one word.
+// the regexes used lazy groups here, which is the same as taking the earliest source word that
+// still leaves room for a target word, then the earliest such target word.
+template <std::size_t S, std::size_t T>
+bool splitConversion(const QueryLexer& tokens, const std::size_t start,
+                     const std::string_view (&sources)[S], const std::string_view (&targets)[T],
+                     std::size_t& source, std::size_t& target) {
+    const std::size_t last = tokens.size() - 1;
+    for (std::size_t i = start + 1; i < last; ++i) {
+        if (!isOneOf(tokens[i].text, sources)) continue;
+        if (const std::size_t j = findWord(tokens, i + 2, last, targets); j != npos) {
+            source = i;
+            target = j;
+            return true;
+        }
+    }
+    return false;
+}
+
+}
+
+QueryLexer::QueryLexer(const std::string_view input) : input_(input) {
+    Token token;
+    std::size_t pos = 0;
+    while (next(input, pos, token)) {
+        if (count_ == kMaxTokens) {
+            overflow_ = true;
+            return;
+        }
+        tokens_[count_++] = token;
+        pos = token.offset + token.text.size();
+    }
+}
+
+QueryLexer::QueryLexer(const std::string_view input, const std::vector<Token>& tokens) : input_(input) {
+    overflow_ = tokens.size() > kMaxTokens;
+    count_ = std::min(tokens.size(), kMaxTokens);
+    std::copy_n(tokens.begin(), count_, tokens_.begin());
+}
+
+bool QueryLexer::next(const std::string_view input, std::size_t pos, Token& token) {
+    while (pos < input.size() && isSpace(input[pos])) ++pos;
+    if (pos == input.size()) return false;
+
+    const std::size_t start = pos;
+    while (pos < input.size() && !isSpace(input[pos])) ++pos;
+    token = {input.substr(start, pos - start), start};
+    return true;
+}
+
+std::string_view QueryLexer::span(const std::size_t first, const std::size_t last) const {
+    if (first >= last) return {};
+    const std::size_t begin = tokens_[first].offset;
+    const std::size_t end = tokens_[last - 1].offset + tokens_[last - 1].text.size();
+    return input_.substr(begin, end - begin);
+}
+
+ParsedQuery QueryParser::parse(const std::string_view input) {
+    return parse(QueryLexer(input));
+}
+
+ParsedQuery QueryParser::parse(const QueryLexer& tokens) {
+    TIMELIB_METRIC_TIME(Parse);
+    ParsedQuery query;
+    if (!tokens.ok() || tokens.size() < 2) {
+        TIMELIB_METRIC_COUNT(ParseRejected);
+        return query;
+    }
+
+    if (parseMeeting(tokens, query)) {
+        TIMELIB_METRIC_COUNT(ParseMeeting);
+        return query;
+    }
+    if (parseDifference(tokens, query)) {
+        TIMELIB_METRIC_COUNT(ParseDifference);
+        return query;
+    }
+    if (parseConversion(tokens, query)) {
+        TIMELIB_METRIC_COUNT(ParseConversion);
+        return query;
+    }
+    if (parseImplicitConversion(tokens, query)) {
+        TIMELIB_METRIC_COUNT(ParseImplicitConversion);
+        return query;
+    }
+    if (parseQuery(tokens, query)) {
+        TIMELIB_METRIC_COUNT(ParseQueryForm);
+        return query;
+    }
+
+    TIMELIB_METRIC_COUNT(ParseRejected);
+    query.is_valid = false;
+    return query;
+}
+
+// "[find|show|when can we] [a|the] <lead> [hours] <link> <a>, <b> and <c> [span]", the hours
+// being "9am-5pm", "9 to 5", "from 8:30 to 17" and so on, 9 to 5 when left out
+bool QueryParser::parseMeeting(const QueryLexer& tokens, ParsedQuery& query) {
+    const std::size_t n = tokens.size();
+    std::size_t i = matchPhrase(tokens, 0, kMeetingAsks);
+    if (i == 2 && i < n && equalsIgnoreCase(tokens[i].text, "we")) ++i;
+    if (i < n && (equalsIgnoreCase(tokens[i].text, "a") || equalsIgnoreCase(tokens[i].text, "the"))) ++i;
+
+    const std::size_t lead = matchPhrase(tokens, i, kMeetingLeads);
+    if (lead == 0) return false;
+    const std::size_t start = i + lead;
+    const std::size_t link = findWord(tokens, start, n - 1, kMeetingLinks);
+    if (link == npos) return false;
+
+    // the days go last: "today", "tomorrow", "this week", "next week", maybe after "on"/"for"
+    std::size_t end = n;
+    if (end - link > 2 && equalsIgnoreCase(tokens[end - 1].text, "week") &&
+        (equalsIgnoreCase(tokens[end - 2].text, "this") || equalsIgnoreCase(tokens[end - 2].text, "next"))) {
+        query.span = equalsIgnoreCase(tokens[end - 2].text, "this") ? MeetingSpan::ThisWeek : MeetingSpan::NextWeek;
+        end -= 2;
+    } else if (end - link > 1 && equalsIgnoreCase(tokens[end - 1].text, "today")) {
+        query.span = MeetingSpan::Today;
+        --end;
+    } else if (end - link > 1 && equalsIgnoreCase(tokens[end - 1].text, "tomorrow")) {
+        query.span = MeetingSpan::Tomorrow;
+        --end;
+    }
+    if (end < n && end - link > 1 && isOneOf(tokens[end - 1].text, kMeetingFillers)) --end;
+
+    query.type = QueryType::Meeting;
+    std::size_t first = link + 1;
+    for (std::size_t j = first; j <= end; ++j) {
+        if (j < end && !isOneOf(tokens[j].text, kMeetingJoins)) continue;
+        // commas can stick to a word ("london,nyc") or stand alone
+        const std::string_view words = tokens.span(first, j);
+        std::size_t from = 0;
+        while (from <= words.size()) {
+            const std::size_t comma = std::min(words.find(',', from), words.size());
+            if (std::string location = normalizeLocation(words.substr(from, comma - from)); !location.empty()) {
+                query.locations.push_back(std::move(location));
+            }
+            from = comma + 1;
+        }
+        first = j + 1;
+    }
+    if (query.locations.empty()) return true;
+    query.location_a = query.locations.front();
+    if (query.locations.size() > 1) query.location_b = query.locations[1];
+
+    std::size_t hours = start;
+    if (hours < link && equalsIgnoreCase(tokens[hours].text, "from")) ++hours;
+    if (hours == link) {
+        query.hour = 9;
+        query.minute = 0;
+        query.end_hour = 17;
+        query.end_minute = 0;
+    } else {
+        std::string_view from_text, to_text;
+        if (const std::size_t join = findWord(tokens, hours + 1, link - 1, kMeetingHourJoins); join != npos) {
+            from_text = tokens.span(hours, join);
+            to_text = tokens.span(join + 1, link);
+        } else {
+            const std::string_view text = tokens.span(hours, link);
+            const std::size_t dash = text.find('-');
+            if (dash == std::string_view::npos) return true;
+            from_text = text.substr(0, dash);
+            to_text = text.substr(dash + 1);
+        }
+
+        ParsedQuery to;
+        parseTimeString(from_text, query);
+        parseTimeString(to_text, to);
+        query.end_hour = to.hour;
+        query.end_minute = to.minute;
+
+        // "9-5" means 9am to 5pm, an end without am/pm before the start is taken as afternoon
+        const auto hasMeridiem = [](const std::string_view text) {
+            for (std::size_t k = 0; k + 1 < text.size(); ++k) {
+                if ((toLower(text[k]) == 'a' || toLower(text[k]) == 'p') && toLower(text[k + 1]) == 'm') return true;
+            }
+            return equalsIgnoreCase(text, "noon") || equalsIgnoreCase(text, "midnight");
+        };
+        if (query.end_hour >= 0 && query.end_hour < 12 && query.end_hour < query.hour && !hasMeridiem(to_text)) {
+            query.end_hour += 12;
+        }
+    }
+
+    query.is_valid = isValidTime(query.hour, query.minute) && isValidTime(query.end_hour, query.end_minute);
+    return true;
+}
+
+bool QueryParser::parseDifference(const QueryLexer& tokens, ParsedQuery& query) {
+    const std::size_t n = tokens.size();
+    std::size_t i = matchPhrase(tokens, 0, kDifferenceLeads);
+    if (i < n && equalsIgnoreCase(tokens[i].text, "the")) ++i;
+
+    if (i + 3 >= n) return false;
+    if (!isOneOf(tokens[i].text, kDifferenceHeads)) return false;
+    if (!isOneOf(tokens[i + 1].text, kDifferenceKinds)) return false;
+    if (!isOneOf(tokens[i + 2].text, kDifferenceStarts)) return false;
+
+    const std::size_t start = i + 3;
+    const std::size_t join = findWord(tokens, start + 1, n - 1, kDifferenceJoins);
+    if (join == npos) return false;
+
+    query.type = QueryType::Difference;
+    query.location_a = normalizeLocation(tokens.span(start, join));
+    query.location_b = normalizeLocation(tokens.span(join + 1, n));
+    query.is_valid = true;
+    return true;
+}
+
+bool QueryParser::parseConversion(const QueryLexer& tokens, ParsedQuery& query) {
+    const std::size_t start = matchPhrase(tokens, 0, kConversionVerbs);
+    if (start == 0) return false;
+
+    std::size_t source = 0, target = 0;
+    if (!splitConversion(tokens, start, kConversionSources, kConversionTargets, source, target)) return false;
+
+    query.type = QueryType::Conversion;
+    parseTimeString(tokens.span(start, source), query);
+    query.location_a = normalizeLocation(tokens.span(source + 1, target));
+    query.location_b = normalizeLocation(tokens.span(target + 1, tokens.size()));
+    query.is_valid = isValidTime(query.hour, query.minute);
+    return true;
+}
+
+bool QueryParser::parseImplicitConversion(const QueryLexer& tokens, ParsedQuery& query) {
+    std::size_t source = 0, target = 0;
+    if (!splitConversion(tokens, 0, kImplicitSources, kImplicitTargets, source, target)) return false;
+
+    parseTimeString(tokens.span(0, source), query);
+    if (!isValidTime(query.hour, query.minute)) {
+        query = ParsedQuery();
+        return false;
+    }
+
+    query.type = QueryType::Conversion;
+    query.location_a = normalizeLocation(tokens.span(source + 1, target));
+    query.location_b = normalizeLocation(tokens.span(target + 1, tokens.size()));
+    query.is_valid = true;
+    return true;
+}
+
+bool QueryParser::parseQuery(const QueryLexer& tokens, ParsedQuery& query) {
+    const std::size_t n = tokens.size();
+
+    // the lead-in words are all optional, and the regex backtracked over them when taking one
+    // left nothing to link the time and location, so try them in that same order
+    const std::size_t lead = matchPhrase(tokens, 0, kQueryLeads);
+    for (int take_lead = lead != 0; take_lead >= 0; --take_lead) {
+        const std::size_t after_lead = take_lead ? lead : 0;
+        const bool has_the = after_lead < n && equalsIgnoreCase(tokens[after_lead].text, "the");
+
+        for (int take_the = has_the; take_the >= 0; --take_the) {
+            const std::size_t after_the = after_lead + take_the;
+            const bool has_modifier = after_the < n && isOneOf(tokens[after_the].text, kQueryModifiers);
+
+            for (int take_modifier = has_modifier; take_modifier >= 0; --take_modifier) {
+                const std::size_t start = after_the + take_modifier;
+                const std::size_t link = findWord(tokens, start + 1, n - 1, kQueryLinks);
+                if (link == npos) continue;
+
+                const std::string_view time_keyword = tokens.span(start, link);
+                if (equalsIgnoreCase(time_keyword, "time") || equalsIgnoreCase(time_keyword, "now")) {
+                    query.type = QueryType::CurrentTime;
+                    query.location_a = normalizeLocation(tokens.span(link + 1, n));
+                    query.is_valid = true;
+                    return true;
+                }
+
+                query.type = QueryType::Conversion;
+                parseTimeString(time_keyword, query);
+                query.location_b = normalizeLocation(tokens.span(link + 1, n));
+                try {
+                    query.location_a = date::current_zone()->name();
+                } catch (const std::exception&) {
+                    query.is_valid = false;
+                    return true;
+                }
+                query.is_valid = isValidTime(query.hour, query.minute);
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void QueryParser::parseTimeString(const std::string_view time_str, ParsedQuery& result) {
+    if (equalsIgnoreCase(time_str, "noon")) { result.hour = 12; result.minute = 0; return; }
+    if (equalsIgnoreCase(time_str, "midnight")) { result.hour = 0; result.minute = 0; return; }
+
+    // first "h[h][:mm][ ][am|pm]" anywhere in the string
+    std::size_t pos = 0;
+    while (pos < time_str.size() && !isDigit(time_str[pos])) ++pos;
+    if (pos == time_str.size()) {
+        result.hour = -1;
+        return;
+    }
+
+    int hour = time_str[pos++] - '0';
+    if (pos < time_str.size() && isDigit(time_str[pos])) hour = hour * 10 + (time_str[pos++] - '0');
+    if (hour > 24) return;
+
+    int minute = 0;
+    if (pos + 2 < time_str.size() && time_str[pos] == ':' && isDigit(time_str[pos + 1]) && isDigit(time_str[pos + 2])) {
+        const int parsed = (time_str[pos + 1] - '0') * 10 + (time_str[pos + 2] - '0');
+        minute = parsed <= 59 ? parsed : 0;
+        pos += 3;
+    }
+
+    result.hour = hour;
+    result.minute = minute;
+
+    while (pos < time_str.size() && isSpace(time_str[pos])) ++pos;
+    if (pos + 1 < time_str.size() && toLower(time_str[pos + 1]) == 'm') {
+        if (const char marker = toLower(time_str[pos]); marker == 'p' && result.hour != 12) result.hour += 12;
+        else if (marker == 'a' && result.hour == 12) result.hour = 0;
+    }
+}
+
+bool QueryParser::isValidTime(const int hour, const int minute) {
+    return hour >= 0 && hour < 24 && minute >= 0 && minute < 60;
+}
+
+std::string QueryParser::normalizeLocation(const std::string_view location) {
+    const std::size_t first = location.find_first_not_of(" \t\n\r\f\v");
+    if (first == std::string_view::npos) return {};
+    const std::size_t last = location.find_last_not_of(" \t\n\r\f\v");
+
+    std::string normalized(location.substr(first, last - first + 1));
+    std::transform(normalized.begin(), normalized.end(), normalized.begin(), ::tolower);
+    return normalized;
+}
+
+IncrementalParser::IncrementalParser() : IncrementalParser([]() -> const PrefixIndex& {
+    static const PrefixIndex index = PrefixIndex::builtin();
+    return index;
+}()) {}
+
+IncrementalParser::IncrementalParser(const PrefixIndex& index) : index_(&index) {}
+
+const ParsedQuery& IncrementalParser::update(const std::string_view text) {
+    const auto mismatch = std::mismatch(input_.begin(), input_.end(), text.begin(), text.end());
+    const auto common = static_cast<std::size_t>(mismatch.first - input_.begin());
+
+    const char* old_data = input_.data();
+    input_.replace(common, std::string::npos, text.substr(common));
+
+    // a token ending right where the edit starts may have grown, so it goes too
+    while (!tokens_.empty() && tokens_.back().offset + tokens_.back().text.size() >= common) tokens_.pop_back();
+    if (input_.data() != old_data) {
+        for (auto& token : tokens_) token.text = std::string_view(input_).substr(token.offset, token.text.size());
+    }
+
+    Token token;
+    std::size_t pos = tokens_.empty() ? 0 : tokens_.back().offset + tokens_.back().text.size();
+    while (QueryLexer::next(input_, pos, token)) {
+        tokens_.push_back(token);
+        pos = token.offset + token.text.size();
+    }
+
+    reparse();
+    return query_;
+}
+
+const ParsedQuery& IncrementalParser::append(const std::string_view text) {
+    std::string next = input_;
+    next.append(text);
+    return update(next);
+}
+
+void IncrementalParser::clear() {
+    input_.clear();
+    tokens_.clear();
+    query_ = ParsedQuery();
+    parsed_.clear();
+}
+
+void IncrementalParser::reparse() {
+    const std::string_view words = tokens_.empty() ? std::string_view() :
+        std::string_view(input_).substr(tokens_.front().offset,
+                                        tokens_.back().offset + tokens_.back().text.size() - tokens_.front().offset);
+    if (words == parsed_) return;
+
+    parsed_.assign(words);
+    query_ = QueryParser::parse(QueryLexer(input_, tokens_));
+}
+
+std::vector<Completion> IncrementalParser::completions(const std::size_t k) const {
+    const std::size_t n = tokens_.size();
+    for (std::size_t i = 0; i + 1 < n; ++i) {
+        const std::string_view word = tokens_[i].text;
+        if (!isOneOf(word, kDifferenceStarts) && !isOneOf(word, kDifferenceJoins) && !isOneOf(word, kConversionSources) &&
+            !isOneOf(word, kConversionTargets) && !isOneOf(word, kQueryLinks)) {
+            continue;
+        }
+
+        // trailing whitespace is kept, "san " should only offer multi word names
+        auto found = index_->complete(std::string_view(input_).substr(tokens_[i + 1].offset), k);
+        if (!found.empty()) return found;
+    }
+    return {};
+}
+
+}
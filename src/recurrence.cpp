@@ -0,0 +1,244 @@
+#include "recurrence.hpp"
+#include "compiled_zone.hpp"
+#include <algorithm>
+
+namespace timelib {
+
+namespace {
+
+// utc offsets stay well inside a day, so a local time is always within this of its instant
+constexpr std::int64_t kMaxOffset = 26 * 3600;
+
+// date's calendar stops at year 32767, an endless rule stops well before that
+const date::local_days kLastDay{date::year_month_day{date::year{9999}, date::December, date::day{31}}};
+// how far from the start a period can begin before the day count is past any year that matters
+constexpr std::int64_t kMaxDays = 10000 * 366;
+
+bool onWeekday(const std::uint8_t weekdays, const date::local_days day) {
+    return ((weekdays >> date::weekday{day}.c_encoding()) & 1) != 0;
+}
+
+}
+
+Recurrence::Recurrence(const date::time_zone* zone, const date::local_days start, const RecurrenceRule& rule) {
+    auto& normalized = source_.rule;
+    normalized = rule;
+    normalized.interval = std::max<std::uint32_t>(normalized.interval, 1);
+    normalized.weekdays &= 0x7f;
+    if (normalized.frequency == Frequency::Weekly && normalized.weekdays == 0) {
+        normalized.weekdays = static_cast<std::uint8_t>(1u << date::weekday{start}.c_encoding());
+    }
+
+    const date::year_month_day first{start};
+    if (normalized.month_day == 0) normalized.month_day = static_cast<int>(static_cast<unsigned>(first.day()));
+
+    source_.zone = zone;
+    source_.start = start;
+    source_.first_week = start - (date::weekday{start} - date::Monday);
+    source_.first_month = date::year_month_day{first.year(), first.month(), date::day{1}};
+    if (zone) source_.table = ZoneTables::find(zone);
+}
+
+std::vector<date::sys_seconds> Recurrence::expand(const std::size_t limit) const {
+    std::vector<date::sys_seconds> occurrences;
+    for (auto it = begin(); it != end() && occurrences.size() < limit; ++it) occurrences.push_back(*it);
+    return occurrences;
+}
+
+std::vector<date::sys_seconds> Recurrence::between(const date::sys_seconds from, const date::sys_seconds to) const {
+    std::vector<date::sys_seconds> occurrences;
+    if (!source_.zone || from >= to) return occurrences;
+
+    // an occurrence is within kMaxOffset of its wall time, so no period that ends before that
+    // much ahead of `from` can reach it. with a count they're counted from the start though
+    std::int64_t period = 0;
+    if (source_.rule.count == 0) {
+        const std::int64_t earliest = from.time_since_epoch().count() - kMaxOffset;
+        if (earliest > date::local_seconds{kLastDay + date::days{1}}.time_since_epoch().count()) return occurrences;
+        if (earliest > date::local_seconds{source_.start}.time_since_epoch().count()) {
+            period = periodOf(date::floor<date::days>(date::local_seconds{std::chrono::seconds{earliest}}));
+        }
+    }
+
+    for (iterator it(source_, period); it != end() && *it < to; ++it) {
+        if (*it >= from) occurrences.push_back(*it);
+    }
+    return occurrences;
+}
+
+std::int64_t Recurrence::periodOf(const date::local_days day) const {
+    // days, weeks or months from the first period to the one `day` is in. a period that skips
+    // over `day` (every other week, say) is the one before it, which only costs a look at it
+    std::int64_t elapsed = 0;
+    switch (source_.rule.frequency) {
+        case Frequency::Daily: elapsed = (day - source_.start).count(); break;
+        case Frequency::Weekly: elapsed = (day - source_.first_week).count() / 7; break;
+        case Frequency::Monthly: {
+            const date::year_month_day ymd{day};
+            elapsed = (static_cast<int>(ymd.year()) - static_cast<int>(source_.first_month.year())) * 12 +
+                      static_cast<int>(static_cast<unsigned>(ymd.month())) - static_cast<int>(static_cast<unsigned>(source_.first_month.month()));
+            break;
+        }
+    }
+    return elapsed <= 0 ? 0 : elapsed / source_.rule.interval;
+}
+
+Recurrence::iterator::iterator(const Source& source, const std::int64_t period)
+    : source_(source), done_(!source.zone), period_(period) {
+    if (!done_) advance();
+}
+
+void Recurrence::iterator::advance() {
+    const auto& rule = source_.rule;
+    if (rule.count != 0 && produced_ == rule.count) {
+        done_ = true;
+        return;
+    }
+
+    while (true) {
+        if (next_day_ == day_count_) {
+            if (empty_periods_ == kMaxEmptyPeriods) {
+                done_ = true;
+                return;
+            }
+            fillPeriod();
+            if (done_) return;
+            ++empty_periods_;
+            continue;
+        }
+
+        const date::local_days day = days_[next_day_++];
+        if (day < source_.start) continue;
+
+        const auto occurrence = toSys(date::local_seconds{day} + rule.time);
+        if (!occurrence) continue;
+        if (rule.until && *occurrence > *rule.until) {
+            done_ = true;
+            return;
+        }
+
+        current_ = *occurrence;
+        ++produced_;
+        empty_periods_ = 0;
+        return;
+    }
+}
+
+void Recurrence::iterator::fillPeriod() {
+    const auto& rule = source_.rule;
+    // days (months for Monthly) from the first period to this one
+    const std::int64_t step = period_++ * rule.interval * (rule.frequency == Frequency::Weekly ? 7 : 1);
+    day_count_ = 0;
+    next_day_ = 0;
+    if (step > kMaxDays) {
+        done_ = true;
+        return;
+    }
+
+    switch (rule.frequency) {
+        case Frequency::Daily: {
+            const date::local_days day = source_.start + date::days{static_cast<int>(step)};
+            if (day > kLastDay) break;
+            if (rule.weekdays == 0 || onWeekday(rule.weekdays, day)) days_[day_count_++] = day;
+            return;
+        }
+        case Frequency::Weekly: {
+            const date::local_days monday = source_.first_week + date::days{static_cast<int>(step)};
+            if (monday > kLastDay) break;
+            for (int i = 0; i < 7; ++i) {
+                const date::local_days day = monday + date::days{i};
+                if (onWeekday(rule.weekdays, day)) days_[day_count_++] = day;
+            }
+            return;
+        }
+        case Frequency::Monthly: {
+            const auto first = source_.first_month + date::months{static_cast<int>(step)};
+            if (first.year() > date::year{9999}) break;
+            const auto last = static_cast<int>(static_cast<unsigned>(
+                date::year_month_day_last{first.year(), date::month_day_last{first.month()}}.day()));
+            const date::local_days day_one{first};
+
+            if (rule.weekdays == 0) {
+                const int day = rule.month_day > 0 ? rule.month_day : last + 1 + rule.month_day;
+                if (day >= 1 && day <= last) days_[day_count_++] = day_one + date::days{day - 1};
+                return;
+            }
+
+            // with an ordinal, the n-th of each weekday: the day's week of the month counted
+            // from the front, or from the back
+            for (int i = 0; i < last; ++i) {
+                const date::local_days day = day_one + date::days{i};
+                if (!onWeekday(rule.weekdays, day)) continue;
+                if (rule.ordinal > 0 && i / 7 + 1 != rule.ordinal) continue;
+                if (rule.ordinal < 0 && (last - 1 - i) / 7 + 1 != -rule.ordinal) continue;
+                days_[day_count_++] = day;
+            }
+            return;
+        }
+    }
+
+    // ran off the end of the calendar
+    done_ = true;
+}
+
+std::optional<date::sys_seconds> Recurrence::iterator::toSys(const date::local_seconds local) {
+    const auto& rule = source_.rule;
+    const CompiledZone* table = source_.table;
+    const std::int64_t l = local.time_since_epoch().count();
+
+    if (table && !table->starts().empty() && l - kMaxOffset >= table->rangeBegin() && l + kMaxOffset < table->rangeEnd()) {
+        const auto& starts = table->starts();
+        const auto& offsets = table->offsets();
+
+        // occurrences only move forward, so the interval does too. the first one is found by a
+        // search, after that it's a step now and then
+        if (!positioned_) {
+            const auto it = std::upper_bound(starts.begin(), starts.end(), l - kMaxOffset);
+            interval_ = static_cast<std::size_t>(std::max<std::ptrdiff_t>(it - starts.begin() - 1, 0));
+            positioned_ = true;
+        }
+
+        while (true) {
+            const std::int64_t offset = offsets[interval_];
+            if (interval_ + 1 == starts.size()) return date::sys_seconds{std::chrono::seconds{l - offset}};
+
+            // the wall clock runs up to `transition + offset` in this interval and starts again
+            // at `transition + next` in the next one
+            const std::int64_t transition = starts[interval_ + 1];
+            const std::int64_t next = offsets[interval_ + 1];
+            if (l < transition + offset) {
+                if (l >= transition + next && rule.overlap == OverlapPolicy::Latest) {
+                    return date::sys_seconds{std::chrono::seconds{l - next}};
+                }
+                return date::sys_seconds{std::chrono::seconds{l - offset}};
+            }
+            if (l < transition + next) {
+                switch (rule.gap) {
+                    case GapPolicy::ShiftForward: return date::sys_seconds{std::chrono::seconds{l - offset}};
+                    case GapPolicy::Transition: return date::sys_seconds{std::chrono::seconds{transition}};
+                    case GapPolicy::Skip: return std::nullopt;
+                }
+            }
+            ++interval_;
+        }
+    }
+
+    const auto info = source_.zone->get_info(local);
+    switch (info.result) {
+        case date::local_info::unique:
+            return date::sys_seconds{local.time_since_epoch() - info.first.offset};
+        case date::local_info::ambiguous:
+            return date::sys_seconds{local.time_since_epoch() -
+                                     (rule.overlap == OverlapPolicy::Latest ? info.second.offset : info.first.offset)};
+        case date::local_info::nonexistent:
+        default:
+            switch (rule.gap) {
+                case GapPolicy::ShiftForward: return date::sys_seconds{local.time_since_epoch() - info.first.offset};
+                case GapPolicy::Transition: return date::floor<std::chrono::seconds>(info.first.end);
+                case GapPolicy::Skip: return std::nullopt;
+            }
+    }
+    return std::nullopt;
+}
+
+}
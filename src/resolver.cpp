@@ -0,0 +1,240 @@
+#include "resolver.hpp"
+#include "compiled_zone.hpp"
+#include "metrics.hpp"
+#include "parser.hpp"
+#include <algorithm>
+#include <array>
+#include <mutex>
+
+namespace timelib {
+
+namespace {
+
+const date::tzdb* loadedTzdb() {
+    try {
+        return &date::get_tzdb();
+    } catch (const std::exception&) {
+        return nullptr;
+    }
+}
+
+bool isSpace(const char c) {
+    return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+// what QueryParser::normalizeLocation would return unchanged
+bool isNormalized(const std::string_view location) {
+    if (location.empty()) return true;
+    if (isSpace(location.front()) || isSpace(location.back())) return false;
+    return std::none_of(location.begin(), location.end(), [](const char c) { return c >= 'A' && c <= 'Z'; });
+}
+
+}
+
+ZoneResolver::ZoneResolver() {
+    publish(std::make_shared<const LookupSnapshot>(loadedTzdb(), LocationMap{}, TimezoneMap{}, FuzzyOptions{}));
+}
+
+const date::time_zone* ZoneResolver::resolve(const std::string_view location) const {
+    TIMELIB_METRIC_TIME(Resolve);
+    const LookupSnapshot& snapshot = current();
+    if (const auto* zone = snapshot.cached(location)) {
+        TIMELIB_METRIC_COUNT(ResolveCacheHit);
+        return zone;
+    }
+
+    const date::time_zone* zone = resolveIn(snapshot, location);
+    if (zone) snapshot.remember(location, zone);
+    return zone;
+}
+
+const date::time_zone* ZoneResolver::resolveUncached(const std::string_view location) const {
+    return resolveIn(current(), location);
+}
+
+const date::time_zone* ZoneResolver::resolveIn(const LookupSnapshot& snapshot, const std::string_view location) {
+    if (const auto* zone = snapshot.findZone(location)) {
+        TIMELIB_METRIC_COUNT(ResolveZoneName);
+        return zone;
+    }
+
+    // names from the parser are trimmed and lowercased already, those aren't copied again
+    std::string normalized;
+    std::string_view lower_loc = location;
+    if (!isNormalized(location)) lower_loc = normalized = QueryParser::normalizeLocation(location);
+
+    if (const auto timezone = snapshot.locations().findTimezone(lower_loc, false); !timezone.empty()) {
+        TIMELIB_METRIC_COUNT(ResolveLocationAlias);
+        return snapshot.findZone(timezone);
+    }
+    if (const auto official_name = snapshot.timezones().findOfficialName(lower_loc); !official_name.empty()) {
+        TIMELIB_METRIC_COUNT(ResolveTimezoneAlias);
+        return snapshot.findZone(official_name);
+    }
+    // the gazetteer comes after the abbreviations, its alternate names are full of codes ("ist",
+    // "cet") that would otherwise win over the timezone they stand for
+    if (const auto& gazetteer = snapshot.locations().gazetteer()) {
+        if (const std::uint32_t place = gazetteer->find(lower_loc); place != Gazetteer::kNone) {
+            TIMELIB_METRIC_COUNT(ResolveGazetteer);
+            return snapshot.findZone(gazetteer->timezone(place));
+        }
+    }
+
+    // "51.5,-0.12" only means something with an index loaded, otherwise it goes on to the
+    // fuzzy matcher like any other unknown name (and misses there)
+    if (const auto& geo = snapshot.geoIndex()) {
+        if (const auto coordinate = GeoIndex::parseCoordinate(lower_loc)) {
+            TIMELIB_METRIC_COUNT(ResolveCoordinates);
+            return geo->lookup(coordinate->latitude, coordinate->longitude);
+        }
+    }
+
+    if (const auto& options = snapshot.fuzzyOptions(); options.enabled) {
+        if (const auto match = snapshot.fuzzyMatcher().best(lower_loc, options)) {
+            TIMELIB_METRIC_COUNT(ResolveFuzzy);
+            return snapshot.findZone(match->timezone);
+        }
+    }
+
+    TIMELIB_METRIC_COUNT(ResolveMiss);
+    return nullptr;
+}
+
+std::shared_ptr<const LookupSnapshot> ZoneResolver::snapshot() const {
+    return std::atomic_load_explicit(&snapshot_, std::memory_order_acquire);
+}
+
+void ZoneResolver::addLocation(const std::string& name, const std::string& timezone, const std::vector<std::string>& aliases) {
+    std::lock_guard lock(write_mutex_);
+    const auto old = snapshot();
+    LocationMap locations = old->locations();
+    locations.addLocation(name, timezone, aliases);
+    publish(std::make_shared<const LookupSnapshot>(old->tzdb(), std::move(locations), old->timezones(), old->fuzzyOptions(),
+                                                   old->builtFuzzyMatcher(), old->geoIndex()));
+}
+
+void ZoneResolver::addTimezoneAlias(const std::string& official_name, const std::vector<std::string>& aliases) {
+    std::lock_guard lock(write_mutex_);
+    const auto old = snapshot();
+    TimezoneMap timezones = old->timezones();
+    timezones.addTimezoneAlias(official_name, aliases);
+    publish(std::make_shared<const LookupSnapshot>(old->tzdb(), old->locations(), std::move(timezones), old->fuzzyOptions(),
+                                                   old->builtFuzzyMatcher(), old->geoIndex()));
+}
+
+bool ZoneResolver::reload() {
+    std::lock_guard lock(write_mutex_);
+    const date::tzdb* db = nullptr;
+    try {
+#if !USE_OS_TZDB
+        db = &date::reload_tzdb();
+#else
+        db = &date::get_tzdb();
+#endif
+    } catch (const std::exception&) {
+        return false;
+    }
+
+    const auto old = snapshot();
+    // a compiled image was built from the old data, the new zones get fresh tables instead
+    if (!old->tzdb() || old->tzdb()->version != db->version) ZoneTables::unloadImage();
+
+    // the fuzzy matcher indexes zone names, so it's only kept when the database didn't change.
+    // the geo index points at zones too, it keeps its file and looks its names up again
+    std::shared_ptr<const GeoIndex> geo = old->geoIndex();
+    if (geo && geo->tzdb() != db) geo = geo->rebind(db);
+    publish(std::make_shared<const LookupSnapshot>(db, old->locations(), old->timezones(), old->fuzzyOptions(),
+                                                   db == old->tzdb() ? old->builtFuzzyMatcher() : nullptr, std::move(geo)));
+    return true;
+}
+
+void ZoneResolver::setFuzzyOptions(const FuzzyOptions& options) {
+    std::lock_guard lock(write_mutex_);
+    const auto old = snapshot();
+    publish(std::make_shared<const LookupSnapshot>(old->tzdb(), old->locations(), old->timezones(), options,
+                                                   old->builtFuzzyMatcher(), old->geoIndex()));
+}
+
+void ZoneResolver::setGazetteer(std::shared_ptr<const Gazetteer> gazetteer) {
+    std::lock_guard lock(write_mutex_);
+    const auto old = snapshot();
+    LocationMap locations = old->locations();
+    locations.setGazetteer(std::move(gazetteer));
+    publish(std::make_shared<const LookupSnapshot>(old->tzdb(), std::move(locations), old->timezones(), old->fuzzyOptions(),
+                                                   old->builtFuzzyMatcher(), old->geoIndex()));
+}
+
+void ZoneResolver::setGeoIndex(std::shared_ptr<const GeoIndex> index) {
+    std::lock_guard lock(write_mutex_);
+    const auto old = snapshot();
+    // opened against a database that was replaced in the meantime
+    if (index && index->tzdb() != old->tzdb()) index = index->rebind(old->tzdb());
+    publish(std::make_shared<const LookupSnapshot>(old->tzdb(), old->locations(), old->timezones(), old->fuzzyOptions(),
+                                                   old->builtFuzzyMatcher(), std::move(index)));
+}
+
+const date::time_zone* ZoneResolver::locate(const double latitude, const double longitude) const {
+    const auto& geo = current().geoIndex();
+    return geo ? geo->lookup(latitude, longitude) : nullptr;
+}
+
+void ZoneResolver::locate(const Coordinate* coordinates, const std::size_t count, const date::time_zone** out) const {
+    if (const auto& geo = current().geoIndex()) {
+        geo->lookup(coordinates, count, out);
+    } else {
+        std::fill(out, out + count, nullptr);
+    }
+}
+
+FuzzyOptions ZoneResolver::fuzzyOptions() const {
+    return current().fuzzyOptions();
+}
+
+std::vector<FuzzyMatch> ZoneResolver::suggest(const std::string_view location, const std::size_t limit) const {
+    const LookupSnapshot& snapshot = current();
+    return snapshot.fuzzyMatcher().search(QueryParser::normalizeLocation(location), snapshot.fuzzyOptions(), limit);
+}
+
+const date::time_zone* ZoneResolver::findZone(const std::string_view name) {
+    const date::tzdb* db = loadedTzdb();
+    return db ? LookupSnapshot::findZone(*db, name) : nullptr;
+}
+
+const LookupSnapshot& ZoneResolver::current() const {
+    // the snapshots this thread used last, one slot per resolver. while a resolver's generation
+    // hasn't moved its slot still holds the published snapshot, so the common case is one atomic
+    // load and no reference counting, also for threads that go back and forth between resolvers.
+    // generations are unique across resolvers, so a slot left by a destroyed resolver that
+    // lived at the same address never matches
+    struct Seen {
+        const ZoneResolver* owner = nullptr;
+        std::shared_ptr<const LookupSnapshot> snapshot;
+    };
+    thread_local std::array<Seen, kThreadSlots> seen;
+    thread_local std::size_t next_slot = 0;
+
+    const std::uint64_t generation = generation_.load(std::memory_order_acquire);
+    Seen* slot = nullptr;
+    for (auto& candidate : seen) {
+        if (candidate.owner == this) {
+            slot = &candidate;
+            break;
+        }
+    }
+    if (!slot) {
+        slot = &seen[next_slot++ % kThreadSlots];
+        slot->owner = this;
+        slot->snapshot.reset();
+    }
+
+    if (!slot->snapshot || slot->snapshot->generation() != generation) slot->snapshot = snapshot();
+    return *slot->snapshot;
+}
+
+void ZoneResolver::publish(std::shared_ptr<const LookupSnapshot> snapshot) {
+    const std::uint64_t generation = snapshot->generation();
+    std::atomic_store_explicit(&snapshot_, std::move(snapshot), std::memory_order_release);
+    generation_.store(generation, std::memory_order_release);
+}
+
+}
@@ -0,0 +1,114 @@
+#include "result_cache.hpp"
+#include <functional>
+
+namespace timelib {
+
+ResultCache::ResultCache(const std::size_t capacity) {
+    setCapacity(capacity);
+}
+
+void ResultCache::setCapacity(const std::size_t capacity) {
+    // spread evenly, the first shards take the remainder
+    for (std::size_t i = 0; i < kShards; ++i) {
+        auto& shard = shards_[i];
+        std::lock_guard lock(shard.mutex);
+        shard.capacity = capacity / kShards + (i < capacity % kShards ? 1 : 0);
+        shard.trim();
+    }
+    enabled_.store(capacity > 0, std::memory_order_relaxed);
+}
+
+std::shared_ptr<const QueryAnswer> ResultCache::find(const std::string_view key, const date::sys_seconds now,
+                                                     const std::uint64_t generation) {
+    if (!enabled() || key.empty()) return nullptr;
+
+    auto& shard = shardFor(key);
+    std::lock_guard lock(shard.mutex);
+    const auto it = shard.index.find(key);
+    if (it == shard.index.end()) {
+        ++shard.misses;
+        return nullptr;
+    }
+
+    const auto entry = it->second;
+    if (entry->generation != generation || now >= entry->expires) {
+        shard.index.erase(it);
+        shard.entries.erase(entry);
+        ++shard.misses;
+        return nullptr;
+    }
+
+    shard.entries.splice(shard.entries.begin(), shard.entries, entry);
+    ++shard.hits;
+    return entry->answer;
+}
+
+void ResultCache::insert(const std::string_view key, std::shared_ptr<const QueryAnswer> answer, const date::sys_seconds expires,
+                         const std::uint64_t generation) {
+    if (!enabled() || key.empty() || key.size() > kMaxKeyLength) return;
+
+    auto& shard = shardFor(key);
+    std::lock_guard lock(shard.mutex);
+    if (shard.capacity == 0) return;
+
+    if (const auto it = shard.index.find(key); it != shard.index.end()) {
+        const auto entry = it->second;
+        entry->answer = std::move(answer);
+        entry->expires = expires;
+        entry->generation = generation;
+        shard.entries.splice(shard.entries.begin(), shard.entries, entry);
+        return;
+    }
+
+    shard.entries.push_front({std::string(key), std::move(answer), expires, generation});
+    shard.index.emplace(shard.entries.front().key, shard.entries.begin());
+    shard.trim();
+}
+
+void ResultCache::clear() {
+    for (auto& shard : shards_) {
+        std::lock_guard lock(shard.mutex);
+        shard.index.clear();
+        shard.entries.clear();
+    }
+}
+
+ResultCacheStats ResultCache::stats() const {
+    ResultCacheStats stats;
+    for (const auto& shard : shards_) {
+        std::lock_guard lock(shard.mutex);
+        stats.hits += shard.hits;
+        stats.misses += shard.misses;
+        stats.evictions += shard.evictions;
+        stats.size += shard.entries.size();
+        stats.capacity += shard.capacity;
+    }
+    return stats;
+}
+
+std::string_view ResultCache::normalizeKey(std::string_view input, std::array<char, kMaxKeyLength>& buffer) {
+    const auto is_space = [](const char c) { return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f' || c == '\v'; };
+    while (!input.empty() && is_space(input.front())) input.remove_prefix(1);
+    while (!input.empty() && is_space(input.back())) input.remove_suffix(1);
+    if (input.size() > buffer.size()) return {};
+
+    for (std::size_t i = 0; i < input.size(); ++i) {
+        const char c = input[i];
+        buffer[i] = c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c;
+    }
+    return {buffer.data(), input.size()};
+}
+
+void ResultCache::Shard::trim() {
+    while (entries.size() > capacity) {
+        index.erase(entries.back().key);
+        entries.pop_back();
+        ++evictions;
+    }
+}
+
+ResultCache::Shard& ResultCache::shardFor(const std::string_view key) {
+    return shards_[std::hash<std::string_view>{}(key) % kShards];
+}
+
+}
@@ -0,0 +1,117 @@
+#include "snapshot.hpp"
+#include <algorithm>
+#include <functional>
+
+namespace timelib {
+
+namespace {
+
+std::atomic<std::uint64_t> next_generation{1};
+
+}
+
+LookupSnapshot::LookupSnapshot(const date::tzdb* db, LocationMap locations, TimezoneMap timezones,
+                               const FuzzyOptions& fuzzy_options, std::shared_ptr<const FuzzyMatcher> fuzzy,
+                               std::shared_ptr<const GeoIndex> geo)
+    : generation_(next_generation.fetch_add(1, std::memory_order_relaxed)),
+      db_(db),
+      locations_(std::move(locations)),
+      timezones_(std::move(timezones)),
+      fuzzy_options_(fuzzy_options),
+      geo_(std::move(geo)),
+      fuzzy_owner_(std::move(fuzzy)),
+      fuzzy_(fuzzy_owner_.get()) {}
+
+LookupSnapshot::~LookupSnapshot() {
+    CacheSlot* cache = cache_.load(std::memory_order_acquire);
+    if (!cache) return;
+    for (std::size_t i = 0; i < kCacheSlots; ++i) delete cache[i].load(std::memory_order_relaxed);
+    delete[] cache;
+}
+
+const date::time_zone* LookupSnapshot::findZone(const std::string_view name) const {
+    if (db_) return findZone(*db_, name);
+
+    try {
+        return findZone(date::get_tzdb(), name);
+    } catch (const std::exception&) {
+        return nullptr;
+    }
+}
+
+const date::time_zone* LookupSnapshot::findZone(const date::tzdb& db, const std::string_view name) {
+    if (name.empty()) return nullptr;
+
+    const auto by_zone_name = [](const date::time_zone& zone, const std::string_view key) { return zone.name() < key; };
+    if (const auto it = std::lower_bound(db.zones.begin(), db.zones.end(), name, by_zone_name);
+        it != db.zones.end() && it->name() == name) {
+        return &*it;
+    }
+
+#if !USE_OS_TZDB
+    const auto by_link_name = [](const date::time_zone_link& link, const std::string_view key) { return link.name() < key; };
+    if (const auto link = std::lower_bound(db.links.begin(), db.links.end(), name, by_link_name);
+        link != db.links.end() && link->name() == name) {
+        const auto it = std::lower_bound(db.zones.begin(), db.zones.end(), link->target(), by_zone_name);
+        if (it != db.zones.end() && it->name() == link->target()) return &*it;
+    }
+#endif
+
+    return nullptr;
+}
+
+const FuzzyMatcher& LookupSnapshot::fuzzyMatcher() const {
+    if (const auto* matcher = fuzzy_.load(std::memory_order_acquire)) return *matcher;
+
+    std::call_once(fuzzy_once_, [this] {
+        fuzzy_owner_ = std::make_shared<const FuzzyMatcher>(FuzzyMatcher::builtin());
+        fuzzy_.store(fuzzy_owner_.get(), std::memory_order_release);
+    });
+    return *fuzzy_.load(std::memory_order_acquire);
+}
+
+std::shared_ptr<const FuzzyMatcher> LookupSnapshot::builtFuzzyMatcher() const {
+    // fuzzy_owner_ is written before fuzzy_ is published, so it's safe to read once fuzzy_ is set
+    if (!fuzzy_.load(std::memory_order_acquire)) return nullptr;
+    return fuzzy_owner_;
+}
+
+const date::time_zone* LookupSnapshot::cached(const std::string_view name) const {
+    const CacheSlot* cache = cache_.load(std::memory_order_acquire);
+    if (!cache) return nullptr;
+
+    const std::size_t mask = kCacheSlots - 1;
+    for (std::size_t i = std::hash<std::string_view>{}(name) & mask;; i = (i + 1) & mask) {
+        const CachedName* entry = cache[i].load(std::memory_order_acquire);
+        if (!entry) return nullptr;
+        if (entry->name == name) return entry->zone;
+    }
+}
+
+void LookupSnapshot::remember(const std::string_view name, const date::time_zone* zone) const {
+    // the table is never more than half full, so probes stay short and always hit an empty slot
+    if (cache_size_.load(std::memory_order_relaxed) >= kMaxCachedNames) return;
+
+    CacheSlot* cache = cache_.load(std::memory_order_acquire);
+    if (!cache) {
+        // readers racing to remember the first name each build a table, one of them is kept
+        auto fresh = std::make_unique<CacheSlot[]>(kCacheSlots);
+        for (std::size_t i = 0; i < kCacheSlots; ++i) fresh[i].store(nullptr, std::memory_order_relaxed);
+        if (cache_.compare_exchange_strong(cache, fresh.get(), std::memory_order_acq_rel)) cache = fresh.release();
+    }
+
+    auto entry = std::make_unique<const CachedName>(CachedName{std::string(name), zone});
+    const std::size_t mask = kCacheSlots - 1;
+    for (std::size_t i = std::hash<std::string_view>{}(name) & mask;; i = (i + 1) & mask) {
+        const CachedName* expected = nullptr;
+        if (cache[i].compare_exchange_strong(expected, entry.get(), std::memory_order_acq_rel)) {
+            entry.release();
+            cache_size_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        // someone else remembered the same name first
+        if (expected->name == name) return;
+    }
+}
+
+}
@@ -0,0 +1,520 @@
+#include "stream_convert.hpp"
+#include "compiled_zone.hpp"
+#include "thread_pool.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <mutex>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define TIMELIB_HAS_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#define TIMELIB_HAS_MMAP 0
+#endif
+
+namespace timelib {
+
+namespace {
+
+constexpr std::int64_t kDay = 86400;
+// 0000-01-01T00:00:00 and 10000-01-01T00:00:00, what fits in four year digits
+constexpr std::int64_t kFirstWall = -62167219200;
+constexpr std::int64_t kEndWall = 253402300800;
+
+constexpr const char* kMonths[] = {"Jan", "Feb", "Mar", "Apr", "May", "Jun", "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"};
+
+bool isDigit(const char c) {
+    return c >= '0' && c <= '9';
+}
+
+int num2(const char* p) {
+    return (p[0] - '0') * 10 + (p[1] - '0');
+}
+
+int num4(const char* p) {
+    return num2(p) * 100 + num2(p + 2);
+}
+
+char* put2(char* p, const int value) {
+    p[0] = static_cast<char>('0' + value / 10);
+    p[1] = static_cast<char>('0' + value % 10);
+    return p + 2;
+}
+
+std::uint64_t load8(const char* p) {
+    std::uint64_t word;
+    std::memcpy(&word, p, sizeof(word));
+    return word;
+}
+
+// eight bytes of a timestamp shape: 'D' is any digit, '_' any byte and everything else has to
+// match exactly. the masks are built from the text, so byte order doesn't matter
+class Shape8 {
+public:
+    explicit Shape8(const char (&shape)[9]) {
+        char digits[8], literal_mask[8], literal[8];
+        for (std::size_t i = 0; i < 8; ++i) {
+            const bool fixed = shape[i] != 'D' && shape[i] != '_';
+            digits[i] = shape[i] == 'D' ? '\xff' : '\0';
+            literal_mask[i] = fixed ? '\xff' : '\0';
+            literal[i] = fixed ? shape[i] : '\0';
+        }
+        digits_ = load8(digits);
+        literal_mask_ = load8(literal_mask);
+        literal_ = load8(literal);
+    }
+
+    bool matches(const char* p) const {
+        constexpr std::uint64_t kOnes = 0x0101010101010101ULL;
+        const std::uint64_t word = load8(p);
+        if ((word & literal_mask_) != literal_) return false;
+
+        // a digit is 0x30-0x39: high nibble 3, and still 3 after adding 6
+        const std::uint64_t high = (kOnes * 0xF0) & digits_;
+        const std::uint64_t three = (kOnes * 0x30) & digits_;
+        const std::uint64_t digits = word & digits_;
+        return (digits & high) == three && ((digits + ((kOnes * 0x06) & digits_)) & high) == three;
+    }
+
+private:
+    std::uint64_t digits_ = 0;
+    std::uint64_t literal_mask_ = 0;
+    std::uint64_t literal_ = 0;
+};
+
+enum class StampForm {
+    Iso,
+    CommonLog
+};
+
+struct Stamp {
+    StampForm form = StampForm::Iso;
+    // [begin, end) of the line
+    std::size_t begin = 0;
+    std::size_t end = 0;
+    // the wall clock reading as written, in seconds since the epoch
+    std::int64_t wall = 0;
+    bool has_offset = false;
+    std::int32_t offset = 0;
+    char separator = 'T';
+    // ".123" as written, kept as is
+    std::string_view fraction;
+};
+
+bool wallSeconds(const int year, const int month, const int day, const int hour, const int minute, const int second,
+                 std::int64_t& out) {
+    const date::year_month_day ymd{date::year{year}, date::month{static_cast<unsigned>(month)},
+                                   date::day{static_cast<unsigned>(day)}};
+    if (!ymd.ok() || hour > 23 || minute > 59 || second > 59) return false;
+    out = date::sys_days{ymd}.time_since_epoch().count() * kDay + hour * 3600 + minute * 60 + second;
+    return true;
+}
+
+bool parseIso(const std::string_view line, const std::size_t at, Stamp& stamp) {
+    static const Shape8 kDate("DDDD-DD-");
+    static const Shape8 kTime("DD_DD:DD");
+
+    const std::size_t n = line.size();
+    if (n - at < 19) return false;
+    const char* s = line.data() + at;
+    if (!kDate.matches(s) || !kTime.matches(s + 8)) return false;
+    if (s[10] != 'T' && s[10] != 't' && s[10] != ' ') return false;
+    if (s[16] != ':' || !isDigit(s[17]) || !isDigit(s[18])) return false;
+    if (!wallSeconds(num4(s), num2(s + 5), num2(s + 8), num2(s + 11), num2(s + 14), num2(s + 17), stamp.wall)) return false;
+
+    stamp.form = StampForm::Iso;
+    stamp.begin = at;
+    stamp.separator = s[10];
+    std::size_t end = at + 19;
+
+    stamp.fraction = {};
+    if (end + 1 < n && (line[end] == '.' || line[end] == ',') && isDigit(line[end + 1])) {
+        std::size_t last = end + 1;
+        while (last < n && isDigit(line[last])) ++last;
+        stamp.fraction = line.substr(end, last - end);
+        end = last;
+    }
+
+    stamp.has_offset = false;
+    stamp.offset = 0;
+    if (end < n && (line[end] == 'Z' || line[end] == 'z')) {
+        stamp.has_offset = true;
+        ++end;
+    } else if (end + 3 <= n && (line[end] == '+' || line[end] == '-') && isDigit(line[end + 1]) && isDigit(line[end + 2])) {
+        const int hours = num2(line.data() + end + 1);
+        int minutes = 0;
+        std::size_t last = end + 3;
+        if (last + 3 <= n && line[last] == ':' && isDigit(line[last + 1]) && isDigit(line[last + 2])) {
+            minutes = num2(line.data() + last + 1);
+            last += 3;
+        } else if (last + 2 <= n && isDigit(line[last]) && isDigit(line[last + 1])) {
+            minutes = num2(line.data() + last);
+            last += 2;
+        }
+        if (hours < 24 && minutes < 60) {
+            stamp.has_offset = true;
+            stamp.offset = (line[end] == '-' ? -1 : 1) * (hours * 3600 + minutes * 60);
+            end = last;
+        }
+    }
+
+    stamp.end = end;
+    return true;
+}
+
+bool parseCommonLog(const std::string_view line, const std::size_t at, Stamp& stamp) {
+    // 10/Oct/2000:13:55:36 -0700
+    static const Shape8 kDate("DD/___/D");
+    static const Shape8 kTime("DDD:DD:D");
+    static const Shape8 kZone("D:DD _DD");
+
+    if (line.size() - at < 26) return false;
+    const char* s = line.data() + at;
+    if (!kDate.matches(s) || !kTime.matches(s + 8) || !kZone.matches(s + 16)) return false;
+    if ((s[21] != '+' && s[21] != '-') || !isDigit(s[24]) || !isDigit(s[25])) return false;
+
+    const auto month = std::find_if(std::begin(kMonths), std::end(kMonths),
+                                    [s](const char* name) { return std::memcmp(name, s + 3, 3) == 0; });
+    if (month == std::end(kMonths)) return false;
+
+    const int hours = num2(s + 22);
+    const int minutes = num2(s + 24);
+    if (hours > 23 || minutes > 59) return false;
+    if (!wallSeconds(num4(s + 7), static_cast<int>(month - std::begin(kMonths)) + 1, num2(s), num2(s + 12), num2(s + 15),
+                     num2(s + 18), stamp.wall)) {
+        return false;
+    }
+
+    stamp.form = StampForm::CommonLog;
+    stamp.begin = at;
+    stamp.end = at + 26;
+    stamp.has_offset = true;
+    stamp.offset = (s[21] == '-' ? -1 : 1) * (hours * 3600 + minutes * 60);
+    stamp.fraction = {};
+    return true;
+}
+
+bool parseAt(const std::string_view line, const std::size_t at, Stamp& stamp) {
+    if (line.size() - at < 19 || !isDigit(line[at])) return false;
+    if (line[at + 4] == '-') return parseIso(line, at, stamp);
+    if (line[at + 2] == '/') return parseCommonLog(line, at, stamp);
+    return false;
+}
+
+bool locate(const std::string_view line, const StreamConvertOptions& options, Stamp& stamp) {
+    if (options.delimiter == '\0') {
+        for (std::size_t at = 0; at + 19 <= line.size(); ++at) {
+            if (isDigit(line[at]) && parseAt(line, at, stamp)) return true;
+        }
+        return false;
+    }
+
+    std::size_t start = 0;
+    for (std::size_t field = 0; field < options.field; ++field) {
+        const std::size_t delimiter = line.find(options.delimiter, start);
+        if (delimiter == std::string_view::npos) return false;
+        start = delimiter + 1;
+    }
+    if (start < line.size() && (line[start] == '"' || line[start] == '[')) ++start;
+    return start < line.size() && parseAt(line, start, stamp);
+}
+
+// the offset interval of one zone that was needed last. logs are mostly in time order, so the
+// next timestamp nearly always lands in the same interval
+class ZoneCursor {
+public:
+    explicit ZoneCursor(const date::time_zone* zone) : zone_(zone) {}
+
+    std::int32_t offsetAt(const std::int64_t t) {
+        if (t < begin_ || t >= end_) load(t);
+        return offset_;
+    }
+
+    // wall clock -> utc with choose::earliest. a day away from either end of the interval no
+    // other interval can claim the wall time, so the cached offset settles it
+    std::int64_t toSys(const std::int64_t wall) {
+        const std::int64_t guess = wall - offset_;
+        if (guess >= safe_begin_ && guess < safe_end_) return guess;
+
+        const auto sys = ZoneTables::toSys(zone_, date::local_seconds{std::chrono::seconds{wall}}, date::choose::earliest);
+        const std::int64_t t = sys.time_since_epoch().count();
+        load(t);
+        return t;
+    }
+
+private:
+    const date::time_zone* zone_;
+    std::int64_t begin_ = 0;
+    std::int64_t end_ = 0;
+    std::int64_t safe_begin_ = 0;
+    std::int64_t safe_end_ = 0;
+    std::int32_t offset_ = 0;
+
+    void load(const std::int64_t t) {
+        const date::sys_seconds tp{std::chrono::seconds{t}};
+        if (const auto* table = ZoneTables::find(zone_); table && table->covers(tp)) {
+            const auto& starts = table->starts();
+            const auto i = static_cast<std::size_t>(std::upper_bound(starts.begin(), starts.end(), t) - starts.begin()) - 1;
+            begin_ = starts[i];
+            end_ = i + 1 < starts.size() ? starts[i + 1] : table->rangeEnd();
+            offset_ = table->offsets()[i];
+        } else {
+            const auto info = zone_->get_info(tp);
+            begin_ = date::floor<std::chrono::seconds>(info.begin).time_since_epoch().count();
+            end_ = date::floor<std::chrono::seconds>(info.end).time_since_epoch().count();
+            offset_ = static_cast<std::int32_t>(info.offset.count());
+        }
+
+        constexpr auto kMin = std::numeric_limits<std::int64_t>::min();
+        constexpr auto kMax = std::numeric_limits<std::int64_t>::max();
+        safe_begin_ = begin_ < kMin + kDay ? begin_ : begin_ + kDay;
+        safe_end_ = end_ > kMax - kDay ? end_ : end_ - kDay;
+    }
+};
+
+void writeStamp(const Stamp& stamp, const std::int64_t wall, const std::int32_t offset, std::string& out) {
+    std::int64_t days = wall / kDay;
+    if (wall % kDay < 0) --days;
+    const auto seconds = static_cast<int>(wall - days * kDay);
+    const date::year_month_day ymd{date::sys_days{date::days{days}}};
+    const int year = static_cast<int>(ymd.year());
+
+    char buffer[48];
+    char* p = buffer;
+    const auto time_of_day = [&p, seconds] {
+        p = put2(p, seconds / 3600);
+        *p++ = ':';
+        p = put2(p, seconds / 60 % 60);
+        *p++ = ':';
+        p = put2(p, seconds % 60);
+    };
+    const char sign = offset < 0 ? '-' : '+';
+    const int magnitude = offset < 0 ? -offset : offset;
+
+    if (stamp.form == StampForm::Iso) {
+        p = put2(put2(p, year / 100), year % 100);
+        *p++ = '-';
+        p = put2(p, static_cast<int>(static_cast<unsigned>(ymd.month())));
+        *p++ = '-';
+        p = put2(p, static_cast<int>(static_cast<unsigned>(ymd.day())));
+        *p++ = stamp.separator;
+        time_of_day();
+        out.append(buffer, static_cast<std::size_t>(p - buffer));
+        out.append(stamp.fraction);
+        if (!stamp.has_offset) return;
+
+        p = buffer;
+        *p++ = sign;
+        p = put2(p, magnitude / 3600);
+        *p++ = ':';
+        p = put2(p, magnitude / 60 % 60);
+        // only lmt era offsets have seconds
+        if (magnitude % 60 != 0) {
+            *p++ = ':';
+            p = put2(p, magnitude % 60);
+        }
+        out.append(buffer, static_cast<std::size_t>(p - buffer));
+        return;
+    }
+
+    p = put2(p, static_cast<int>(static_cast<unsigned>(ymd.day())));
+    *p++ = '/';
+    std::memcpy(p, kMonths[static_cast<unsigned>(ymd.month()) - 1], 3);
+    p += 3;
+    *p++ = '/';
+    p = put2(put2(p, year / 100), year % 100);
+    *p++ = ':';
+    time_of_day();
+    *p++ = ' ';
+    *p++ = sign;
+    p = put2(p, magnitude / 3600);
+    p = put2(p, magnitude / 60 % 60);
+    out.append(buffer, static_cast<std::size_t>(p - buffer));
+}
+
+// false (and the line copied as it was) when there's nothing to convert
+bool convertLine(const std::string_view line, const StreamConvertOptions& options, ZoneCursor& source, ZoneCursor& target,
+                 std::string& out) {
+    Stamp stamp;
+    if (!locate(line, options, stamp) || (!stamp.has_offset && !options.source)) {
+        out.append(line);
+        return false;
+    }
+
+    const std::int64_t utc = stamp.has_offset ? stamp.wall - stamp.offset : source.toSys(stamp.wall);
+    const std::int32_t offset = target.offsetAt(utc);
+    const std::int64_t wall = utc + offset;
+    if (wall < kFirstWall || wall >= kEndWall) {
+        out.append(line);
+        return false;
+    }
+
+    out.append(line.substr(0, stamp.begin));
+    writeStamp(stamp, wall, offset, out);
+    out.append(line.substr(stamp.end));
+    return true;
+}
+
+StreamConvertStats convertBlock(const std::string_view text, const StreamConvertOptions& options, std::string& out) {
+    StreamConvertStats stats;
+    stats.bytes_in = text.size();
+    const std::size_t before = out.size();
+    out.reserve(before + text.size() + text.size() / 8);
+
+    ZoneCursor source(options.source);
+    ZoneCursor target(options.target);
+    for (std::size_t start = 0; start < text.size();) {
+        const auto* newline = static_cast<const char*>(std::memchr(text.data() + start, '\n', text.size() - start));
+        const std::size_t end = newline ? static_cast<std::size_t>(newline - text.data()) : text.size();
+
+        // a '\r' before the newline is just part of the rest of the line
+        ++stats.lines;
+        if (options.target) stats.converted += convertLine(text.substr(start, end - start), options, source, target, out);
+        else out.append(text.substr(start, end - start));
+        if (newline) out.push_back('\n');
+        start = end + 1;
+    }
+
+    stats.bytes_out = out.size() - before;
+    return stats;
+}
+
+void add(StreamConvertStats& total, const StreamConvertStats& part) {
+    total.lines += part.lines;
+    total.converted += part.converted;
+    total.bytes_in += part.bytes_in;
+    total.bytes_out += part.bytes_out;
+}
+
+}
+
+StreamConverter::StreamConverter(const StreamConvertOptions& options) : options_(options) {
+    options_.block_size = std::max<std::size_t>(options_.block_size, 1);
+}
+
+StreamConvertStats StreamConverter::convert(const std::string_view text, std::string& out) const {
+    return convertBlock(text, options_, out);
+}
+
+StreamConvertStats StreamConverter::convert(const std::string_view text, const Sink& sink, ThreadPool& pool) const {
+    // a few blocks per thread are converted at a time, which keeps the threads busy while the
+    // output held back for ordering stays bounded
+    const std::size_t window = 4 * (pool.size() + 1);
+    std::vector<std::string_view> blocks;
+    std::vector<std::string> outputs(window);
+    std::vector<StreamConvertStats> parts(window);
+
+    StreamConvertStats total;
+    for (std::size_t pos = 0; pos < text.size();) {
+        blocks.clear();
+        while (blocks.size() < window && pos < text.size()) {
+            std::size_t end = std::min(text.size(), pos + options_.block_size);
+            if (end < text.size()) {
+                const void* newline = std::memchr(text.data() + end - 1, '\n', text.size() - end + 1);
+                end = newline ? static_cast<std::size_t>(static_cast<const char*>(newline) - text.data()) + 1 : text.size();
+            }
+            blocks.push_back(text.substr(pos, end - pos));
+            pos = end;
+        }
+
+        // blocks are claimed in order whatever chunk the pool hands a thread, and the thread that
+        // finishes the next block due passes it (and any done after it) to the sink right away,
+        // while the rest are still being converted
+        std::atomic<std::size_t> claimed{0};
+        std::mutex emit_mutex;
+        std::vector<char> done(blocks.size(), 0);
+        std::size_t emitted = 0;
+        bool emitting = false;
+        pool.parallelFor(blocks.size(), 1, [&](const std::size_t first, const std::size_t last) {
+            for (std::size_t n = first; n < last; ++n) {
+                const std::size_t i = claimed.fetch_add(1, std::memory_order_relaxed);
+                outputs[i].clear();
+                parts[i] = convertBlock(blocks[i], options_, outputs[i]);
+
+                std::unique_lock lock(emit_mutex);
+                done[i] = 1;
+                if (emitting) continue;
+                emitting = true;
+                while (emitted < blocks.size() && done[emitted]) {
+                    const std::size_t next = emitted++;
+                    lock.unlock();
+                    sink(outputs[next]);
+                    lock.lock();
+                }
+                emitting = false;
+            }
+        });
+        for (std::size_t i = 0; i < blocks.size(); ++i) add(total, parts[i]);
+    }
+    return total;
+}
+
+std::optional<StreamConvertStats> StreamConverter::convert(std::istream& in, const Sink& sink, ThreadPool& pool) const {
+    const std::size_t read_size = options_.block_size * 4 * (pool.size() + 1);
+    std::string buffer;
+    std::size_t carried = 0;
+
+    StreamConvertStats total;
+    while (true) {
+        buffer.resize(carried + read_size);
+        in.read(buffer.data() + carried, static_cast<std::streamsize>(read_size));
+        // a read error isn't the end of the input, what's left in the buffer may be cut anywhere
+        if (in.bad()) return std::nullopt;
+        const std::size_t size = carried + static_cast<std::size_t>(in.gcount());
+        const bool last = !in;
+
+        // only whole lines are converted, the partial one at the end waits for the next read
+        const std::string_view data(buffer.data(), size);
+        const std::size_t newline = data.rfind('\n');
+        const std::size_t cut = last ? size : newline == std::string_view::npos ? 0 : newline + 1;
+        if (cut > 0) add(total, convert(data.substr(0, cut), sink, pool));
+
+        carried = size - cut;
+        std::memmove(buffer.data(), buffer.data() + cut, carried);
+        if (last) break;
+    }
+    return total;
+}
+
+std::optional<StreamConvertStats> StreamConverter::convertFile(const std::string& path, const Sink& sink, ThreadPool& pool) const {
+    const auto read = [&]() -> std::optional<StreamConvertStats> {
+        std::ifstream in(path, std::ios::binary);
+        if (!in) return std::nullopt;
+        return convert(in, sink, pool);
+    };
+
+#if TIMELIB_HAS_MMAP
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return std::nullopt;
+
+    struct stat st{};
+    const bool regular = ::fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0;
+    const auto size = regular ? static_cast<std::size_t>(st.st_size) : 0;
+    void* data = regular ? ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+    ::close(fd);
+    // pipes and the like can't be mapped, they're read like any stream
+    if (data == MAP_FAILED) return read();
+
+#ifdef MADV_SEQUENTIAL
+    ::madvise(data, size, MADV_SEQUENTIAL);
+#endif
+    struct Unmap {
+        void* data;
+        std::size_t size;
+        ~Unmap() { ::munmap(data, size); }
+    } unmap{data, size};
+    return convert(std::string_view(static_cast<const char*>(data), size), sink, pool);
+#else
+    return read();
+#endif
+}
+
+}
@@ -0,0 +1,120 @@
+#include "thread_pool.hpp"
+#include <algorithm>
+
+namespace timelib {
+
+ThreadPool::ThreadPool(std::size_t threads) {
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+
+    for (std::size_t i = 0; i <= threads; ++i) queues_.push_back(std::make_unique<Queue>());
+    workers_.reserve(threads);
+    for (std::size_t i = 0; i < threads; ++i) workers_.emplace_back([this, i] { workerLoop(i); });
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard lock(mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    for (auto& worker : workers_) worker.join();
+}
+
+void ThreadPool::parallelFor(const std::size_t count, std::size_t grain,
+                             const std::function<void(std::size_t, std::size_t)>& body) {
+    if (count == 0) return;
+    grain = std::max<std::size_t>(grain, 1);
+
+    // not worth waking anyone for
+    if (count <= grain || workers_.empty()) {
+        body(0, count);
+        return;
+    }
+
+    std::lock_guard batch(batch_mutex_);
+
+    // published before any chunk is queued: a worker still draining the previous batch may pick
+    // up a chunk as soon as it lands
+    const std::size_t chunks = (count + grain - 1) / grain;
+    {
+        std::lock_guard lock(mutex_);
+        body_ = &body;
+        error_ = nullptr;
+        pending_.store(chunks, std::memory_order_relaxed);
+    }
+
+    for (std::size_t chunk = 0; chunk < chunks; ++chunk) {
+        const std::size_t first = chunk * grain;
+        auto& queue = *queues_[chunk % queues_.size()];
+        std::lock_guard lock(queue.mutex);
+        queue.ranges.emplace_back(first, std::min(first + grain, count));
+    }
+
+    {
+        std::lock_guard lock(mutex_);
+        ++generation_;
+    }
+    wake_.notify_all();
+
+    drain(workers_.size());
+
+    std::unique_lock lock(mutex_);
+    done_.wait(lock, [this] { return pending_.load(std::memory_order_acquire) == 0; });
+    if (error_) std::rethrow_exception(std::exchange(error_, nullptr));
+}
+
+void ThreadPool::workerLoop(const std::size_t index) {
+    std::size_t seen = 0;
+    while (true) {
+        {
+            std::unique_lock lock(mutex_);
+            wake_.wait(lock, [this, seen] { return stopping_ || generation_ != seen; });
+            if (stopping_) return;
+            seen = generation_;
+        }
+        drain(index);
+    }
+}
+
+void ThreadPool::drain(const std::size_t index) {
+    Range range;
+    while (take(index, range)) {
+        try {
+            (*body_)(range.first, range.second);
+        } catch (...) {
+            std::lock_guard lock(mutex_);
+            if (!error_) error_ = std::current_exception();
+        }
+
+        if (pending_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            // take the lock so the notify can't slip in between the caller's check and its wait
+            std::lock_guard lock(mutex_);
+            done_.notify_all();
+        }
+    }
+}
+
+bool ThreadPool::take(const std::size_t index, Range& range) {
+    {
+        auto& own = *queues_[index];
+        std::lock_guard lock(own.mutex);
+        if (!own.ranges.empty()) {
+            range = own.ranges.back();
+            own.ranges.pop_back();
+            return true;
+        }
+    }
+
+    for (std::size_t offset = 1; offset < queues_.size(); ++offset) {
+        auto& victim = *queues_[(index + offset) % queues_.size()];
+        std::lock_guard lock(victim.mutex);
+        if (!victim.ranges.empty()) {
+            range = victim.ranges.front();
+            victim.ranges.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+}
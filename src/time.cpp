@@ -1,267 +1,555 @@
 #include "time.hpp"
-#include "location.hpp"
-#include "zones.hpp"
-#include <iostream>
-#include <sstream>
-#include <iomanip>
+#include "metrics.hpp"
+#include "parser.hpp"
+#include "resolver.hpp"
+#include "result_cache.hpp"
+#include "thread_pool.hpp"
 #include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <iterator>
+#include <mutex>
+#include <unordered_map>
 
 namespace timelib {
 
-TimeConverter::TimeConverter() {
-    conversion_pattern_ = std::regex(
-        R"(^(?:convert|change|switch|make|what is|whats)\s+(.+?)\s+(?:from|frm|in|at)\s+(.+?)\s+(?:to|2|in|as)\s+(.+?)\s*$)",
-        std::regex_constants::icase);
+namespace {
 
-    implicit_conversion_pattern_ = std::regex(
-        R"(^(.+?)\s+(?:in|at)\s+(.+?)\s+(?:to|as|in)\s+(.+?)\s*$)",
-        std::regex_constants::icase);
-
-    query_pattern_ = std::regex(
-        R"(^(?:what is|what's|whats|wats|tell me|show me)?\s*(?:the)?\s*(?:current|local)?\s*(time|now|.+?)\s+(?:in|at|for|of)\s+(.+?)\s*$)",
-        std::regex_constants::icase);
-
-    difference_pattern_ = std::regex(
-        R"(^(?:what's|whats|wats|what is)?\s*(?:the)?\s*time(?:s)?\s*(?:difference|diff|offset)\s*(?:between|b/w|from)\s+(.+?)\s*(?:and|&|to|2)\s+(.+?)\s*$)",
-        std::regex_constants::icase);
+QueryResult failure(const ErrorCode code, const std::string_view message, const std::string_view detail = {}) {
+    QueryResult result;
+    result.code = code;
+    result.error_message.assign(message).append(detail);
+    return result;
 }
 
-QueryResult TimeConverter::processQuery(const ParsedQuery& query) {
-    if (!query.is_valid) {
-        return {"", ErrorCode::InvalidQuery, "Could not understand query. Check location or time format."};
-    }
+// how long an answer stays right. the text of "time in x" changes with the minute, a difference
+// with the next offset change of either zone and a conversion with the (utc) date it is taken on.
+// errors other than ProcessingError only depend on the lookup data, which the cache checks itself
+std::optional<date::sys_seconds> expiresAt(const QueryResult& result, const date::sys_seconds now) {
+    if (result.code == ErrorCode::ProcessingError) return std::nullopt;
+    if (!result.ok()) return date::sys_seconds::max();
 
-    switch (query.type) {
+    switch (result.type) {
         case QueryType::CurrentTime:
-            return getCurrentTimeIn(query.location_a);
+            return std::min<date::sys_seconds>(date::floor<std::chrono::minutes>(now) + std::chrono::minutes{1},
+                                               ZoneTables::nextTransition(result.source_zone, now));
         case QueryType::Conversion:
-            return convertTime(query);
+        case QueryType::Meeting:
+            return date::sys_seconds{date::floor<date::days>(now) + date::days{1}};
         case QueryType::Difference:
-            return calculateTimeDifference(query);
+            return std::min(ZoneTables::nextTransition(result.source_zone, now),
+                            ZoneTables::nextTransition(result.target_zone, now));
         case QueryType::Invalid:
         default:
-            return {"", ErrorCode::InvalidQuery, "Query appears to be invalid."};
+            return std::nullopt;
+    }
+}
+
+}
+
+QueryResult TimeConverter::processQuery(const ParsedQuery& query) {
+    return processQuery(query, now());
+}
+
+QueryResult TimeConverter::processQuery(const ParsedQuery& query, const date::sys_seconds as_of) {
+    QueryResult result = evaluate(query, as_of);
+    if (result.ok()) {
+        TIMELIB_METRIC_TIME(Format);
+        render(std::back_inserter(result.result), result, query);
     }
+    return result;
 }
 
-ParsedQuery TimeConverter::parseInput(const std::string& input) const {
-    ParsedQuery query;
-    std::smatch match;
-    std::string cleaned_input = std::regex_replace(input, std::regex(R"(^\s+|\s+$)"), "");
+ErrorCode TimeConverter::processQuery(const ParsedQuery& query, std::string& out) {
+    const QueryResult result = evaluate(query);
+    out.clear();
+    // copying an error message out isn't formatting, only answers are timed
+    if (result.ok()) {
+        TIMELIB_METRIC_TIME(Format);
+        render(std::back_inserter(out), result, query);
+    } else {
+        render(std::back_inserter(out), result, query);
+    }
+    return result.code;
+}
 
-    if (std::regex_match(cleaned_input, match, difference_pattern_)) {
-        query.type = QueryType::Difference;
-        query.location_a = normalizeLocation(match[1].str());
-        query.location_b = normalizeLocation(match[2].str());
-        query.is_valid = true;
-        return query;
+std::shared_ptr<const QueryAnswer> TimeConverter::processInput(const std::string_view input) {
+    auto& cache = resultCache();
+    const auto now = TimeConverter::now();
+    // read before resolving anything, an answer computed across a change is then just stale
+    const std::uint64_t generation = resolver().generation();
+
+    std::array<char, ResultCache::kMaxKeyLength> buffer;
+    std::string_view key;
+    if (cache.enabled()) {
+        key = ResultCache::normalizeKey(input, buffer);
+        if (auto hit = cache.find(key, now, generation)) return hit;
     }
 
-    if (std::regex_match(cleaned_input, match, conversion_pattern_)) {
-        query.type = QueryType::Conversion;
-        parseTimeString(match[1].str(), query);
-        query.location_a = normalizeLocation(match[2].str());
-        query.location_b = normalizeLocation(match[3].str());
-        query.is_valid = isValidTime(query.hour, query.minute);
-        return query;
+    auto answer = std::make_shared<QueryAnswer>();
+    answer->query = QueryParser::parse(input);
+    const auto& query = answer->query;
+    answer->result = query.is_valid ? evaluate(query, now, resolveTimezone(query.location_a),
+                                               query.location_b ? resolveTimezone(*query.location_b) : nullptr)
+                                    : evaluate(query, now, nullptr, nullptr);
+    if (answer->result.ok()) {
+        TIMELIB_METRIC_TIME(Format);
+        render(std::back_inserter(answer->result.result), answer->result, query);
     }
 
-    if (std::regex_match(cleaned_input, match, implicit_conversion_pattern_)) {
-        parseTimeString(match[1].str(), query);
-        if (isValidTime(query.hour, query.minute)) {
-            query.type = QueryType::Conversion;
-            query.location_a = normalizeLocation(match[2].str());
-            query.location_b = normalizeLocation(match[3].str());
-            query.is_valid = true;
-            return query;
-        }
-        query = ParsedQuery();
+    if (!key.empty()) {
+        if (const auto expires = expiresAt(answer->result, now)) cache.insert(key, answer, *expires, generation);
     }
+    return answer;
+}
 
-    if (std::regex_match(cleaned_input, match, query_pattern_)) {
-        std::string time_keyword = match[1].str();
-        std::string lower_time_keyword = time_keyword;
-        std::transform(lower_time_keyword.begin(), lower_time_keyword.end(), lower_time_keyword.begin(), ::tolower);
-
-        if (lower_time_keyword == "time" || lower_time_keyword == "now") {
-            query.type = QueryType::CurrentTime;
-            query.location_a = normalizeLocation(match[2].str());
-            query.is_valid = true;
-        } else {
-            query.type = QueryType::Conversion;
-            parseTimeString(time_keyword, query);
-            query.location_b = normalizeLocation(match[2].str());
-            try {
-                query.location_a = date::current_zone()->name();
-            } catch (const std::exception&) {
-                query.is_valid = false;
-                return query;
-            }
-            query.is_valid = isValidTime(query.hour, query.minute);
+WorldClock TimeConverter::worldClock(const std::vector<std::string>& locations) {
+    return WorldClock(resolver(), locations, now());
+}
+
+OffsetMatrix TimeConverter::offsetMatrix(const std::vector<std::string>& locations, const date::sys_seconds begin,
+                                         const date::sys_seconds end) {
+    return OffsetMatrix(resolver(), locations, begin, end);
+}
+
+MeetingWindows TimeConverter::meetingWindows(const std::vector<WorkingHours>& participants, const date::sys_seconds begin,
+                                             const date::sys_seconds end, const std::chrono::minutes min_length) {
+    return MeetingPlanner::find(resolver(), participants, begin, end, min_length);
+}
+
+Recurrence TimeConverter::recurrence(const std::string_view location, const date::local_days start, const RecurrenceRule& rule) {
+    return Recurrence(resolveTimezone(location), start, rule);
+}
+
+void TimeConverter::setResultCacheCapacity(const std::size_t capacity) {
+    resultCache().setCapacity(capacity);
+}
+
+ResultCacheStats TimeConverter::resultCacheStats() {
+    return resultCache().stats();
+}
+
+std::string TimeConverter::render(const QueryResult& result, const ParsedQuery& query) {
+    std::string text;
+    if (result.ok()) {
+        TIMELIB_METRIC_TIME(Format);
+        render(std::back_inserter(text), result, query);
+    } else {
+        render(std::back_inserter(text), result, query);
+    }
+    return text;
+}
+
+bool TimeConverter::resolve(ParsedQuery& query) {
+    if (!query.is_valid) return false;
+    const auto* zone_a = query.zone_a ? ZoneTables::zoneById(query.zone_a) : resolveTimezone(query.location_a);
+    const auto* zone_b = query.zone_b ? ZoneTables::zoneById(query.zone_b)
+                       : query.location_b ? resolveTimezone(*query.location_b) : nullptr;
+    query.zone_a = ZoneTables::zoneId(zone_a);
+    query.zone_b = ZoneTables::zoneId(zone_b);
+    return zone_a && (zone_b || !query.location_b);
+}
+
+QueryResult TimeConverter::evaluate(const ParsedQuery& query) {
+    return evaluate(query, now());
+}
+
+QueryResult TimeConverter::evaluate(const ParsedQuery& query, const date::sys_seconds as_of) {
+    if (!query.is_valid) return evaluate(query, {}, nullptr, nullptr);
+
+    const auto zone_a = query.zone_a ? ZoneTables::zoneById(query.zone_a) : resolveTimezone(query.location_a);
+    const auto zone_b = query.zone_b ? ZoneTables::zoneById(query.zone_b)
+                      : query.location_b ? resolveTimezone(*query.location_b) : nullptr;
+    return evaluate(query, as_of, zone_a, zone_b);
+}
+
+QueryResult TimeConverter::evaluate(const ParsedQuery& query, const date::sys_seconds now,
+                                    const date::time_zone* zone_a, const date::time_zone* zone_b) {
+    TIMELIB_METRIC_TIME(ZoneLookup);
+    QueryResult result;
+    if (!query.is_valid) {
+        result = failure(ErrorCode::InvalidQuery, "Could not understand query. Check location or time format.");
+    } else {
+        switch (query.type) {
+            case QueryType::CurrentTime:
+                result = getCurrentTimeIn(query.location_a, zone_a, now);
+                break;
+            case QueryType::Conversion:
+                result = convertTime(query, zone_a, zone_b, now);
+                break;
+            case QueryType::Difference:
+                result = calculateTimeDifference(query, zone_a, zone_b, now);
+                break;
+            case QueryType::Meeting:
+                result = findMeetingWindows(query, zone_a, now);
+                break;
+            case QueryType::Invalid:
+            default:
+                result = failure(ErrorCode::InvalidQuery, "Query appears to be invalid.");
+                break;
         }
-        return query;
     }
+    TIMELIB_METRIC_RESULT(result.code);
+    return result;
+}
+
+ParsedQuery TimeConverter::parseInput(const std::string_view input) const {
+    return QueryParser::parse(input);
+}
 
-    query.is_valid = false;
-    return query;
+std::vector<ParsedQuery> TimeConverter::parseBatch(const std::vector<std::string_view>& inputs) const {
+    return parseBatch(inputs, batchPool());
 }
 
-QueryResult TimeConverter::calculateTimeDifference(const ParsedQuery& query) {
-    auto tz_a_str = resolveTimezone(query.location_a);
-    if (!tz_a_str) return {"", ErrorCode::UnknownLocation, "Unknown location: " + query.location_a};
+std::vector<ParsedQuery> TimeConverter::parseBatch(const std::vector<std::string_view>& inputs, ThreadPool& pool) const {
+    std::vector<ParsedQuery> queries(inputs.size());
+    pool.parallelFor(inputs.size(), kBatchGrain, [&](const std::size_t first, const std::size_t last) {
+        for (std::size_t i = first; i < last; ++i) queries[i] = QueryParser::parse(inputs[i]);
+    });
+    return queries;
+}
 
-    auto tz_b_str = resolveTimezone(*query.location_b);
-    if (!tz_b_str) return {"", ErrorCode::UnknownLocation, "Unknown location: " + *query.location_b};
+std::vector<ParsedQuery> TimeConverter::parseBatch(const std::vector<std::string>& inputs) const {
+    return parseBatch(std::vector<std::string_view>(inputs.begin(), inputs.end()));
+}
 
-    try {
-        auto zone_a = date::locate_zone(*tz_a_str);
-        auto zone_b = date::locate_zone(*tz_b_str);
-
-        auto now = std::chrono::system_clock::now();
-        auto info_a = zone_a->get_info(now);
-        auto info_b = zone_b->get_info(now);
-
-        auto offset_diff = info_a.offset - info_b.offset;
-        auto hours = std::chrono::duration_cast<std::chrono::hours>(offset_diff);
-        auto minutes = std::chrono::duration_cast<std::chrono::minutes>(offset_diff % std::chrono::hours(1));
-
-        std::stringstream ss;
-        std::string name_a = query.location_a; name_a[0] = toupper(name_a[0]);
-        std::string name_b = (*query.location_b); name_b[0] = toupper(name_b[0]);
-
-        ss << name_a << " (" << info_a.abbrev << ") is ";
-        if (offset_diff.count() == 0) {
-            ss << "in the same timezone as " << name_b << " (" << info_b.abbrev << ").";
-        } else {
-            if (hours.count() != 0) ss << std::abs(hours.count()) << "h";
-            if (minutes.count() != 0) ss << " " << std::abs(minutes.count()) << "m";
-
-            ss << (offset_diff > std::chrono::seconds(0) ? " ahead of " : " behind ");
-            ss << name_b << " (" << info_b.abbrev << ").";
+std::vector<QueryResult> TimeConverter::processBatch(const std::vector<ParsedQuery>& queries, const bool render_text) {
+    return processBatch(queries, batchPool(), now(), render_text);
+}
+
+std::vector<QueryResult> TimeConverter::processBatch(const std::vector<ParsedQuery>& queries, ThreadPool& pool,
+                                                     const bool render_text) {
+    return processBatch(queries, pool, now(), render_text);
+}
+
+std::vector<QueryResult> TimeConverter::processBatch(const std::vector<ParsedQuery>& queries, const date::sys_seconds as_of,
+                                                     const bool render_text) {
+    return processBatch(queries, batchPool(), as_of, render_text);
+}
+
+std::vector<QueryResult> TimeConverter::processBatch(const std::vector<ParsedQuery>& queries, ThreadPool& pool,
+                                                     const date::sys_seconds as_of, const bool render_text) {
+    // a report over thousands of pairs names only a handful of places, resolve each one once.
+    // queries that were resolved already bring their zones along
+    std::unordered_map<std::string_view, const date::time_zone*> zones;
+    for (const auto& query : queries) {
+        if (!query.is_valid) continue;
+        if (!query.zone_a) zones.emplace(query.location_a, nullptr);
+        if (!query.zone_b && query.location_b) zones.emplace(*query.location_b, nullptr);
+    }
+    for (auto& [name, zone] : zones) zone = resolver().resolve(name);
+
+    const auto zone_of = [&zones](const std::string& name, const std::uint32_t resolved) {
+        return resolved ? ZoneTables::zoneById(resolved) : zones.find(name)->second;
+    };
+
+    std::vector<QueryResult> results(queries.size());
+    pool.parallelFor(queries.size(), kBatchGrain, [&](const std::size_t first, const std::size_t last) {
+        for (std::size_t i = first; i < last; ++i) {
+            const auto& query = queries[i];
+            if (!query.is_valid) {
+                results[i] = evaluate(query, as_of, nullptr, nullptr);
+                continue;
+            }
+
+            results[i] = evaluate(query, as_of, zone_of(query.location_a, query.zone_a),
+                                  query.location_b ? zone_of(*query.location_b, query.zone_b) : nullptr);
+            if (render_text && results[i].ok()) {
+                TIMELIB_METRIC_TIME(Format);
+                render(std::back_inserter(results[i].result), results[i], query);
+            }
         }
-        return {ss.str(), ErrorCode::Success, ""};
+    });
+    return results;
+}
+
+QueryResult TimeConverter::calculateTimeDifference(const ParsedQuery& query, const date::time_zone* zone_a,
+                                                   const date::time_zone* zone_b, const date::sys_seconds now) {
+    if (!zone_a) return failure(ErrorCode::UnknownLocation, "Unknown location: ", query.location_a);
+    if (!zone_b) return failure(ErrorCode::UnknownLocation, "Unknown location: ", query.location_b.value_or(""));
+
+    try {
+        QueryResult result;
+        result.type = QueryType::Difference;
+        result.time = now;
+        result.source_zone = zone_a;
+        result.target_zone = zone_b;
+        result.source_offset = ZoneTables::offsetAt(zone_a, result.time);
+        result.target_offset = ZoneTables::offsetAt(zone_b, result.time);
+        result.offset_delta = result.source_offset.offset - result.target_offset.offset;
+        return result;
     } catch (const std::exception& e) {
-        return {"", ErrorCode::ProcessingError, "Error calculating time difference: " + std::string(e.what())};
+        return failure(ErrorCode::ProcessingError, "Error calculating time difference: ", e.what());
     }
 }
 
-QueryResult TimeConverter::convertTime(const ParsedQuery& query) {
-    const auto source_tz_str = resolveTimezone(query.location_a);
-    if (!source_tz_str) return {"", ErrorCode::UnknownLocation, "Unknown source location: " + query.location_a};
+QueryResult TimeConverter::convertTime(const ParsedQuery& query, const date::time_zone* source_zone,
+                                       const date::time_zone* target_zone, const date::sys_seconds now) {
+    if (!source_zone) return failure(ErrorCode::UnknownLocation, "Unknown source location: ", query.location_a);
 
-    if (!query.location_b) return {"", ErrorCode::NoTargetLocation, "No target location specified for the conversion."};
-    const auto target_tz_str = resolveTimezone(*query.location_b);
-    if (!target_tz_str) return {"", ErrorCode::UnknownLocation, "Unknown target location: " + *query.location_b};
+    if (!query.location_b) return failure(ErrorCode::NoTargetLocation, "No target location specified for the conversion.");
+    if (!target_zone) return failure(ErrorCode::UnknownLocation, "Unknown target location: ", *query.location_b);
 
     try {
-        const auto date = getCurrentDate();
-        const auto local_tp = date::local_days{date} +
+        // the hour is taken on today's (utc) date
+        const auto local_tp = date::local_days{date::floor<date::days>(now).time_since_epoch()} +
                         std::chrono::hours{query.hour} +
                         std::chrono::minutes{query.minute};
 
-        const auto source_zone = date::locate_zone(*source_tz_str);
-        const auto source_time = date::make_zoned(source_zone, local_tp, date::choose::earliest);
+        QueryResult result;
+        result.type = QueryType::Conversion;
+        result.time = ZoneTables::toSys(source_zone, local_tp, date::choose::earliest);
+        result.source_zone = source_zone;
+        result.target_zone = target_zone;
+        result.source_offset = ZoneTables::offsetAt(source_zone, result.time);
+        result.target_offset = ZoneTables::offsetAt(target_zone, result.time);
+        result.offset_delta = result.source_offset.offset - result.target_offset.offset;
+        return result;
+    } catch (const std::exception& e) {
+        return failure(ErrorCode::ProcessingError, "Error converting time: ", e.what());
+    }
+}
 
-        const auto target_zone = date::locate_zone(*target_tz_str);
-        const auto target_time = date::make_zoned(target_zone, source_time.get_sys_time());
+QueryResult TimeConverter::findMeetingWindows(const ParsedQuery& query, const date::time_zone* first_zone,
+                                             const date::sys_seconds now) {
+    if (!first_zone) return failure(ErrorCode::UnknownLocation, "Unknown location: ", query.location_a);
 
-        std::stringstream ss;
-        ss << formatTime(source_time) << " in " << query.location_a
-           << " is " << formatTime(target_time) << " in " << *query.location_b;
-        return {ss.str(), ErrorCode::Success, ""};
+    std::vector<WorkingHours> participants;
+    participants.reserve(query.locations.size());
+    for (const auto& location : query.locations) {
+        participants.push_back({location, std::chrono::minutes{query.hour * 60 + query.minute},
+                                std::chrono::minutes{query.end_hour * 60 + query.end_minute}});
+    }
 
+    try {
+        // days are the first location's days, from its midnight to its midnight, and this week
+        // runs up to its sunday. utc days would cut "today" in the middle of its working hours
+        // anywhere far enough from greenwich
+        const date::local_seconds local_now{now.time_since_epoch() + ZoneTables::offsetAt(first_zone, now).offset};
+        const date::local_days today = date::floor<date::days>(local_now);
+        const unsigned weekday = date::weekday{today}.c_encoding();
+        const date::days to_monday{weekday == 1 ? 7 : (8 - weekday) % 7};
+        date::local_days first = today;
+        date::local_days last = today + date::days{7};
+        switch (query.span) {
+            case MeetingSpan::Today: last = today + date::days{1}; break;
+            case MeetingSpan::Tomorrow: first = today + date::days{1}; last = today + date::days{2}; break;
+            case MeetingSpan::ThisWeek: last = today + to_monday; break;
+            case MeetingSpan::NextWeek: first = today + to_monday; last = first + date::days{7}; break;
+            case MeetingSpan::Week: break;
+        }
+        const auto midnight = [first_zone](const date::local_days day) {
+            return ZoneTables::toSys(first_zone, date::local_seconds{day}, date::choose::earliest);
+        };
+
+        MeetingWindows found = meetingWindows(participants, midnight(first), midnight(last));
+        if (!found.missing.empty()) return failure(ErrorCode::UnknownLocation, "Unknown location: ", found.missing.front());
+
+        QueryResult result;
+        result.type = QueryType::Meeting;
+        result.time = midnight(first);
+        result.source_zone = first_zone;
+        result.windows = std::move(found.windows);
+        return result;
     } catch (const std::exception& e) {
-        return {"", ErrorCode::ProcessingError, "Error converting time: " + std::string(e.what())};
+        return failure(ErrorCode::ProcessingError, "Error finding meeting times: ", e.what());
     }
 }
 
-QueryResult TimeConverter::getCurrentTimeIn(const std::string& location) {
-    const auto tz = resolveTimezone(location);
-    if (!tz) return {"", ErrorCode::UnknownLocation, "Unknown location: " + location};
+QueryResult TimeConverter::getCurrentTimeIn(const std::string& location, const date::time_zone* zone, const date::sys_seconds now) {
+    if (!zone) return failure(ErrorCode::UnknownLocation, "Unknown location: ", location);
     try {
-        const auto zone = date::locate_zone(*tz);
-        const auto time_in_seconds = std::chrono::time_point_cast<std::chrono::seconds>(std::chrono::system_clock::now());
-        const auto zoned_time = date::make_zoned(zone, time_in_seconds);
-        const std::string result = "The current time in " + location + " is " + formatTime(zoned_time);
-        return {result, ErrorCode::Success, ""};
+        QueryResult result;
+        result.type = QueryType::CurrentTime;
+        result.time = now;
+        result.source_zone = zone;
+        result.source_offset = ZoneTables::offsetAt(zone, result.time);
+        return result;
     } catch (const std::exception& e) {
-        return {"", ErrorCode::ProcessingError, "Error getting current time: " + std::string(e.what())};
+        return failure(ErrorCode::ProcessingError, "Error getting current time: ", e.what());
     }
 }
 
-void TimeConverter::parseTimeString(const std::string& time_str, ParsedQuery& result) {
-    std::string lower_time = time_str;
-    std::transform(lower_time.begin(), lower_time.end(), lower_time.begin(), ::tolower);
+struct TimeConverter::ClockState {
+    const std::shared_ptr<const Clock> system = std::make_shared<SystemClock>();
+    // published like the resolver's snapshots: a query reading the clock holds its own reference,
+    // so a replaced clock is freed (and a CoarseClock stops ticking) once the last one is done
+    std::shared_ptr<const Clock> current = system;
+};
+
+void TimeConverter::setClock(std::shared_ptr<const Clock> clock) {
+    auto& state = clockState();
+    std::atomic_store_explicit(&state.current, clock ? std::move(clock) : state.system, std::memory_order_release);
+    resultCache().clear();
+}
 
-    if (lower_time == "noon") { result.hour = 12; result.minute = 0; return; }
-    if (lower_time == "midnight") { result.hour = 0; result.minute = 0; return; }
+date::sys_seconds TimeConverter::now() {
+    return std::atomic_load_explicit(&clockState().current, std::memory_order_acquire)->now();
+}
 
-    const std::regex time_pattern(R"((\d{1,2})(?::(\d{2}))?\s*(am|pm)?)", std::regex_constants::icase);
-    if (std::smatch time_match; std::regex_search(lower_time, time_match, time_pattern)) {
-        const auto hour_opt = parseHour(time_match[1].str());
-        if (!hour_opt) return;
+struct TimeConverter::WarmupState {
+    std::mutex mutex;
+    std::shared_future<WarmupReport> future;
+    std::atomic<bool> ready{false};
 
-        result.hour = *hour_opt;
-        result.minute = time_match[2].matched ? parseMinute(time_match[2].str()).value_or(0) : 0;
+    // set once the state is torn down, an atomic bool is never destroyed itself
+    static inline std::atomic<bool> gone{false};
 
-        if (time_match[3].matched) {
-            if (const std::string ampm = time_match[3].str(); ampm == "pm" && result.hour != 12) result.hour += 12;
-            else if (ampm == "am" && result.hour == 12) result.hour = 0;
-        }
-    } else {
-        result.hour = -1;
+    // a program exiting while the task runs waits for it, see warmupState() for the order
+    ~WarmupState() {
+        if (future.valid()) future.wait();
+        gone.store(true, std::memory_order_release);
     }
+
+    // the task's exit hook. registered while the program was already exiting, it runs after the
+    // state's destructor has waited
+    static void waitAtExit() {
+        if (gone.load(std::memory_order_acquire)) return;
+        auto& state = warmupState();
+        std::unique_lock lock(state.mutex);
+        const auto future = state.future;
+        lock.unlock();
+        if (future.valid()) future.wait();
+    }
+};
+
+std::shared_future<WarmupReport> TimeConverter::warmup(const WarmupOptions& options) {
+    auto& state = warmupState();
+    std::lock_guard lock(state.mutex);
+    if (state.future.valid()) return state.future;
+
+    state.future = std::async(std::launch::async, [options, &state, started = std::chrono::steady_clock::now()] {
+        using std::chrono::duration_cast;
+        using std::chrono::microseconds;
+        using std::chrono::steady_clock;
+
+        WarmupReport report;
+        auto mark = steady_clock::now();
+        const auto lap = [&mark] {
+            const auto now = steady_clock::now();
+            const auto elapsed = duration_cast<microseconds>(now - mark);
+            mark = now;
+            return elapsed;
+        };
+
+        // constructing the resolver is what loads the tzdb, a query arriving meanwhile blocks on
+        // the same static initialization and goes on as soon as it's done
+        const auto snapshot = resolver().snapshot();
+        // the resolver and the tzdb may have been built just now, after the state, and would be
+        // torn down before its destructor waits. an exit hook registered after them runs first
+        [[maybe_unused]] static const bool hooked = std::atexit(WarmupState::waitAtExit) == 0;
+        report.tzdb_loaded = snapshot->tzdb() != nullptr;
+        report.tzdb = lap();
+
+        if (options.fuzzy) snapshot->fuzzyMatcher();
+        report.fuzzy = lap();
+
+        if (options.completion) IncrementalParser{};
+        report.completion = lap();
+
+        // the long part goes last, a query needing a zone that isn't done yet builds just that one
+        if (const date::tzdb* db = snapshot->tzdb()) {
+            std::vector<const date::time_zone*> zones;
+            if (options.all_zones) {
+                for (const auto& zone : db->zones) zones.push_back(&zone);
+            } else {
+                for (const auto& location : detail::kBuiltinLocations) zones.push_back(snapshot->findZone(location.timezone));
+                for (const auto& timezone : detail::kBuiltinTimezones) zones.push_back(snapshot->findZone(timezone.official_name));
+                std::sort(zones.begin(), zones.end());
+                zones.erase(std::unique(zones.begin(), zones.end()), zones.end());
+            }
+            for (const auto* zone : zones) {
+                if (zone && ZoneTables::find(zone)) ++report.zones_compiled;
+            }
+        }
+        report.tables = lap();
+
+        report.total = duration_cast<microseconds>(steady_clock::now() - started);
+        state.ready.store(true, std::memory_order_release);
+        return report;
+    }).share();
+    return state.future;
 }
 
-std::string TimeConverter::formatTime(const date::zoned_time<std::chrono::seconds>& zt) {
-    return date::format("%b %d, %I:%M %p (%Z)", zt);
+bool TimeConverter::ready() {
+    return warmupState().ready.load(std::memory_order_acquire);
 }
 
-std::optional<std::string> TimeConverter::resolveTimezone(const std::string& location_or_zone) {
-    try {
-        date::locate_zone(location_or_zone);
-        return location_or_zone;
-    } catch(...) { }
+bool TimeConverter::loadGazetteer(const std::string& path) {
+    std::shared_ptr<const Gazetteer> gazetteer = Gazetteer::open(path);
+    if (!gazetteer) return false;
+    resolver().setGazetteer(std::move(gazetteer));
+    return true;
+}
 
-    static LocationMap location_map;
-    static TimezoneMap timezone_map;
+bool TimeConverter::loadGeoIndex(const std::string& path) {
+    std::shared_ptr<const GeoIndex> index = GeoIndex::open(path, resolver().snapshot()->tzdb());
+    if (!index) return false;
+    resolver().setGeoIndex(std::move(index));
+    return true;
+}
 
-    std::string lower_loc = normalizeLocation(location_or_zone);
+const date::time_zone* TimeConverter::timezoneAt(const double latitude, const double longitude) {
+    return resolver().locate(latitude, longitude);
+}
 
-    if (location_map.hasLocation(lower_loc)) return location_map.getTimezone(lower_loc);
-    if (timezone_map.hasTimezone(lower_loc)) return timezone_map.getOfficialName(lower_loc);
+std::vector<const date::time_zone*> TimeConverter::timezonesAt(const std::vector<Coordinate>& coordinates) {
+    std::vector<const date::time_zone*> zones(coordinates.size());
+    const ZoneResolver& zone_resolver = resolver();
+    if (coordinates.size() <= kCoordinateGrain) {
+        zone_resolver.locate(coordinates.data(), coordinates.size(), zones.data());
+        return zones;
+    }
+    batchPool().parallelFor(coordinates.size(), kCoordinateGrain, [&](const std::size_t begin, const std::size_t end) {
+        zone_resolver.locate(coordinates.data() + begin, end - begin, zones.data() + begin);
+    });
+    return zones;
+}
 
-    return std::nullopt;
+void TimeConverter::setFuzzyOptions(const FuzzyOptions& options) {
+    resolver().setFuzzyOptions(options);
 }
 
-date::year_month_day TimeConverter::getCurrentDate() {
-    return date::floor<date::days>(std::chrono::system_clock::now());
+void TimeConverter::addLocation(const std::string& name, const std::string& timezone,
+                                const std::vector<std::string>& aliases) {
+    resolver().addLocation(name, timezone, aliases);
 }
 
-bool TimeConverter::isValidTime(const int hour, const int minute) {
-    return hour >= 0 && hour < 24 && minute >= 0 && minute < 60;
+bool TimeConverter::reload() {
+    return resolver().reload();
 }
 
-std::optional<int> TimeConverter::parseHour(const std::string& hour_str) {
-    try {
-        int hour = std::stoi(hour_str);
-        return (hour >= 0 && hour <= 24) ? std::optional<int>(hour) : std::nullopt;
-    } catch (...) { return std::nullopt; }
+const date::time_zone* TimeConverter::resolveTimezone(const std::string_view location_or_zone) {
+    return resolver().resolve(location_or_zone);
 }
 
-std::optional<int> TimeConverter::parseMinute(const std::string& minute_str) {
-    try {
-        int minute = std::stoi(minute_str);
-        return (minute >= 0 && minute <= 59) ? std::optional<int>(minute) : std::nullopt;
-    } catch (...) { return std::nullopt; }
+ZoneResolver& TimeConverter::resolver() {
+    static ZoneResolver instance;
+    return instance;
+}
+
+ResultCache& TimeConverter::resultCache() {
+    static ResultCache cache;
+    return cache;
+}
+
+TimeConverter::ClockState& TimeConverter::clockState() {
+    static ClockState state;
+    return state;
+}
+
+TimeConverter::WarmupState& TimeConverter::warmupState() {
+    // statics are torn down in the reverse order they were built in, and the state's destructor
+    // waits for a running warmup task. so what the task uses after it registered its exit hook
+    // is built before the state, and goes after the task is done
+    [[maybe_unused]] static const bool prepared = (ZoneTables::prepare(), Metrics::snapshot(), true);
+    static WarmupState state;
+    return state;
 }
 
-std::string TimeConverter::normalizeLocation(const std::string& location) {
-    std::string normalized = location;
-    normalized.erase(0, normalized.find_first_not_of(" \t\n\r\f\v"));
-    normalized.erase(normalized.find_last_not_of(" \t\n\r\f\v") + 1);
-    std::transform(normalized.begin(), normalized.end(), normalized.begin(), ::tolower);
-    return normalized;
+ThreadPool& TimeConverter::batchPool() {
+    static ThreadPool pool;
+    return pool;
 }
 
 }
@@ -0,0 +1,82 @@
+#include "world_clock.hpp"
+#include "resolver.hpp"
+#include <algorithm>
+
+namespace timelib {
+
+WorldClock::WorldClock(const ZoneResolver& resolver, const std::vector<std::string>& locations, const Clock& clock)
+    : WorldClock(resolver, locations, clock.now()) {}
+
+WorldClock::WorldClock(const ZoneResolver& resolver, const std::vector<std::string>& locations, const date::sys_seconds around) {
+    const std::int64_t t = around.time_since_epoch().count();
+    for (const auto& location : locations) {
+        const date::time_zone* zone = resolver.resolve(location);
+        if (!zone) {
+            missing_.push_back(location);
+            continue;
+        }
+
+        names_.push_back(location);
+        zones_.push_back(zone);
+
+        if (const auto* table = ZoneTables::find(zone); table && table->covers(around)) {
+            const auto& starts = table->starts();
+            const auto i = static_cast<std::size_t>(std::upper_bound(starts.begin(), starts.end(), t) - starts.begin()) - 1;
+            window_starts_.push_back(starts[i]);
+            window_ends_.push_back(i + 1 < starts.size() ? starts[i + 1] : table->rangeEnd());
+            window_offsets_.push_back(table->offsets()[i]);
+            window_abbrevs_.push_back(table->abbrevIds()[i]);
+        } else {
+            const auto info = zone->get_info(around);
+            window_starts_.push_back(date::floor<std::chrono::seconds>(info.begin).time_since_epoch().count());
+            window_ends_.push_back(date::floor<std::chrono::seconds>(info.end).time_since_epoch().count());
+            window_offsets_.push_back(static_cast<std::int32_t>(info.offset.count()));
+            window_abbrevs_.push_back(CompiledZone::internAbbrev(info.abbrev));
+        }
+    }
+}
+
+void WorldClock::at(const date::sys_seconds instant, WorldClockReadings& out) const {
+    const std::size_t n = zones_.size();
+    const std::int64_t t = instant.time_since_epoch().count();
+
+    out.instant = instant;
+    out.local_times.resize(n);
+    out.offsets.resize(n);
+    out.abbrevs.resize(n);
+
+    // straight copies from the cached intervals, counting the targets they don't cover
+    std::size_t outside = 0;
+    for (std::size_t i = 0; i < n; ++i) {
+        outside += static_cast<std::size_t>(t < window_starts_[i]) | static_cast<std::size_t>(t >= window_ends_[i]);
+        out.offsets[i] = window_offsets_[i];
+        out.abbrevs[i] = window_abbrevs_[i];
+    }
+
+    if (outside != 0) {
+        for (std::size_t i = 0; i < n; ++i) {
+            if (t >= window_starts_[i] && t < window_ends_[i]) continue;
+            const ZoneOffset offset = ZoneTables::offsetAt(zones_[i], instant);
+            out.offsets[i] = static_cast<std::int32_t>(offset.offset.count());
+            out.abbrevs[i] = CompiledZone::internAbbrev(offset.abbrev);
+        }
+    }
+
+    for (std::size_t i = 0; i < n; ++i) out.local_times[i] = t + out.offsets[i];
+}
+
+WorldClockReadings WorldClock::at(const date::sys_seconds instant) const {
+    WorldClockReadings readings;
+    at(instant, readings);
+    return readings;
+}
+
+WorldClockReadings WorldClock::at(const date::time_zone* source, const date::local_seconds local) const {
+    return at(ZoneTables::toSys(source, local, date::choose::earliest));
+}
+
+WorldClockReadings WorldClock::now(const Clock& clock) const {
+    return at(clock.now());
+}
+
+}
@@ -0,0 +1,161 @@
+#include "zone_image.hpp"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <unordered_map>
+#include <vector>
+
+namespace timelib {
+
+namespace {
+
+std::int64_t startOfYear(const date::year y) {
+    const date::sys_days day = date::year_month_day{y, date::January, date::day{1}};
+    return std::chrono::duration_cast<std::chrono::seconds>(day.time_since_epoch()).count();
+}
+
+}
+
+std::unique_ptr<const ZoneImage> ZoneImage::open(const std::string& path) {
+    std::unique_ptr<ZoneImage> image(new ZoneImage());
+    image->file_ = detail::MappedFile::open(path);
+    if (!image->file_ || !image->validate()) return nullptr;
+    return image;
+}
+
+bool ZoneImage::validate() {
+    detail::SectionCursor sections(file_);
+    if (!sections.next<image::Header>(1)) return false;
+    const auto& head = header();
+    if (std::memcmp(head.magic, image::kMagic, sizeof(head.magic)) != 0) return false;
+    if (head.version != image::kVersion || head.first_year >= head.last_year) return false;
+    if (std::find(head.tzdata, head.tzdata + image::kTzdataSize, '\0') == head.tzdata + image::kTzdataSize) return false;
+
+    zones_ = sections.next<image::ZoneEntry>(head.zone_count);
+    abbrevs_ = sections.next<image::StringRef>(head.abbrev_count);
+    starts_ = sections.next<std::int64_t>(head.interval_count);
+    offsets_ = sections.next<std::int32_t>(head.interval_count);
+    abbrev_ids_ = sections.next<std::uint16_t>(head.interval_count);
+    strings_ = sections.next<char>(head.strings_size);
+    if (!zones_ || !abbrevs_ || !starts_ || !offsets_ || !abbrev_ids_ || !strings_) return false;
+
+    // the string refs are few and get dereferenced without checks later, so vet them all now.
+    // interval contents are checked per zone when it's compiled
+    const auto in_blob = [&](const image::StringRef ref) {
+        return ref.offset <= head.strings_size && ref.size <= head.strings_size - ref.offset;
+    };
+    for (std::uint32_t i = 0; i < head.zone_count; ++i) {
+        const auto& zone = zones_[i];
+        if (!in_blob(zone.name) || zone.interval_count == 0) return false;
+        if (zone.first_interval > head.interval_count || zone.interval_count > head.interval_count - zone.first_interval) return false;
+    }
+    return std::all_of(abbrevs_, abbrevs_ + head.abbrev_count, in_blob);
+}
+
+std::string_view ZoneImage::tzdataVersion() const {
+    const char* version = header().tzdata;
+    return {version, static_cast<std::size_t>(std::find(version, version + image::kTzdataSize, '\0') - version)};
+}
+
+std::unique_ptr<const CompiledZone> ZoneImage::compile(const date::time_zone* zone) const {
+    const std::string_view name = zone->name();
+    const auto* end = zones_ + header().zone_count;
+    const auto* entry = std::lower_bound(zones_, end, name, [this](const image::ZoneEntry& e, const std::string_view key) {
+        return string(e.name) < key;
+    });
+    if (entry == end || string(entry->name) != name) return nullptr;
+
+    const std::int64_t* starts = starts_ + entry->first_interval;
+    const std::int32_t* offsets = offsets_ + entry->first_interval;
+    const std::uint16_t* ids = abbrev_ids_ + entry->first_interval;
+    const std::size_t count = entry->interval_count;
+
+    const std::int64_t begin = startOfYear(firstYear());
+    if (starts[0] != begin || !std::is_sorted(starts, starts + count)) return nullptr;
+
+    // image ids are local to the file, the tables want process-wide interned ones
+    std::vector<std::uint16_t> abbrevs(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        if (ids[i] >= header().abbrev_count) return nullptr;
+        abbrevs[i] = CompiledZone::internAbbrev(string(abbrevs_[ids[i]]));
+    }
+
+    return std::make_unique<const CompiledZone>(zone, begin, startOfYear(lastYear()),
+                                                std::vector<std::int64_t>(starts, starts + count),
+                                                std::vector<std::int32_t>(offsets, offsets + count),
+                                                std::move(abbrevs));
+}
+
+std::size_t ZoneImage::write(const std::string& path, const date::year first, const date::year last) {
+    if (first >= last) return 0;
+
+    const date::tzdb* db = nullptr;
+    try {
+        db = &date::get_tzdb();
+    } catch (const std::exception&) {
+        return 0;
+    }
+    // the release has to fit with a terminator, or the image couldn't be matched against it
+    if (db->version.empty() || db->version.size() >= image::kTzdataSize) return 0;
+
+    std::vector<image::ZoneEntry> zones;
+    std::vector<image::StringRef> abbrevs;
+    std::vector<std::int64_t> starts;
+    std::vector<std::int32_t> offsets;
+    std::vector<std::uint16_t> abbrev_ids;
+    std::string strings;
+    std::unordered_map<std::uint16_t, std::uint16_t> local_ids;
+
+    const auto add_string = [&strings](const std::string_view text) {
+        const image::StringRef ref{static_cast<std::uint32_t>(strings.size()), static_cast<std::uint32_t>(text.size())};
+        strings.append(text);
+        return ref;
+    };
+
+    for (const auto& zone : db->zones) {
+        const CompiledZone table(&zone, first, last);
+        if (table.size() == 0) continue;
+
+        zones.push_back({add_string(zone.name()), static_cast<std::uint32_t>(starts.size()), static_cast<std::uint32_t>(table.size())});
+        starts.insert(starts.end(), table.starts().begin(), table.starts().end());
+        offsets.insert(offsets.end(), table.offsets().begin(), table.offsets().end());
+
+        for (const std::uint16_t id : table.abbrevIds()) {
+            const auto [it, added] = local_ids.emplace(id, static_cast<std::uint16_t>(abbrevs.size()));
+            if (added) abbrevs.push_back(add_string(CompiledZone::abbrev(id)));
+            abbrev_ids.push_back(it->second);
+        }
+    }
+
+    std::sort(zones.begin(), zones.end(), [&strings](const image::ZoneEntry& a, const image::ZoneEntry& b) {
+        return std::string_view(strings).substr(a.name.offset, a.name.size) <
+               std::string_view(strings).substr(b.name.offset, b.name.size);
+    });
+
+    image::Header head{};
+    std::memcpy(head.magic, image::kMagic, sizeof(head.magic));
+    head.version = image::kVersion;
+    std::memcpy(head.tzdata, db->version.data(), db->version.size());
+    head.first_year = static_cast<int>(first);
+    head.last_year = static_cast<int>(last);
+    head.zone_count = static_cast<std::uint32_t>(zones.size());
+    head.abbrev_count = static_cast<std::uint32_t>(abbrevs.size());
+    head.interval_count = static_cast<std::uint32_t>(starts.size());
+    head.strings_size = static_cast<std::uint32_t>(strings.size());
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) return 0;
+
+    out.write(reinterpret_cast<const char*>(&head), sizeof(head));
+    detail::writeSection(out, zones);
+    detail::writeSection(out, abbrevs);
+    detail::writeSection(out, starts);
+    detail::writeSection(out, offsets);
+    detail::writeSection(out, abbrev_ids);
+    detail::writeSection(out, std::vector<char>(strings.begin(), strings.end()));
+
+    out.close();
+    return out ? zones.size() : 0;
+}
+
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <iostream>
+#include <sstream>
+#include <string>
+
+// just enough of a test harness for the ctest targets: a failed check prints where and what, and
+// main returns the number of failures
+namespace timelib::test {
+
+    inline int& failures() {
+        static int count = 0;
+        return count;
+    }
+
+    inline void fail(const char* file, const int line, const std::string& what) {
+        std::cerr << file << ":" << line << ": " << what << "\n";
+        ++failures();
+    }
+
+    inline int result(const char* name) {
+        if (failures() == 0) {
+            std::cout << name << ": ok\n";
+            return 0;
+        }
+        std::cerr << name << ": " << failures() << " failed\n";
+        return 1;
+    }
+
+}
+
+#define TIMELIB_CHECK(condition)                                                       \
+    do {                                                                               \
+        if (!(condition)) timelib::test::fail(__FILE__, __LINE__, "check failed: " #condition); \
+    } while (false)
+
+#define TIMELIB_CHECK_EQ(actual, expected)                                             \
+    do {                                                                               \
+        const auto& timelib_actual_ = (actual);                                        \
+        const auto& timelib_expected_ = (expected);                                    \
+        if (!(timelib_actual_ == timelib_expected_)) {                                 \
+            std::ostringstream timelib_out_;                                           \
+            timelib_out_ << #actual " is " << timelib_actual_ << ", expected " << timelib_expected_; \
+            timelib::test::fail(__FILE__, __LINE__, timelib_out_.str());               \
+        }                                                                              \
+    } while (false)
@@ -0,0 +1,282 @@
+#include "check.hpp"
+#include "daemon.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <poll.h>
+#include <spawn.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// runs timelibd on a socket in a fresh temp directory and talks to it like a client would, and
+// through timelib_query.
+// usage: timelib_test_daemon <path to timelibd> <path to timelib_query>
+
+extern char** environ;
+
+namespace {
+
+constexpr auto kTimeout = std::chrono::seconds(20);
+
+std::string daemon_binary;
+std::string query_binary;
+
+pid_t start(const std::string& path) {
+    const char* argv[] = {daemon_binary.c_str(), path.c_str(), nullptr};
+    pid_t pid = -1;
+    if (posix_spawn(&pid, daemon_binary.c_str(), nullptr, nullptr, const_cast<char**>(argv), environ) != 0) return -1;
+    return pid;
+}
+
+// timelib_query with stdin and stdout on files
+pid_t startQuery(const std::string& path, const std::string& input, const std::string& output) {
+    posix_spawn_file_actions_t files;
+    posix_spawn_file_actions_init(&files);
+    posix_spawn_file_actions_addopen(&files, STDIN_FILENO, input.c_str(), O_RDONLY, 0);
+    posix_spawn_file_actions_addopen(&files, STDOUT_FILENO, output.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0600);
+
+    const char* argv[] = {query_binary.c_str(), "-s", path.c_str(), nullptr};
+    pid_t pid = -1;
+    if (posix_spawn(&pid, query_binary.c_str(), &files, nullptr, const_cast<char**>(argv), environ) != 0) pid = -1;
+    posix_spawn_file_actions_destroy(&files);
+    return pid;
+}
+
+// the exit status, -1 when it was killed or didn't exit in time
+int wait(const pid_t pid) {
+    for (const auto until = std::chrono::steady_clock::now() + kTimeout; std::chrono::steady_clock::now() < until;) {
+        int status = 0;
+        if (waitpid(pid, &status, WNOHANG) == pid) return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    kill(pid, SIGKILL);
+    waitpid(pid, nullptr, 0);
+    return -1;
+}
+
+sockaddr_un addressOf(const std::string& path) {
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+    return address;
+}
+
+// retries while the daemon is still loading the tzdb
+int connectTo(const std::string& path) {
+    const sockaddr_un address = addressOf(path);
+    for (const auto until = std::chrono::steady_clock::now() + kTimeout; std::chrono::steady_clock::now() < until;) {
+        const int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd >= 0 && connect(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) == 0) return fd;
+        if (fd >= 0) close(fd);
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+    return -1;
+}
+
+void sendAll(const int fd, const std::string& data) {
+    for (std::size_t sent = 0; sent < data.size();) {
+        const ssize_t n = send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0) {
+            timelib::test::fail(__FILE__, __LINE__, std::string("send: ") + std::strerror(errno));
+            return;
+        }
+        sent += static_cast<std::size_t>(n);
+    }
+}
+
+// everything up to the daemon closing the connection
+std::string readAll(const int fd) {
+    std::string data;
+    char buffer[16384];
+    const auto until = std::chrono::steady_clock::now() + kTimeout;
+    while (std::chrono::steady_clock::now() < until) {
+        pollfd ready{fd, POLLIN, 0};
+        if (poll(&ready, 1, 100) <= 0) continue;
+        const ssize_t n = read(fd, buffer, sizeof(buffer));
+        if (n > 0) {
+            data.append(buffer, static_cast<std::size_t>(n));
+        } else if (n == 0 || errno != EINTR) {
+            return data;
+        }
+    }
+    timelib::test::fail(__FILE__, __LINE__, "the daemon didn't close the connection");
+    return data;
+}
+
+std::vector<std::string> lines(const std::string& data) {
+    std::vector<std::string> out;
+    for (std::size_t start = 0, end; (end = data.find('\n', start)) != std::string::npos; start = end + 1) {
+        out.push_back(data.substr(start, end - start));
+    }
+    return out;
+}
+
+std::string ask(const std::string& path, const std::string& request) {
+    const int fd = connectTo(path);
+    if (fd < 0) return "<no daemon>";
+    sendAll(fd, request);
+    shutdown(fd, SHUT_WR);
+    std::string answer = readAll(fd);
+    close(fd);
+    return answer;
+}
+
+void pipelining(const std::string& path) {
+    const char* requests[] = {"!ping", "time in london", "time in qzxqzx"};
+    std::string request;
+    for (int i = 0; i < 600; ++i) request += std::string(requests[i % 3]) + (i % 2 ? "\r\n" : "\n");
+
+    const auto answers = lines(ask(path, request));
+    TIMELIB_CHECK_EQ(answers.size(), std::size_t{600});
+    for (std::size_t i = 0; i < answers.size(); ++i) {
+        const std::string& answer = answers[i];
+        switch (i % 3) {
+            case 0: TIMELIB_CHECK_EQ(answer, std::string("0\tpong")); break;
+            case 1: TIMELIB_CHECK_EQ(answer.substr(0, 2), std::string("0\t")); break;
+            default: TIMELIB_CHECK_EQ(answer.substr(0, 2), std::string("3\t")); break;
+        }
+    }
+}
+
+void lastLineWithoutNewline(const std::string& path) {
+    TIMELIB_CHECK_EQ(ask(path, "!ping\n!ping"), std::string("0\tpong\n0\tpong\n"));
+}
+
+void longLine(const std::string& path) {
+    TIMELIB_CHECK_EQ(ask(path, "!ping\n" + std::string(5000, 'x') + "\n"), std::string("0\tpong\n1\trequest line too long\n"));
+}
+
+// a client that writes without reading gets its writes blocked once enough answers wait for it,
+// the others are still served meanwhile, and it gets every answer once it reads them
+void backpressure(const std::string& path) {
+    const int fd = connectTo(path);
+    if (fd < 0) return timelib::test::fail(__FILE__, __LINE__, "could not connect");
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+
+    std::string chunk;
+    for (int i = 0; i < 4096; ++i) chunk += "!ping\n";
+
+    constexpr std::size_t kLimit = std::size_t{64} << 20;
+    std::size_t sent = 0;
+    while (sent < kLimit) {
+        const ssize_t n = send(fd, chunk.data(), chunk.size(), MSG_NOSIGNAL);
+        if (n > 0) {
+            sent += static_cast<std::size_t>(n);
+            if (static_cast<std::size_t>(n) < chunk.size()) chunk = chunk.substr(static_cast<std::size_t>(n)) + chunk.substr(0, static_cast<std::size_t>(n));
+            continue;
+        }
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK) break;
+        // still blocked after a while means the daemon stopped reading
+        pollfd writable{fd, POLLOUT, 0};
+        if (poll(&writable, 1, 1000) == 0) break;
+    }
+    TIMELIB_CHECK(sent < kLimit);
+
+    TIMELIB_CHECK_EQ(ask(path, "!ping\n"), std::string("0\tpong\n"));
+
+    shutdown(fd, SHUT_WR);
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) & ~O_NONBLOCK);
+    const auto answers = lines(readAll(fd));
+    close(fd);
+
+    // a request cut off by the blocked write is answered as the last line
+    TIMELIB_CHECK_EQ(answers.size(), sent / 6 + (sent % 6 ? 1 : 0));
+    std::size_t pongs = 0;
+    for (std::size_t i = 0; i < answers.size() && answers[i] == "0\tpong"; ++i) ++pongs;
+    TIMELIB_CHECK_EQ(pongs, sent / 6);
+}
+
+// far more answers than the daemon holds for one client, so the client has to read them while
+// it's still sending
+void queryClient(const std::string& path, const std::string& directory) {
+    constexpr std::size_t kRequests = 400000;
+    static_assert(kRequests * 7 > 2 * timelib::daemon::kMaxPendingOutput, "the answers have to back up");
+
+    const std::string input = directory + "/requests";
+    const std::string output = directory + "/answers";
+    {
+        std::string requests;
+        for (std::size_t i = 0; i < kRequests; ++i) requests += "!ping\n";
+        const int fd = open(input.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+        TIMELIB_CHECK(fd >= 0 && write(fd, requests.data(), requests.size()) == static_cast<ssize_t>(requests.size()));
+        if (fd >= 0) close(fd);
+    }
+
+    const pid_t client = startQuery(path, input, output);
+    TIMELIB_CHECK(client > 0);
+    if (client > 0) TIMELIB_CHECK_EQ(wait(client), 0);
+
+    std::string answers;
+    if (const int fd = open(output.c_str(), O_RDONLY | O_CLOEXEC); fd >= 0) {
+        char buffer[65536];
+        for (ssize_t n; (n = read(fd, buffer, sizeof(buffer))) > 0;) answers.append(buffer, static_cast<std::size_t>(n));
+        close(fd);
+    }
+    const auto lines_read = lines(answers);
+    TIMELIB_CHECK_EQ(lines_read.size(), kRequests);
+    TIMELIB_CHECK(std::all_of(lines_read.begin(), lines_read.end(), [](const std::string& line) { return line == "pong"; }));
+
+    unlink(input.c_str());
+    unlink(output.c_str());
+}
+
+}
+
+int main(int argc, char** argv) {
+    if (argc != 3) {
+        std::cerr << "usage: " << argv[0] << " <path to timelibd> <path to timelib_query>" << std::endl;
+        return 2;
+    }
+    daemon_binary = argv[1];
+    query_binary = argv[2];
+
+    char directory[] = "/tmp/timelibd-test-XXXXXX";
+    if (!mkdtemp(directory)) {
+        std::cerr << "mkdtemp: " << std::strerror(errno) << std::endl;
+        return 1;
+    }
+    const std::string path = std::string(directory) + "/timelibd.sock";
+
+    // a socket file nothing answers on, as a daemon that was killed leaves it behind
+    {
+        const int stale = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        const sockaddr_un address = addressOf(path);
+        TIMELIB_CHECK(bind(stale, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) == 0);
+        close(stale);
+    }
+
+    const pid_t daemon = start(path);
+    TIMELIB_CHECK(daemon > 0);
+    if (daemon > 0) {
+        pipelining(path);
+        lastLineWithoutNewline(path);
+        longLine(path);
+        backpressure(path);
+        queryClient(path, directory);
+
+        // a second daemon on the same socket leaves the running one alone
+        const pid_t second = start(path);
+        TIMELIB_CHECK(second > 0);
+        if (second > 0) TIMELIB_CHECK_EQ(wait(second), 1);
+        TIMELIB_CHECK_EQ(ask(path, "!ping\n"), std::string("0\tpong\n"));
+
+        kill(daemon, SIGTERM);
+        TIMELIB_CHECK_EQ(wait(daemon), 0);
+        TIMELIB_CHECK(access(path.c_str(), F_OK) != 0);
+    }
+
+    unlink(path.c_str());
+    rmdir(directory);
+    return timelib::test::result("daemon");
+}
@@ -0,0 +1,51 @@
+#include "check.hpp"
+#include "fuzzy.hpp"
+#include "location.hpp"
+#include "resolver.hpp"
+#include <string>
+
+// misspelled names are found by the fuzzy matcher, not by aliases listed in the tables, and the
+// matcher's typo limits follow FuzzyOptions
+
+namespace {
+
+std::string zoneName(const timelib::ZoneResolver& resolver, const std::string_view location) {
+    const date::time_zone* zone = resolver.resolve(location);
+    return zone ? zone->name() : "<none>";
+}
+
+}
+
+int main() {
+    const timelib::LocationMap locations;
+    for (const char* typo : {"londn", "pari", "berln", "sydny", "bombai"}) {
+        if (locations.hasLocation(typo)) timelib::test::fail(__FILE__, __LINE__, std::string(typo) + " is a listed alias");
+    }
+
+    const timelib::ZoneResolver resolver;
+    TIMELIB_CHECK_EQ(zoneName(resolver, "londn"), std::string("Europe/London"));
+    TIMELIB_CHECK_EQ(zoneName(resolver, "pari"), std::string("Europe/Paris"));
+    TIMELIB_CHECK_EQ(zoneName(resolver, "berln"), std::string("Europe/Berlin"));
+    TIMELIB_CHECK_EQ(zoneName(resolver, "sydny"), std::string("Australia/Sydney"));
+    TIMELIB_CHECK_EQ(zoneName(resolver, "bombai"), std::string("Asia/Kolkata"));
+    TIMELIB_CHECK_EQ(zoneName(resolver, "buenos airs"), std::string("America/Argentina/Buenos_Aires"));
+
+    // too far off for the matcher, so it stays an alias
+    TIMELIB_CHECK(locations.hasLocation("melbrn"));
+    TIMELIB_CHECK_EQ(zoneName(resolver, "melbrn"), std::string("Australia/Melbourne"));
+
+    // three edits in six letters: over one per three characters, within one per two
+    const timelib::FuzzyMatcher matcher({{"melbourne", "Australia/Melbourne", "melbourne", timelib::NameKind::LocationName}});
+    timelib::FuzzyOptions options;
+    options.max_distance = 3;
+    options.min_confidence = 0.5;
+    TIMELIB_CHECK(matcher.search("melbrn", options, 5).empty());
+    options.chars_per_edit = 2;
+    TIMELIB_CHECK(matcher.best("melbrn", options).has_value());
+    options.chars_per_edit = 0;
+    TIMELIB_CHECK_EQ(matcher.search("melbrn", options, 5).size(), std::size_t{1});
+    options.max_distance = 2;
+    TIMELIB_CHECK(matcher.search("melbrn", options, 5).empty());
+
+    return timelib::test::result("fuzzy_names");
+}
@@ -0,0 +1,247 @@
+#include "alias_table.hpp"
+#include "check.hpp"
+#include "gazetteer.hpp"
+#include "resolver.hpp"
+#include "time.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+// compiles a small made up GeoNames dump and checks ranking and country keys, that files with a
+// broken header or references outside their sections are turned away, and that the resolver
+// asks the gazetteer before the fuzzy matcher
+
+namespace {
+
+// the columns timelib_gazcompile reads, the rest stay empty like in a real dump
+std::string row(const char* name, const char* ascii, const char* alternates, const char* country, const unsigned population,
+                const char* zone) {
+    std::vector<std::string> columns(19);
+    columns[1] = name;
+    columns[2] = ascii;
+    columns[3] = alternates;
+    columns[8] = country;
+    columns[14] = std::to_string(population);
+    columns[17] = zone;
+    std::string line;
+    for (std::size_t i = 0; i < columns.size(); ++i) line += (i ? "\t" : "") + columns[i];
+    return line + "\n";
+}
+
+std::string tsv() {
+    return "# not a place\n" + row("Paris", "Paris", "Lutece,Parigi,Paryz", "FR", 2138551, "Europe/Paris") +
+           row("Paris", "Paris", "", "US", 24171, "America/Chicago") +
+           row("Winterthur", "Winterthur", "Vitudurum,Winterthour", "CH", 111851, "Europe/Zurich") +
+           row("Sidney", "Sidney", "", "US", 20421, "America/New_York") +
+           row("Jerusalem", "Jerusalem", "IST,Yerushalayim", "IL", 801000, "Asia/Jerusalem") +
+           row("S\xc3\xa3o Paulo", "Sao Paulo", "", "BR", 10021295, "America/Sao_Paulo") +
+           // too small for the default cutoff
+           row("Paris", "Paris", "", "CA", 12310, "America/Toronto") +
+           // no timezone, and too few columns
+           row("Nowhere", "Nowhere", "", "XX", 50000, "") + "1\tShort\tShort\n";
+}
+
+std::string readFile(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    return {std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+}
+
+void writeFile(const std::string& path, const std::string& data) {
+    std::ofstream(path, std::ios::binary | std::ios::trunc).write(data.data(), static_cast<std::streamsize>(data.size()));
+}
+
+// the file with one number changed
+std::string patched(std::string data, const std::size_t offset, const std::uint32_t value) {
+    std::memcpy(&data[offset], &value, sizeof(value));
+    return data;
+}
+
+template <class T>
+T read(const std::string& data, const std::size_t offset) {
+    T value;
+    std::memcpy(&value, data.data() + offset, sizeof(value));
+    return value;
+}
+
+std::string zoneOf(const timelib::Gazetteer& gazetteer, const std::string_view name) {
+    const std::uint32_t place = gazetteer.find(name);
+    return place == timelib::Gazetteer::kNone ? "<none>" : std::string(gazetteer.timezone(place));
+}
+
+std::string queryZone(const char* input) {
+    const timelib::QueryResult result = timelib::TimeConverter::evaluate(timelib::TimeConverter().parseInput(input));
+    return result.ok() && result.source_zone ? result.source_zone->name() : "<none>";
+}
+
+}
+
+int main() {
+    char directory[] = "/tmp/timelib-gazetteer-test-XXXXXX";
+    if (!mkdtemp(directory)) {
+        std::cerr << "mkdtemp failed" << std::endl;
+        return 1;
+    }
+    const std::string source = std::string(directory) + "/cities.txt";
+    const std::string path = std::string(directory) + "/places.gaz";
+    const std::string corrupt = std::string(directory) + "/corrupt.gaz";
+    writeFile(source, tsv());
+
+    TIMELIB_CHECK(timelib::Gazetteer::open(path) == nullptr);
+    TIMELIB_CHECK_EQ(timelib::Gazetteer::write(std::string(directory) + "/missing.txt", path), std::size_t{0});
+
+    // a lower cutoff lets the small paris in, and it ranks last
+    timelib::GazetteerOptions options;
+    options.min_population = 10000;
+    TIMELIB_CHECK_EQ(timelib::Gazetteer::write(source, path, options), std::size_t{7});
+    if (const auto everything = timelib::Gazetteer::open(path)) {
+        const auto parises = everything->findAll("paris");
+        TIMELIB_CHECK_EQ(parises.size(), std::size_t{3});
+        if (parises.size() == 3) TIMELIB_CHECK_EQ(std::string(everything->timezone(parises[2])), std::string("America/Toronto"));
+        TIMELIB_CHECK_EQ(everything->findAll("paris", 2).size(), std::size_t{2});
+    } else {
+        timelib::test::fail(__FILE__, __LINE__, "open with a lower cutoff failed");
+    }
+
+    // without the alternate names column
+    options = {};
+    options.alternate_names = false;
+    TIMELIB_CHECK_EQ(timelib::Gazetteer::write(source, path, options), std::size_t{6});
+    if (const auto plain = timelib::Gazetteer::open(path)) {
+        TIMELIB_CHECK_EQ(zoneOf(*plain, "lutece"), std::string("<none>"));
+        TIMELIB_CHECK_EQ(zoneOf(*plain, "paris"), std::string("Europe/Paris"));
+    } else {
+        timelib::test::fail(__FILE__, __LINE__, "open without alternate names failed");
+    }
+
+    TIMELIB_CHECK_EQ(timelib::Gazetteer::write(source, path), std::size_t{6});
+    const auto gazetteer = timelib::Gazetteer::open(path);
+    TIMELIB_CHECK(gazetteer != nullptr);
+    if (!gazetteer) return timelib::test::result("gazetteer");
+    TIMELIB_CHECK_EQ(gazetteer->size(), std::size_t{6});
+
+    // places are numbered most populous first, a shared name goes to the biggest and the country
+    // key picks the other
+    for (std::uint32_t p = 1; p < gazetteer->size(); ++p) TIMELIB_CHECK(gazetteer->population(p - 1) >= gazetteer->population(p));
+    const auto parises = gazetteer->findAll("paris");
+    TIMELIB_CHECK_EQ(parises.size(), std::size_t{2});
+    if (parises.size() == 2) {
+        TIMELIB_CHECK(parises[0] < parises[1]);
+        TIMELIB_CHECK_EQ(gazetteer->population(parises[0]), 2138551u);
+        TIMELIB_CHECK_EQ(std::string(gazetteer->timezone(parises[1])), std::string("America/Chicago"));
+    }
+    TIMELIB_CHECK_EQ(zoneOf(*gazetteer, "paris"), std::string("Europe/Paris"));
+    TIMELIB_CHECK_EQ(zoneOf(*gazetteer, "paris, us"), std::string("America/Chicago"));
+    TIMELIB_CHECK_EQ(zoneOf(*gazetteer, "Paris, FR"), std::string("Europe/Paris"));
+    TIMELIB_CHECK_EQ(zoneOf(*gazetteer, "paris, ca"), std::string("<none>"));
+    TIMELIB_CHECK_EQ(zoneOf(*gazetteer, "sao paulo, br"), std::string("America/Sao_Paulo"));
+    TIMELIB_CHECK_EQ(zoneOf(*gazetteer, "S\xc3\xa3o Paulo"), std::string("America/Sao_Paulo"));
+    TIMELIB_CHECK_EQ(zoneOf(*gazetteer, "VITUDURUM"), std::string("Europe/Zurich"));
+    TIMELIB_CHECK_EQ(zoneOf(*gazetteer, "nowhere"), std::string("<none>"));
+    TIMELIB_CHECK_EQ(zoneOf(*gazetteer, "short"), std::string("<none>"));
+    TIMELIB_CHECK(gazetteer->findAll("pari").empty());
+
+    const std::uint32_t winterthur = gazetteer->find("winterthur");
+    TIMELIB_CHECK_EQ(std::string(gazetteer->name(winterthur)), std::string("Winterthur"));
+    auto aliases = gazetteer->aliases(winterthur);
+    std::sort(aliases.begin(), aliases.end());
+    TIMELIB_CHECK(aliases == std::vector<std::string>({"vitudurum", "winterthour", "winterthur, ch"}));
+
+    // the keys are stored lowercased and sorted, with each distinct text once
+    const std::string data = readFile(path);
+    const auto head = read<timelib::places::Header>(data, 0);
+    const std::size_t zones = timelib::detail::alignUp(sizeof(head));
+    const std::size_t places = timelib::detail::alignUp(zones + head.zone_count * sizeof(timelib::places::StringRef));
+    const std::size_t keys = timelib::detail::alignUp(places + head.place_count * sizeof(timelib::places::Place));
+    const std::size_t postings = timelib::detail::alignUp(keys + head.key_count * sizeof(timelib::places::Key));
+    const std::size_t place_keys = timelib::detail::alignUp(postings + head.posting_count * sizeof(std::uint32_t));
+    const std::size_t strings = timelib::detail::alignUp(place_keys + head.place_key_count * sizeof(std::uint32_t));
+    TIMELIB_CHECK_EQ(strings + head.strings_size, data.size());
+
+    std::vector<std::string> texts;
+    for (std::uint32_t k = 0; k < head.key_count; ++k) {
+        const auto ref = read<timelib::places::Key>(data, keys + k * sizeof(timelib::places::Key)).text;
+        texts.push_back(data.substr(strings + ref.offset, ref.size));
+    }
+    TIMELIB_CHECK(std::adjacent_find(texts.begin(), texts.end(), std::greater_equal<>()) == texts.end());
+    for (const auto& text : texts) {
+        std::string lowered = text;
+        std::transform(lowered.begin(), lowered.end(), lowered.begin(), timelib::detail::asciiLower);
+        if (lowered != text) timelib::test::fail(__FILE__, __LINE__, "key '" + text + "' isn't lowercased");
+    }
+
+    // a broken header, sections that don't fit, references past their sections and keys out of
+    // order all keep the file from opening
+    const auto at = [](const std::size_t section, const std::size_t width, const std::size_t index, const std::size_t field) {
+        return section + index * width + field;
+    };
+    const struct {
+        std::size_t offset;
+        std::uint32_t value;
+    } broken[] = {
+        {0, 0x58585858},
+        {offsetof(timelib::places::Header, version), timelib::places::kVersion + 1},
+        {offsetof(timelib::places::Header, place_count), 0xffffffff},
+        {offsetof(timelib::places::Header, strings_size), head.strings_size + 1},
+        {at(zones, sizeof(timelib::places::StringRef), 0, offsetof(timelib::places::StringRef, offset)), head.strings_size},
+        {at(places, sizeof(timelib::places::Place), 0, offsetof(timelib::places::Place, zone)), head.zone_count},
+        {at(places, sizeof(timelib::places::Place), head.place_count - 1, offsetof(timelib::places::Place, first_key)), head.place_key_count},
+        {at(places, sizeof(timelib::places::Place), 1, offsetof(timelib::places::Place, name) + offsetof(timelib::places::StringRef, size)),
+         head.strings_size + 1},
+        {at(keys, sizeof(timelib::places::Key), 0, offsetof(timelib::places::Key, first_posting)), head.posting_count},
+        {at(keys, sizeof(timelib::places::Key), head.key_count - 1, offsetof(timelib::places::Key, posting_count)), head.posting_count + 1},
+        {at(postings, sizeof(std::uint32_t), 0, 0), head.place_count},
+        {at(place_keys, sizeof(std::uint32_t), head.place_key_count - 1, 0), head.key_count},
+    };
+    for (const auto& [offset, value] : broken) {
+        writeFile(corrupt, patched(data, offset, value));
+        if (timelib::Gazetteer::open(corrupt)) timelib::test::fail(__FILE__, __LINE__, "opened with " + std::to_string(offset) + " patched");
+    }
+    std::string swapped = data;
+    std::swap_ranges(swapped.begin() + static_cast<std::ptrdiff_t>(keys),
+                     swapped.begin() + static_cast<std::ptrdiff_t>(keys + sizeof(timelib::places::Key)),
+                     swapped.begin() + static_cast<std::ptrdiff_t>(keys + sizeof(timelib::places::Key)));
+    writeFile(corrupt, swapped);
+    TIMELIB_CHECK(timelib::Gazetteer::open(corrupt) == nullptr);
+    writeFile(corrupt, data.substr(0, data.size() - 1));
+    TIMELIB_CHECK(timelib::Gazetteer::open(corrupt) == nullptr);
+    writeFile(corrupt, data.substr(0, sizeof(head) - 1));
+    TIMELIB_CHECK(timelib::Gazetteer::open(corrupt) == nullptr);
+
+    // the resolver asks the gazetteer after the abbreviations, so jerusalem's "ist" doesn't
+    // take india's, and before the fuzzy matcher, so "sidney" isn't read as sydney
+    timelib::ZoneResolver resolver;
+    TIMELIB_CHECK_EQ(resolver.resolve("sidney")->name(), std::string("Australia/Sydney"));
+    resolver.setGazetteer(timelib::Gazetteer::open(path));
+    TIMELIB_CHECK_EQ(resolver.resolve("ist")->name(), std::string("Asia/Kolkata"));
+    TIMELIB_CHECK_EQ(resolver.resolve("sidney")->name(), std::string("America/New_York"));
+    TIMELIB_CHECK_EQ(resolver.resolve("yerushalayim")->name(), std::string("Asia/Jerusalem"));
+    // built-in names still come first
+    TIMELIB_CHECK_EQ(resolver.resolve("paris")->name(), std::string("Europe/Paris"));
+
+    // and through the converter, from the query text down
+    TIMELIB_CHECK_EQ(queryZone("time in winterthur"), std::string("<none>"));
+    TIMELIB_CHECK(!timelib::TimeConverter::loadGazetteer(corrupt));
+    TIMELIB_CHECK(timelib::TimeConverter::loadGazetteer(path));
+    TIMELIB_CHECK_EQ(queryZone("time in winterthur"), std::string("Europe/Zurich"));
+    TIMELIB_CHECK_EQ(queryZone("time in paris, us"), std::string("America/Chicago"));
+    TIMELIB_CHECK_EQ(queryZone("time in sidney"), std::string("America/New_York"));
+    TIMELIB_CHECK_EQ(queryZone("time in sydney"), std::string("Australia/Sydney"));
+    // a file that can't be used leaves the loaded one in place
+    TIMELIB_CHECK(!timelib::TimeConverter::loadGazetteer(corrupt));
+    TIMELIB_CHECK_EQ(queryZone("time in vitudurum"), std::string("Europe/Zurich"));
+
+    std::remove(source.c_str());
+    std::remove(path.c_str());
+    std::remove(corrupt.c_str());
+    rmdir(directory);
+    return timelib::test::result("gazetteer");
+}
@@ -0,0 +1,254 @@
+#include "check.hpp"
+#include "geo_index.hpp"
+#include "time.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+// compiles a few made up boundaries and checks the index against a plain even-odd test over the
+// same rings, then that files with coordinates off the globe are turned away when opened
+
+namespace {
+
+using Ring = std::vector<std::pair<double, double>>;
+
+struct Zone {
+    const char* name;
+    std::vector<Ring> rings;
+};
+
+// star shaped, so most cells on its border have slanted edges running through them
+Ring star(const double lon, const double lat, const double outer, const double inner, const int points) {
+    Ring ring;
+    for (int i = 0; i < 2 * points; ++i) {
+        const double angle = M_PI * i / points;
+        const double r = i % 2 ? inner : outer;
+        ring.push_back({lon + r * std::cos(angle), lat + r * std::sin(angle)});
+    }
+    return ring;
+}
+
+const std::vector<Zone>& zones() {
+    static const std::vector<Zone> zones = {
+        // a square with a square hole
+        {"Europe/London", {{{-10, 45}, {5, 45}, {5, 60}, {-10, 60}}, {{-5, 50}, {0, 50}, {0, 55}, {-5, 55}}}},
+        {"America/New_York", {star(-75, 40, 8, 3, 7)}},
+        // two polygons, one of them across the equator
+        {"Asia/Tokyo", {{{130, -5}, {145, 2}, {138, 12}}, {{140, 30}, {150, 33}, {141, 41}}}},
+    };
+    return zones;
+}
+
+bool inRing(const Ring& ring, const double lon, const double lat) {
+    bool inside = false;
+    for (std::size_t i = 0, j = ring.size() - 1; i < ring.size(); j = i++) {
+        const auto [xi, yi] = ring[i];
+        const auto [xj, yj] = ring[j];
+        if ((yi > lat) != (yj > lat) && lon < (xj - xi) * (lat - yi) / (yj - yi) + xi) inside = !inside;
+    }
+    return inside;
+}
+
+// distance to the nearest edge, points closer than the microdegree rounding aren't compared
+double clearance(const Ring& ring, const double lon, const double lat) {
+    double nearest = 1e9;
+    for (std::size_t i = 0, j = ring.size() - 1; i < ring.size(); j = i++) {
+        const auto [ax, ay] = ring[j];
+        const auto [bx, by] = ring[i];
+        const double t = std::clamp(((lon - ax) * (bx - ax) + (lat - ay) * (by - ay)) / ((bx - ax) * (bx - ax) + (by - ay) * (by - ay)), 0.0, 1.0);
+        nearest = std::min(nearest, std::hypot(lon - (ax + t * (bx - ax)), lat - (ay + t * (by - ay))));
+    }
+    return nearest;
+}
+
+std::string expected(const double lon, const double lat, bool& near_edge) {
+    std::string found;
+    near_edge = false;
+    for (const auto& zone : zones()) {
+        bool inside = false;
+        for (const auto& ring : zone.rings) {
+            inside = inRing(ring, lon, lat) != inside;
+            near_edge = near_edge || clearance(ring, lon, lat) < 1e-5;
+        }
+        if (inside) found = zone.name;
+    }
+    return found;
+}
+
+std::string geojson() {
+    std::ostringstream out;
+    out.precision(17);
+    out << "{\"type\":\"FeatureCollection\",\"features\":[";
+    for (std::size_t z = 0; z < zones().size(); ++z) {
+        out << (z ? "," : "") << "{\"type\":\"Feature\",\"properties\":{\"tzid\":\"" << zones()[z].name
+            << "\"},\"geometry\":{\"type\":\"Polygon\",\"coordinates\":[";
+        for (std::size_t r = 0; r < zones()[z].rings.size(); ++r) {
+            out << (r ? "," : "") << "[";
+            const Ring& ring = zones()[z].rings[r];
+            for (std::size_t i = 0; i <= ring.size(); ++i) {
+                out << (i ? "," : "") << "[" << ring[i % ring.size()].first << "," << ring[i % ring.size()].second << "]";
+            }
+            out << "]";
+        }
+        out << "]}}";
+    }
+    out << "]}";
+    return out.str();
+}
+
+std::string readFile(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    return {std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+}
+
+void writeFile(const std::string& path, const std::string& data) {
+    std::ofstream(path, std::ios::binary | std::ios::trunc).write(data.data(), static_cast<std::streamsize>(data.size()));
+}
+
+std::size_t alignUp(const std::size_t offset) { return (offset + 7) & ~static_cast<std::size_t>(7); }
+
+void lookups(const timelib::GeoIndex& index, const date::tzdb& db) {
+    std::mt19937 rng(20250117);
+    const auto uniform = [&rng](const double low, const double high) { return std::uniform_real_distribution<double>(low, high)(rng); };
+    // the whole globe, and the boxes around the zones where the borders are
+    const double boxes[][4] = {{-180, 180, -90, 90}, {-12, 8, 43, 62}, {-85, -65, 30, 50}, {128, 152, -7, 43}};
+
+    int compared = 0;
+    int inside = 0;
+    for (int i = 0; i < 200000; ++i) {
+        const auto& box = boxes[i % 4];
+        const double x = uniform(box[0], box[1]);
+        const double y = uniform(box[2], box[3]);
+        bool near_edge = false;
+        const std::string want = expected(x, y, near_edge);
+        if (near_edge) continue;
+        ++compared;
+        inside += !want.empty();
+
+        const std::string_view got = index.name(y, x);
+        if (got != want) {
+            std::ostringstream message;
+            message.precision(10);
+            message << "(" << y << ", " << x << ") is in '" << got << "', expected '" << want << "'";
+            timelib::test::fail(__FILE__, __LINE__, message.str());
+        }
+        const date::time_zone* zone = index.lookup(y, x);
+        TIMELIB_CHECK(want.empty() ? zone == nullptr : zone == db.locate_zone(want));
+    }
+    TIMELIB_CHECK(compared > 190000);
+    TIMELIB_CHECK(inside > 20000);
+
+    // a few by hand: the hole, the star's arms and between them, past the antimeridian
+    TIMELIB_CHECK_EQ(std::string(index.name(47, -8)), std::string("Europe/London"));
+    TIMELIB_CHECK_EQ(std::string(index.name(52.5, -2.5)), std::string(""));
+    TIMELIB_CHECK_EQ(std::string(index.name(40, -67.5)), std::string("America/New_York"));
+    TIMELIB_CHECK_EQ(std::string(index.name(46, -71)), std::string(""));
+    TIMELIB_CHECK_EQ(std::string(index.name(35, 143)), std::string("Asia/Tokyo"));
+    TIMELIB_CHECK_EQ(std::string(index.name(35, 143 - 360)), std::string("Asia/Tokyo"));
+    TIMELIB_CHECK(index.lookup(91, 0) == nullptr);
+    TIMELIB_CHECK(index.lookup(0, NAN) == nullptr);
+}
+
+// the file with one number in a section changed
+std::string patched(std::string data, const std::size_t offset, const std::int32_t value) {
+    std::memcpy(&data[offset], &value, sizeof(value));
+    return data;
+}
+
+}
+
+int main() {
+    const date::tzdb& db = date::get_tzdb();
+
+    char directory[] = "/tmp/timelib-geo-test-XXXXXX";
+    if (!mkdtemp(directory)) {
+        std::cerr << "mkdtemp failed" << std::endl;
+        return 1;
+    }
+    const std::string source = std::string(directory) + "/zones.json";
+    const std::string path = std::string(directory) + "/zones.tlgi";
+    const std::string corrupt = std::string(directory) + "/corrupt.tlgi";
+    writeFile(source, geojson());
+
+    for (const std::uint32_t per_degree : {1u, 4u}) {
+        timelib::GeoIndexOptions options;
+        options.cells_per_degree = per_degree;
+        options.tolerance = 0;
+        TIMELIB_CHECK_EQ(timelib::GeoIndex::write(source, path, options), zones().size());
+
+        const auto index = timelib::GeoIndex::open(path, &db);
+        TIMELIB_CHECK(index != nullptr);
+        if (!index) continue;
+        TIMELIB_CHECK(index->tzdb() == &db);
+        TIMELIB_CHECK_EQ(index->cellsPerDegree(), per_degree);
+        lookups(*index, db);
+
+        // without a tzdb the names are still there but nothing resolves, and rebinding finds them again
+        const auto unbound = timelib::GeoIndex::open(path, nullptr);
+        TIMELIB_CHECK(unbound != nullptr);
+        if (!unbound) continue;
+        TIMELIB_CHECK_EQ(std::string(unbound->name(47, -8)), std::string("Europe/London"));
+        TIMELIB_CHECK(unbound->lookup(47, -8) == nullptr);
+        const auto rebound = unbound->rebind(&db);
+        TIMELIB_CHECK(rebound->tzdb() == &db);
+        TIMELIB_CHECK(rebound->lookup(47, -8) == db.locate_zone("Europe/London"));
+    }
+
+    // every point in the entries and edges has to be on the globe
+    const std::string data = readFile(path);
+    timelib::geo::Header head{};
+    std::memcpy(&head, data.data(), sizeof(head));
+    const std::size_t names = alignUp(sizeof(head));
+    const std::size_t cells = alignUp(names + head.zone_count * sizeof(timelib::geo::StringRef));
+    const std::size_t entries = alignUp(cells + std::size_t{360} * 180 * head.cells_per_degree * head.cells_per_degree * sizeof(timelib::geo::Cell));
+    const std::size_t edges = alignUp(entries + head.entry_count * sizeof(timelib::geo::CellEntry));
+    TIMELIB_CHECK(head.entry_count > 0 && head.edge_count > 0);
+
+    const std::size_t last_edge = edges + (head.edge_count - 1) * sizeof(timelib::geo::Edge);
+    const std::size_t last_entry = entries + (head.entry_count - 1) * sizeof(timelib::geo::CellEntry);
+    const struct {
+        std::size_t offset;
+        std::int32_t value;
+    } off_globe[] = {
+        {edges + offsetof(timelib::geo::Edge, x1), 180 * timelib::geo::kScale + 1},
+        {edges + offsetof(timelib::geo::Edge, y2), -90 * timelib::geo::kScale - 1},
+        {last_edge + offsetof(timelib::geo::Edge, x2), std::numeric_limits<std::int32_t>::min()},
+        {last_edge + offsetof(timelib::geo::Edge, y1), std::numeric_limits<std::int32_t>::max()},
+        {entries + offsetof(timelib::geo::CellEntry, ref_x), -180 * timelib::geo::kScale - 1},
+        {last_entry + offsetof(timelib::geo::CellEntry, ref_y), 90 * timelib::geo::kScale + 1},
+    };
+    for (const auto& [offset, value] : off_globe) {
+        writeFile(corrupt, patched(data, offset, value));
+        TIMELIB_CHECK(timelib::GeoIndex::open(corrupt, &db) == nullptr);
+    }
+    // the very edge of the globe is still on it
+    writeFile(corrupt, patched(data, edges + offsetof(timelib::geo::Edge, x1), -180 * timelib::geo::kScale));
+    TIMELIB_CHECK(timelib::GeoIndex::open(corrupt, &db) != nullptr);
+    writeFile(corrupt, data.substr(0, data.size() - 1));
+    TIMELIB_CHECK(timelib::GeoIndex::open(corrupt, &db) == nullptr);
+
+    // and through the converter, against the database it resolves with
+    TIMELIB_CHECK(timelib::TimeConverter::loadGeoIndex(path));
+    TIMELIB_CHECK(timelib::TimeConverter::timezoneAt(47, -8) == db.locate_zone("Europe/London"));
+    TIMELIB_CHECK(timelib::TimeConverter::timezoneAt(0, -30) == nullptr);
+
+    TIMELIB_CHECK_EQ(timelib::GeoIndex::parseCoordinate("51.5074, -0.1278")->longitude, -0.1278);
+    TIMELIB_CHECK(!timelib::GeoIndex::parseCoordinate("91 0"));
+
+    std::remove(source.c_str());
+    std::remove(path.c_str());
+    std::remove(corrupt.c_str());
+    rmdir(directory);
+    return timelib::test::result("geo_index");
+}
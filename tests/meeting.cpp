@@ -0,0 +1,162 @@
+#include "check.hpp"
+#include "meeting.hpp"
+#include "resolver.hpp"
+#include "time.hpp"
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+// MeetingPlanner against a minute by minute walk: a minute is free when every participant's own
+// wall clock reads inside their hours on one of their working days. then meeting queries, whose
+// days are the first location's
+
+namespace {
+
+constexpr const char* kZones[] = {"Europe/London",  "America/New_York", "Asia/Tokyo",       "Australia/Sydney", "Asia/Kolkata",
+                                  "Asia/Kathmandu", "America/St_Johns", "Pacific/Auckland", "America/Santiago", "Europe/Berlin"};
+
+struct Walker {
+    const date::time_zone* zone;
+    timelib::WorkingHours hours;
+    date::sys_info info{};
+
+    bool working(const date::sys_seconds t) {
+        if (t < info.begin || t >= info.end) info = zone->get_info(t);
+        const date::local_seconds local{t.time_since_epoch() + info.offset};
+        const auto day = date::floor<date::days>(local);
+        const auto minute = std::chrono::duration_cast<std::chrono::minutes>(local - day);
+        const auto works = [this](const date::local_days d) {
+            return ((hours.weekdays >> date::weekday{d}.c_encoding()) & 1) != 0;
+        };
+
+        if (hours.end > hours.start) return works(day) && minute >= hours.start && minute < hours.end;
+        // past midnight, the early hours belong to the day before
+        return (works(day) && minute >= hours.start) || (works(day - date::days{1}) && minute < hours.end);
+    }
+};
+
+// the days a query's span covers, from the first location's midnight to its midnight
+std::pair<date::sys_seconds, date::sys_seconds> spanOf(const date::time_zone* zone, const timelib::MeetingSpan span, const date::sys_seconds now) {
+    const auto today = date::floor<date::days>(zone->to_local(now));
+    const date::local_days monday = today + (date::Monday - date::weekday{today}) + (date::weekday{today} == date::Monday ? date::days{7} : date::days{0});
+    date::local_days first = today;
+    date::local_days last = today + date::days{7};
+    if (span == timelib::MeetingSpan::Today) last = today + date::days{1};
+    if (span == timelib::MeetingSpan::Tomorrow) first = today + date::days{1}, last = today + date::days{2};
+    if (span == timelib::MeetingSpan::ThisWeek) last = monday;
+    if (span == timelib::MeetingSpan::NextWeek) first = monday, last = monday + date::days{7};
+    return {zone->to_sys(first, date::choose::earliest), zone->to_sys(last, date::choose::earliest)};
+}
+
+bool same(const std::vector<timelib::TimeInterval>& a, const std::vector<timelib::TimeInterval>& b) {
+    return std::equal(a.begin(), a.end(), b.begin(), b.end(), [](const timelib::TimeInterval& x, const timelib::TimeInterval& y) {
+        return x.begin == y.begin && x.end == y.end;
+    });
+}
+
+bool inside(const std::vector<timelib::TimeInterval>& windows, const date::sys_seconds t) {
+    for (const auto& window : windows) {
+        if (t >= window.begin && t < window.end) return true;
+    }
+    return false;
+}
+
+}
+
+int main() {
+    const timelib::ZoneResolver resolver;
+    std::mt19937 rng(20241103);
+    const auto pick = [&rng](const int low, const int high) { return std::uniform_int_distribution<int>(low, high)(rng); };
+
+    for (int trial = 0; trial < 120; ++trial) {
+        std::vector<timelib::WorkingHours> participants;
+        for (int count = pick(1, 4); count > 0; --count) {
+            timelib::WorkingHours hours;
+            hours.location = kZones[pick(0, 9)];
+            // mostly office hours, some overnight shifts and some around the clock
+            const int kind = pick(0, 5);
+            hours.start = std::chrono::minutes{kind == 0 ? pick(18, 23) * 60 : kind == 1 ? 0 : pick(6 * 4, 11 * 4) * 15};
+            hours.end = std::chrono::minutes{kind == 0 ? pick(2, 8) * 60 : kind == 1 ? 0 : hours.start.count() + pick(4 * 4, 10 * 4) * 15};
+            hours.weekdays = static_cast<std::uint8_t>(pick(0, 3) ? 0b0111110 : pick(1, 127));
+            participants.push_back(hours);
+            // a second person in the same office doesn't change anything
+            if (pick(0, 4) == 0) participants.push_back(hours);
+        }
+
+        // around the spring and autumn changes of one year or another
+        const int year = pick(2000, 2040);
+        const date::sys_days day = date::year_month_day{date::year{year}, date::month{static_cast<unsigned>(pick(0, 1) ? 3 : 10)},
+                                                        date::day{static_cast<unsigned>(pick(1, 28))}};
+        const date::sys_seconds begin = day + std::chrono::minutes{pick(0, 24 * 4) * 15};
+        const date::sys_seconds end = begin + std::chrono::hours{pick(1, 14 * 24)};
+
+        const auto found = timelib::MeetingPlanner::find(resolver, participants, begin, end);
+        TIMELIB_CHECK(found.missing.empty());
+        for (std::size_t i = 1; i < found.windows.size(); ++i) TIMELIB_CHECK(found.windows[i - 1].end <= found.windows[i].begin);
+
+        std::vector<Walker> walkers;
+        for (const auto& participant : participants) walkers.push_back({resolver.resolve(participant.location), participant});
+
+        int wrong = 0;
+        for (auto t = begin; t < end; t += std::chrono::minutes{1}) {
+            bool everyone = true;
+            for (auto& walker : walkers) everyone = walker.working(t) && everyone;
+            if (everyone != inside(found.windows, t) && wrong++ == 0) {
+                timelib::test::fail(__FILE__, __LINE__, "trial " + std::to_string(trial) + " differs at " + std::to_string(t.time_since_epoch().count()));
+            }
+        }
+
+        // min_length drops the short windows and nothing else
+        const auto long_only = timelib::MeetingPlanner::find(resolver, participants, begin, end, std::chrono::minutes{90});
+        std::size_t expected = 0;
+        for (const auto& window : found.windows) expected += window.length() >= std::chrono::minutes{90};
+        TIMELIB_CHECK_EQ(long_only.windows.size(), expected);
+    }
+
+    // one unknown place and nothing is searched
+    const date::sys_days monday = date::year_month_day{date::year{2024}, date::month{6}, date::day{3}};
+    const auto missing = timelib::MeetingPlanner::find(resolver, {{"Europe/London"}, {"qzxqzx"}}, monday, monday + date::days{7});
+    TIMELIB_CHECK_EQ(missing.missing.size(), std::size_t{1});
+    TIMELIB_CHECK(missing.windows.empty());
+
+    // tokyo's tuesday starts at 15:00 utc on monday, and its office hours overlap sydney's from
+    // midnight utc. a utc "today" would be monday and find monday's overlap instead
+    const date::sys_seconds late_monday = monday + std::chrono::hours{22};
+    const timelib::TimeConverter converter;
+    const auto tokyo_today = timelib::TimeConverter::evaluate(converter.parseInput("meeting times in tokyo and sydney today"), late_monday);
+    TIMELIB_CHECK(tokyo_today.ok());
+    TIMELIB_CHECK(tokyo_today.time == monday + std::chrono::hours{15});
+    TIMELIB_CHECK_EQ(tokyo_today.windows.size(), std::size_t{1});
+    if (tokyo_today.windows.size() == 1) {
+        TIMELIB_CHECK(tokyo_today.windows[0].begin == monday + date::days{1});
+        TIMELIB_CHECK(tokyo_today.windows[0].end == monday + date::days{1} + std::chrono::hours{7});
+    }
+
+    // every span, first locations on both sides of greenwich, at any time of day
+    const char* queries[] = {"meeting times in tokyo and sydney", "meeting times in auckland, london and new york",
+                             "meeting times in los angeles and sydney", "meeting times in london and kolkata"};
+    const char* spans[] = {" today", " tomorrow", "", " this week", " next week"};
+    for (int trial = 0; trial < 60; ++trial) {
+        const std::string text = std::string(queries[pick(0, 3)]) + spans[pick(0, 4)];
+        const timelib::ParsedQuery query = converter.parseInput(text);
+        TIMELIB_CHECK(query.is_valid && query.type == timelib::QueryType::Meeting);
+        const date::sys_seconds now = date::sys_days{date::year_month_day{date::year{2024}, date::month{static_cast<unsigned>(pick(1, 12))},
+                                                                          date::day{static_cast<unsigned>(pick(1, 28))}}} +
+                                      std::chrono::minutes{pick(0, 24 * 60 - 1)};
+
+        const auto [begin, end] = spanOf(resolver.resolve(query.location_a), query.span, now);
+        std::vector<timelib::WorkingHours> participants;
+        for (const auto& location : query.locations) {
+            participants.push_back({location, std::chrono::minutes{query.hour * 60 + query.minute},
+                                    std::chrono::minutes{query.end_hour * 60 + query.end_minute}});
+        }
+        const auto result = timelib::TimeConverter::evaluate(query, now);
+        TIMELIB_CHECK(result.ok());
+        if (result.time != begin || !same(result.windows, timelib::MeetingPlanner::find(resolver, participants, begin, end).windows)) {
+            timelib::test::fail(__FILE__, __LINE__, "'" + text + "' at " + std::to_string(now.time_since_epoch().count()) + " differs");
+        }
+    }
+
+    return timelib::test::result("meeting");
+}
@@ -0,0 +1,155 @@
+#include "check.hpp"
+#include "offset_matrix.hpp"
+#include "resolver.hpp"
+#include <algorithm>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+// OffsetMatrix against the date library's own intervals: every zone's offset is walked interval
+// by interval over the range, the instants where some zone's offset moves are collected, and the
+// matrix, its changes and the pairwise change lists are compared with what that walk gives
+
+namespace {
+
+constexpr const char* kLocations[] = {"london", "new york", "sydney", "santiago"};
+
+struct Step {
+    std::int64_t at;
+    std::int64_t offset;
+};
+
+// the zone's offset at begin and every change of it in (begin, end). splits where only the
+// abbreviation or the dst flag changes aren't changes
+std::vector<Step> walk(const date::time_zone* zone, const date::sys_seconds begin, const date::sys_seconds end) {
+    date::sys_info info = zone->get_info(begin);
+    std::vector<Step> steps{{begin.time_since_epoch().count(), info.offset.count()}};
+    while (info.end < end) {
+        info = zone->get_info(info.end);
+        if (info.offset.count() != steps.back().offset) steps.push_back({info.begin.time_since_epoch().count(), info.offset.count()});
+    }
+    return steps;
+}
+
+std::int64_t offsetAt(const std::vector<Step>& steps, const std::int64_t t) {
+    std::int64_t offset = steps.front().offset;
+    for (const auto& step : steps) {
+        if (step.at <= t) offset = step.offset;
+    }
+    return offset;
+}
+
+void compare(const timelib::OffsetMatrix& matrix, const date::sys_seconds begin, const date::sys_seconds end, std::mt19937& rng) {
+    const std::string where = std::to_string(begin.time_since_epoch().count()) + ".." + std::to_string(end.time_since_epoch().count());
+    const std::size_t n = matrix.size();
+    const std::int64_t first = begin.time_since_epoch().count();
+    const std::int64_t last = std::max(end, begin + std::chrono::seconds{1}).time_since_epoch().count() - 1;
+
+    std::vector<std::vector<Step>> steps;
+    std::vector<std::int64_t> instants;
+    for (const auto* zone : matrix.zones()) {
+        steps.push_back(walk(zone, begin, std::max(end, begin + std::chrono::seconds{1})));
+        for (std::size_t i = 1; i < steps.back().size(); ++i) instants.push_back(steps.back()[i].at);
+    }
+    std::sort(instants.begin(), instants.end());
+    instants.erase(std::unique(instants.begin(), instants.end()), instants.end());
+
+    // changes(): every instant some zone moves at, unless they all moved by the same amount
+    std::vector<timelib::DifferenceChange> expected;
+    for (const std::int64_t t : instants) {
+        timelib::DifferenceChange change{date::sys_seconds{std::chrono::seconds{t}}, {}};
+        std::vector<std::int64_t> moved(n);
+        for (std::size_t z = 0; z < n; ++z) {
+            moved[z] = offsetAt(steps[z], t) - offsetAt(steps[z], t - 1);
+            if (moved[z] != 0) change.shifts.push_back({z, std::chrono::seconds{moved[z]}});
+        }
+        if (std::adjacent_find(moved.begin(), moved.end(), std::not_equal_to<>()) != moved.end()) expected.push_back(change);
+    }
+    TIMELIB_CHECK_EQ(matrix.changes().size(), expected.size());
+    for (std::size_t i = 0; i < std::min(expected.size(), matrix.changes().size()); ++i) {
+        const auto& got = matrix.changes()[i];
+        if (got.at != expected[i].at || got.shifts != expected[i].shifts) {
+            timelib::test::fail(__FILE__, __LINE__, where + ": change " + std::to_string(i) + " differs");
+            break;
+        }
+    }
+
+    // changesBetween: the instants where the pair moved by different amounts
+    for (std::size_t a = 0; a < n; ++a) {
+        for (std::size_t b = 0; b < n; ++b) {
+            std::vector<date::sys_seconds> pair;
+            for (const std::int64_t t : instants) {
+                if (offsetAt(steps[a], t) - offsetAt(steps[a], t - 1) != offsetAt(steps[b], t) - offsetAt(steps[b], t - 1)) {
+                    pair.push_back(date::sys_seconds{std::chrono::seconds{t}});
+                }
+            }
+            if (matrix.changesBetween(a, b) != pair) {
+                timelib::test::fail(__FILE__, __LINE__, where + ": changes between " + std::to_string(a) + " and " + std::to_string(b) + " differ");
+            }
+        }
+    }
+
+    // matrixAt around every change, at the ends of the range, outside it (clamped) and anywhere
+    std::vector<std::int64_t> probes = {first, last, first - 86400 * 40, last + 86400 * 40};
+    for (const std::int64_t t : instants) probes.insert(probes.end(), {t - 1, t, t + 1});
+    for (int i = 0; i < 200; ++i) probes.push_back(std::uniform_int_distribution<std::int64_t>(first, last)(rng));
+
+    std::vector<std::chrono::seconds> out;
+    for (const std::int64_t probe : probes) {
+        const std::int64_t t = std::clamp(probe, first, last);
+        const date::sys_seconds tp{std::chrono::seconds{probe}};
+        matrix.matrixAt(tp, out);
+        TIMELIB_CHECK_EQ(out.size(), n * n);
+        if (out.size() != n * n) return;
+        for (std::size_t a = 0; a < n; ++a) {
+            TIMELIB_CHECK_EQ(matrix.offset(a, tp).count(), offsetAt(steps[a], t));
+            for (std::size_t b = 0; b < n; ++b) {
+                const std::int64_t want = offsetAt(steps[a], t) - offsetAt(steps[b], t);
+                if (out[a * n + b].count() != want || matrix.difference(a, b, tp).count() != want) {
+                    timelib::test::fail(__FILE__, __LINE__, where + ": difference at " + std::to_string(probe) + " differs");
+                    return;
+                }
+            }
+        }
+    }
+}
+
+date::sys_seconds yearStart(const int year) {
+    return date::sys_days{date::year_month_day{date::year{year}, date::month{1}, date::day{1}}};
+}
+
+}
+
+int main() {
+    const timelib::ZoneResolver resolver;
+    std::mt19937 rng(20240915);
+    const std::vector<std::string> locations(std::begin(kLocations), std::end(kLocations));
+
+    // a few whole years, with both hemispheres' changes and santiago's moving rules
+    const timelib::OffsetMatrix years(resolver, locations, yearStart(2014), yearStart(2025));
+    TIMELIB_CHECK_EQ(years.size(), std::size_t{4});
+    TIMELIB_CHECK(years.missing().empty());
+    TIMELIB_CHECK(years.changes().size() >= 4 * 11);
+    compare(years, yearStart(2014), yearStart(2025), rng);
+
+    // windows of any length starting anywhere, some of them right on a change
+    for (int trial = 0; trial < 40; ++trial) {
+        date::sys_seconds begin = yearStart(std::uniform_int_distribution<int>(1990, 2035)(rng)) +
+                                  std::chrono::seconds{std::uniform_int_distribution<std::int64_t>(0, 365LL * 86400)(rng)};
+        if (trial % 4 == 0 && !years.changes().empty()) {
+            begin = years.changes()[std::uniform_int_distribution<std::size_t>(0, years.changes().size() - 1)(rng)].at;
+        }
+        const date::sys_seconds end = begin + std::chrono::hours{std::uniform_int_distribution<int>(0, 3 * 365 * 24)(rng)};
+        compare(timelib::OffsetMatrix(resolver, locations, begin, end), begin, end, rng);
+    }
+
+    // unknown names are left out, the rest keep their order
+    const timelib::OffsetMatrix partial(resolver, {"sydney", "qzxqzx", "london"}, yearStart(2024), yearStart(2025));
+    TIMELIB_CHECK_EQ(partial.size(), std::size_t{2});
+    TIMELIB_CHECK(partial.missing() == std::vector<std::string>({"qzxqzx"}));
+    TIMELIB_CHECK(partial.zones()[0] == resolver.resolve("sydney"));
+    compare(partial, yearStart(2024), yearStart(2025), rng);
+
+    return timelib::test::result("offset_matrix");
+}
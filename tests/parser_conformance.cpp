@@ -0,0 +1,234 @@
+#include "check.hpp"
+#include "parser.hpp"
+#include <algorithm>
+#include <iterator>
+#include <optional>
+#include <random>
+#include <regex>
+#include <string>
+#include <vector>
+
+// QueryParser against the regex cascade it replaced. the reference below is the old
+// TimeConverter::parseInput, kept as it was apart from being made free functions.
+
+namespace {
+
+using timelib::ParsedQuery;
+using timelib::QueryType;
+
+namespace reference {
+
+bool isValidTime(const int hour, const int minute) {
+    return hour >= 0 && hour < 24 && minute >= 0 && minute < 60;
+}
+
+std::optional<int> parseHour(const std::string& hour_str) {
+    try {
+        int hour = std::stoi(hour_str);
+        return (hour >= 0 && hour <= 24) ? std::optional<int>(hour) : std::nullopt;
+    } catch (...) { return std::nullopt; }
+}
+
+std::optional<int> parseMinute(const std::string& minute_str) {
+    try {
+        int minute = std::stoi(minute_str);
+        return (minute >= 0 && minute <= 59) ? std::optional<int>(minute) : std::nullopt;
+    } catch (...) { return std::nullopt; }
+}
+
+std::string normalizeLocation(const std::string& location) {
+    std::string normalized = location;
+    normalized.erase(0, normalized.find_first_not_of(" \t\n\r\f\v"));
+    normalized.erase(normalized.find_last_not_of(" \t\n\r\f\v") + 1);
+    std::transform(normalized.begin(), normalized.end(), normalized.begin(), ::tolower);
+    return normalized;
+}
+
+void parseTimeString(const std::string& time_str, ParsedQuery& result) {
+    std::string lower_time = time_str;
+    std::transform(lower_time.begin(), lower_time.end(), lower_time.begin(), ::tolower);
+
+    if (lower_time == "noon") { result.hour = 12; result.minute = 0; return; }
+    if (lower_time == "midnight") { result.hour = 0; result.minute = 0; return; }
+
+    const std::regex time_pattern(R"((\d{1,2})(?::(\d{2}))?\s*(am|pm)?)", std::regex_constants::icase);
+    if (std::smatch time_match; std::regex_search(lower_time, time_match, time_pattern)) {
+        const auto hour_opt = parseHour(time_match[1].str());
+        if (!hour_opt) return;
+
+        result.hour = *hour_opt;
+        result.minute = time_match[2].matched ? parseMinute(time_match[2].str()).value_or(0) : 0;
+
+        if (time_match[3].matched) {
+            if (const std::string ampm = time_match[3].str(); ampm == "pm" && result.hour != 12) result.hour += 12;
+            else if (ampm == "am" && result.hour == 12) result.hour = 0;
+        }
+    } else {
+        result.hour = -1;
+    }
+}
+
+ParsedQuery parseInput(const std::string& input) {
+    static const std::regex conversion_pattern(
+        R"(^(?:convert|change|switch|make|what is|whats)\s+(.+?)\s+(?:from|frm|in|at)\s+(.+?)\s+(?:to|2|in|as)\s+(.+?)\s*$)",
+        std::regex_constants::icase);
+    static const std::regex implicit_conversion_pattern(
+        R"(^(.+?)\s+(?:in|at)\s+(.+?)\s+(?:to|as|in)\s+(.+?)\s*$)",
+        std::regex_constants::icase);
+    static const std::regex query_pattern(
+        R"(^(?:what is|what's|whats|wats|tell me|show me)?\s*(?:the)?\s*(?:current|local)?\s*(time|now|.+?)\s+(?:in|at|for|of)\s+(.+?)\s*$)",
+        std::regex_constants::icase);
+    static const std::regex difference_pattern(
+        R"(^(?:what's|whats|wats|what is)?\s*(?:the)?\s*time(?:s)?\s*(?:difference|diff|offset)\s*(?:between|b/w|from)\s+(.+?)\s*(?:and|&|to|2)\s+(.+?)\s*$)",
+        std::regex_constants::icase);
+
+    ParsedQuery query;
+    std::smatch match;
+    std::string cleaned_input = std::regex_replace(input, std::regex(R"(^\s+|\s+$)"), "");
+
+    if (std::regex_match(cleaned_input, match, difference_pattern)) {
+        query.type = QueryType::Difference;
+        query.location_a = normalizeLocation(match[1].str());
+        query.location_b = normalizeLocation(match[2].str());
+        query.is_valid = true;
+        return query;
+    }
+
+    if (std::regex_match(cleaned_input, match, conversion_pattern)) {
+        query.type = QueryType::Conversion;
+        parseTimeString(match[1].str(), query);
+        query.location_a = normalizeLocation(match[2].str());
+        query.location_b = normalizeLocation(match[3].str());
+        query.is_valid = isValidTime(query.hour, query.minute);
+        return query;
+    }
+
+    if (std::regex_match(cleaned_input, match, implicit_conversion_pattern)) {
+        parseTimeString(match[1].str(), query);
+        if (isValidTime(query.hour, query.minute)) {
+            query.type = QueryType::Conversion;
+            query.location_a = normalizeLocation(match[2].str());
+            query.location_b = normalizeLocation(match[3].str());
+            query.is_valid = true;
+            return query;
+        }
+        query = ParsedQuery();
+    }
+
+    if (std::regex_match(cleaned_input, match, query_pattern)) {
+        std::string time_keyword = match[1].str();
+        std::string lower_time_keyword = time_keyword;
+        std::transform(lower_time_keyword.begin(), lower_time_keyword.end(), lower_time_keyword.begin(), ::tolower);
+
+        if (lower_time_keyword == "time" || lower_time_keyword == "now") {
+            query.type = QueryType::CurrentTime;
+            query.location_a = normalizeLocation(match[2].str());
+            query.is_valid = true;
+        } else {
+            query.type = QueryType::Conversion;
+            parseTimeString(time_keyword, query);
+            query.location_b = normalizeLocation(match[2].str());
+            try {
+                query.location_a = date::current_zone()->name();
+            } catch (const std::exception&) {
+                query.is_valid = false;
+                return query;
+            }
+            query.is_valid = isValidTime(query.hour, query.minute);
+        }
+        return query;
+    }
+
+    query.is_valid = false;
+    return query;
+}
+
+}
+
+std::string describe(const ParsedQuery& query) {
+    return std::to_string(static_cast<int>(query.type)) + " " + std::to_string(query.hour) + ":" +
+           std::to_string(query.minute) + " [" + query.location_a + "] [" +
+           (query.location_b ? *query.location_b : "<none>") + "] " + (query.is_valid ? "valid" : "invalid");
+}
+
+void compare(const std::string& input) {
+    const std::string expected = describe(reference::parseInput(input));
+    const std::string actual = describe(timelib::QueryParser::parse(input));
+    if (actual != expected) timelib::test::fail(__FILE__, __LINE__, "\"" + input + "\": " + actual + ", regex gave " + expected);
+}
+
+// phrasings the launcher sees, and the odd ones the regexes had opinions about
+const char* const kPhrasings[] = {
+    "what is the time in london", "what's the time in tokyo", "whats the current time in nyc",
+    "wats the time in sydney", "tell me the time in paris", "show me the local time in berlin", "time in delhi",
+    "now in la", "current time in new york", "local time in san francisco", "the time in Rio", "TIME IN LONDON",
+    "  time in london  ", "time   in   new   york", "what time is it in tokyo", "5pm in tokyo", "5 pm in tokyo",
+    "9:30pm in delhi", "noon in berlin", "midnight in nyc", "12am in london", "12pm in london", "24 in london",
+    "25pm in london", "13pm in london", "5:75pm in london", "7:5pm in london", "123 in paris",
+    "convert 9:30pm in delhi to nyc", "convert 5pm from london to paris", "change 10am at nyc to tokyo",
+    "switch 3:15 pm frm berlin 2 sydney", "make noon in tokyo as london", "what is 5pm in london to paris",
+    "whats 8am in seattle in dubai", "convert blah in x to y", "convert 5pm in x in y in z", "5pm in nyc to london",
+    "5pm at nyc as london", "11:45am in new york to los angeles", "midnight in tokyo in london", "hello in x to y",
+    "what is the time difference between tokyo and la", "time difference between tokyo and la",
+    "time diff between nyc & london", "whats the time offset from berlin to tokyo",
+    "what's time difference b/w delhi 2 sydney", "times difference between a and b and c",
+    "time difference between 2 and 3", "what is the time diff between new york and los angeles",
+    "the time difference between x and y", "time for berlin", "time of day in x", "the in x", "what is in x",
+    "current local time in x", "tell me 5pm in x", "show me noon at y", "time", "in", "hello world", "5pm", "5pm in",
+    "convert 5pm in london to", "nowhere in x", "the 5pm in x", "at at at at", "in in in in in",
+    "what is the time in america/new_york", "time in Asia/Kolkata", "time in new\tyork", "wats now for oslo",
+    "what is the current time in kyiv", "", "   ",
+};
+
+// every keyword of every pattern, a few times and a few places. none of them ends in a join
+// word, which is where the regexes split words apart (see the toronto check below)
+const char* const kSoupWords[] = {
+    "what", "is", "what's", "whats", "wats", "tell", "me", "show", "the", "current", "local", "time", "times", "now",
+    "in", "at", "for", "of", "difference", "diff", "offset", "between", "b/w", "from", "frm", "and", "&", "to", "2",
+    "as", "convert", "change", "switch", "make", "5pm", "9:30", "noon", "12am", "london", "new", "york", "nyc",
+};
+
+}
+
+int main() {
+    for (const char* input : kPhrasings) compare(input);
+
+    // keyword soups, seeded so a failure can be reproduced
+    std::mt19937 rng(20240517);
+    constexpr std::size_t kWords = std::size(kSoupWords);
+    for (int i = 0; i < 4000; ++i) {
+        std::string input;
+        const std::size_t length = 1 + rng() % 9;
+        for (std::size_t w = 0; w < length; ++w) {
+            if (w) input += ' ';
+            input += kSoupWords[rng() % kWords];
+        }
+        compare(input);
+    }
+
+    // keywords are whole words now. the regexes let a separator match inside a word
+    {
+        const auto query = timelib::QueryParser::parse("time difference between toronto and london");
+        TIMELIB_CHECK(query.is_valid);
+        TIMELIB_CHECK_EQ(query.location_a, std::string("toronto"));
+        TIMELIB_CHECK_EQ(query.location_b.value_or(""), std::string("london"));
+
+        // and keywords glued together ("whatsthe") matched too
+        TIMELIB_CHECK(!timelib::QueryParser::parse("whatsthe time in london").is_valid);
+    }
+
+    // up to kMaxTokens words are parsed, anything longer is rejected outright
+    {
+        std::string longest = "time in";
+        for (std::size_t i = 2; i < timelib::QueryLexer::kMaxTokens; ++i) longest += " x";
+        const auto query = timelib::QueryParser::parse(longest);
+        TIMELIB_CHECK(query.is_valid);
+        TIMELIB_CHECK(query.type == QueryType::CurrentTime);
+
+        const auto rejected = timelib::QueryParser::parse(longest + " x");
+        TIMELIB_CHECK(!rejected.is_valid);
+        TIMELIB_CHECK(rejected.type == QueryType::Invalid);
+    }
+
+    return timelib::test::result("parser_conformance");
+}
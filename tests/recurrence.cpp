@@ -0,0 +1,196 @@
+#include "check.hpp"
+#include "recurrence.hpp"
+#include "time.hpp"
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+// Recurrence against a brute force expansion: every day from the start is tested against the
+// rule's definition, and each wall time is placed by looking at every offset interval around it
+
+namespace {
+
+constexpr const char* kZones[] = {"America/New_York", "Europe/London",    "Australia/Sydney", "Australia/Lord_Howe",
+                                  "America/St_Johns", "Asia/Kathmandu",   "Pacific/Chatham",  "America/Santiago"};
+
+constexpr std::int64_t kDay = 86400;
+
+// the zone's intervals, fetched as the walk needs them
+struct Intervals {
+    const date::time_zone* zone;
+    std::vector<date::sys_info> known;
+
+    const date::sys_info& at(const std::int64_t t) {
+        for (const auto& info : known) {
+            if (t >= info.begin.time_since_epoch().count() && t < info.end.time_since_epoch().count()) return info;
+        }
+        known.push_back(zone->get_info(date::sys_seconds{std::chrono::seconds{t}}));
+        return known.back();
+    }
+};
+
+// the instants a wall time maps to under the rule's policies, none when it's skipped
+std::vector<std::int64_t> place(Intervals& intervals, const std::int64_t local, const timelib::RecurrenceRule& rule) {
+    // every interval within a day of the wall time, in order
+    std::vector<date::sys_info> around;
+    for (std::int64_t t = local - 2 * kDay; t < local + 2 * kDay;) {
+        const date::sys_info info = intervals.at(t);
+        around.push_back(info);
+        t = info.end.time_since_epoch().count();
+    }
+
+    std::vector<std::int64_t> valid;
+    for (const auto& info : around) {
+        const std::int64_t t = local - info.offset.count();
+        if (t >= info.begin.time_since_epoch().count() && t < info.end.time_since_epoch().count()) valid.push_back(t);
+    }
+    if (valid.size() == 2) return {rule.overlap == timelib::OverlapPolicy::Earliest ? valid.front() : valid.back()};
+    if (valid.size() == 1) return valid;
+
+    // in a gap: the interval before it is the one whose end the wall time is past
+    for (std::size_t i = 0; i + 1 < around.size(); ++i) {
+        const std::int64_t end = around[i].end.time_since_epoch().count();
+        if (local - around[i].offset.count() < end || local - around[i + 1].offset.count() >= end) continue;
+        switch (rule.gap) {
+            case timelib::GapPolicy::ShiftForward: return {local - around[i].offset.count()};
+            case timelib::GapPolicy::Transition: return {end};
+            case timelib::GapPolicy::Skip: return {};
+        }
+    }
+    timelib::test::fail(__FILE__, __LINE__, "no interval for " + std::to_string(local));
+    return {};
+}
+
+bool onWeekday(const std::uint8_t weekdays, const date::local_days day) {
+    return ((weekdays >> date::weekday{day}.c_encoding()) & 1) != 0;
+}
+
+bool matches(const timelib::RecurrenceRule& rule, const date::local_days start, const date::local_days day) {
+    const auto interval = static_cast<std::int64_t>(std::max<std::uint32_t>(rule.interval, 1));
+    switch (rule.frequency) {
+        case timelib::Frequency::Daily:
+            return (day - start).count() % interval == 0 && (rule.weekdays == 0 || onWeekday(rule.weekdays, day));
+        case timelib::Frequency::Weekly: {
+            const date::local_days monday = start - (date::weekday{start} - date::Monday);
+            const std::uint8_t weekdays = rule.weekdays ? rule.weekdays : static_cast<std::uint8_t>(1u << date::weekday{start}.c_encoding());
+            return (day - monday).count() / 7 % interval == 0 && onWeekday(weekdays, day);
+        }
+        case timelib::Frequency::Monthly: {
+            const date::year_month_day first{start};
+            const date::year_month_day ymd{day};
+            const int months = (static_cast<int>(ymd.year()) - static_cast<int>(first.year())) * 12 +
+                               static_cast<int>(static_cast<unsigned>(ymd.month())) - static_cast<int>(static_cast<unsigned>(first.month()));
+            if (months % interval != 0) return false;
+
+            const int dom = static_cast<int>(static_cast<unsigned>(ymd.day()));
+            const int last = static_cast<int>(static_cast<unsigned>(date::year_month_day_last{ymd.year(), date::month_day_last{ymd.month()}}.day()));
+            if (rule.weekdays == 0) {
+                const int wanted = rule.month_day == 0 ? static_cast<int>(static_cast<unsigned>(first.day())) : rule.month_day;
+                return dom == (wanted > 0 ? wanted : last + 1 + wanted);
+            }
+            if (!onWeekday(rule.weekdays, day)) return false;
+            if (rule.ordinal > 0) return (dom - 1) / 7 + 1 == rule.ordinal;
+            if (rule.ordinal < 0) return (last - dom) / 7 + 1 == -rule.ordinal;
+            return true;
+        }
+    }
+    return false;
+}
+
+std::vector<date::sys_seconds> reference(const date::time_zone* zone, const date::local_days start, const timelib::RecurrenceRule& rule,
+                                         const date::local_days last_day) {
+    Intervals intervals{zone, {}};
+    std::vector<date::sys_seconds> occurrences;
+    for (date::local_days day = start; day <= last_day; day += date::days{1}) {
+        if (!matches(rule, start, day)) continue;
+        const std::int64_t local = date::local_seconds{day}.time_since_epoch().count() + rule.time.count() * 60;
+        for (const std::int64_t t : place(intervals, local, rule)) {
+            const date::sys_seconds instant{std::chrono::seconds{t}};
+            if (rule.until && instant > *rule.until) return occurrences;
+            occurrences.push_back(instant);
+            if (rule.count != 0 && occurrences.size() == rule.count) return occurrences;
+        }
+    }
+    return occurrences;
+}
+
+std::vector<date::sys_seconds> slice(const std::vector<date::sys_seconds>& all, const date::sys_seconds from, const date::sys_seconds to) {
+    std::vector<date::sys_seconds> in;
+    for (const auto t : all) {
+        if (t >= from && t < to) in.push_back(t);
+    }
+    return in;
+}
+
+}
+
+int main() {
+    std::mt19937 rng(20250301);
+    const auto pick = [&rng](const int low, const int high) { return std::uniform_int_distribution<int>(low, high)(rng); };
+
+    for (int trial = 0; trial < 150; ++trial) {
+        const date::time_zone* zone = date::locate_zone(kZones[pick(0, 7)]);
+
+        timelib::RecurrenceRule rule;
+        rule.frequency = static_cast<timelib::Frequency>(pick(0, 2));
+        rule.interval = static_cast<std::uint32_t>(pick(0, 3) ? pick(1, 3) : pick(0, 14));
+        // mostly around the small hours, where the gaps and overlaps are
+        rule.time = std::chrono::minutes{pick(0, 2) ? pick(0, 4 * 4) * 15 : pick(0, 24 * 60 - 1)};
+        rule.weekdays = static_cast<std::uint8_t>(pick(0, 2) ? 0 : pick(1, 127));
+        rule.month_day = pick(0, 3) ? pick(-3, 31) : 0;
+        rule.ordinal = pick(-5, 5);
+        if (pick(0, 3) == 0) rule.count = static_cast<std::size_t>(pick(1, 60));
+        rule.gap = static_cast<timelib::GapPolicy>(pick(0, 2));
+        rule.overlap = static_cast<timelib::OverlapPolicy>(pick(0, 1));
+
+        // the compiled table covers 1970 on, the years before go through the date library
+        const date::local_days start{date::year_month_day{date::year{pick(1962, 2050)}, date::month{static_cast<unsigned>(pick(1, 12))},
+                                                          date::day{static_cast<unsigned>(pick(1, 28))}}};
+        const date::local_days last_day = start + date::days{pick(2, 12) * 365};
+        const date::sys_seconds horizon{date::local_seconds{last_day}.time_since_epoch() - std::chrono::hours{26}};
+        if (pick(0, 4) == 0) rule.until = date::sys_seconds{date::local_seconds{start}.time_since_epoch()} + std::chrono::hours{pick(24, 24 * 900)};
+
+        const timelib::Recurrence recurrence(zone, start, rule);
+        const auto expected = reference(zone, start, rule, last_day);
+        const std::string where = "trial " + std::to_string(trial);
+
+        // everything up to the horizon, from the front
+        const date::sys_seconds first{date::local_seconds{start}.time_since_epoch() - std::chrono::hours{30}};
+        const auto within = slice(expected, first, horizon);
+        const auto head = recurrence.expand(within.size());
+        if (head != within) timelib::test::fail(__FILE__, __LINE__, where + ": expand differs");
+
+        // windows anywhere, and paging through consecutive ones
+        for (int i = 0; i < 10; ++i) {
+            const date::sys_seconds from = date::sys_seconds{date::local_seconds{start}.time_since_epoch()} + std::chrono::hours{pick(-48, 24 * 700)};
+            const date::sys_seconds to = std::min(horizon, from + std::chrono::hours{pick(1, 24 * 120)});
+            if (recurrence.between(from, to) != slice(expected, from, to)) {
+                timelib::test::fail(__FILE__, __LINE__, where + ": between " + std::to_string(from.time_since_epoch().count()) + " differs");
+            }
+        }
+        std::vector<date::sys_seconds> paged;
+        for (date::sys_seconds from = first; from < horizon; from += std::chrono::hours{24 * 17 + 5}) {
+            const auto page = recurrence.between(from, std::min(horizon, from + std::chrono::hours{24 * 17 + 5}));
+            paged.insert(paged.end(), page.begin(), page.end());
+        }
+        if (paged != slice(expected, first, horizon)) timelib::test::fail(__FILE__, __LINE__, where + ": paging differs");
+    }
+
+    // an iterator carries what it needs, the converter's temporary can go
+    timelib::RecurrenceRule weekdays;
+    weekdays.weekdays = 0b0111110;
+    weekdays.time = std::chrono::minutes{9 * 60 + 30};
+    const date::local_days start{date::year_month_day{date::year{2024}, date::month{3}, date::day{1}}};
+    auto it = timelib::TimeConverter::recurrence("new york", start, weekdays).begin();
+    std::vector<date::sys_seconds> iterated;
+    for (; it != timelib::Recurrence::iterator() && iterated.size() < 40; ++it) iterated.push_back(*it);
+    TIMELIB_CHECK(iterated == timelib::Recurrence(date::locate_zone("America/New_York"), start, weekdays).expand(40));
+
+    const auto unknown = timelib::TimeConverter::recurrence("qzxqzx", start, weekdays);
+    TIMELIB_CHECK(unknown.zone() == nullptr);
+    TIMELIB_CHECK(unknown.begin() == unknown.end());
+    TIMELIB_CHECK(unknown.between(date::sys_seconds{}, date::sys_seconds{std::chrono::hours{24 * 365 * 60}}).empty());
+
+    return timelib::test::result("recurrence");
+}
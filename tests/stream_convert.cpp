@@ -0,0 +1,360 @@
+#include "check.hpp"
+#include "stream_convert.hpp"
+#include "thread_pool.hpp"
+#include <atomic>
+#include <cstdio>
+#include <random>
+#include <sstream>
+#include <streambuf>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// StreamConverter against a plain byte-at-a-time reference: the eight-byte shape checks, the
+// cached zone intervals and the parallel split must not change a single output byte
+
+namespace {
+
+constexpr const char* kMonths[] = {"Jan", "Feb", "Mar", "Apr", "May", "Jun", "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"};
+
+bool digit(const char c) {
+    return c >= '0' && c <= '9';
+}
+
+bool digits(const std::string_view s, const std::size_t at, const std::size_t count) {
+    for (std::size_t i = at; i < at + count; ++i) {
+        if (!digit(s[i])) return false;
+    }
+    return true;
+}
+
+int number(const std::string_view s, const std::size_t at, const std::size_t count) {
+    int value = 0;
+    for (std::size_t i = at; i < at + count; ++i) value = value * 10 + (s[i] - '0');
+    return value;
+}
+
+struct Found {
+    bool clf = false;
+    std::size_t begin = 0;
+    std::size_t end = 0;
+    std::int64_t wall = 0;
+    bool has_offset = false;
+    int offset = 0;
+    char separator = 'T';
+    std::string fraction;
+};
+
+bool wallOf(const int y, const int mo, const int d, const int h, const int mi, const int s, std::int64_t& out) {
+    const date::year_month_day ymd{date::year{y}, date::month{static_cast<unsigned>(mo)}, date::day{static_cast<unsigned>(d)}};
+    if (!ymd.ok() || h > 23 || mi > 59 || s > 59) return false;
+    out = date::sys_days{ymd}.time_since_epoch().count() * std::int64_t{86400} + h * 3600 + mi * 60 + s;
+    return true;
+}
+
+bool iso(const std::string_view s, const std::size_t at, Found& found) {
+    if (s.size() - at < 19) return false;
+    if (!digits(s, at, 4) || s[at + 4] != '-' || !digits(s, at + 5, 2) || s[at + 7] != '-' || !digits(s, at + 8, 2)) return false;
+    const char separator = s[at + 10];
+    if (separator != 'T' && separator != 't' && separator != ' ') return false;
+    if (!digits(s, at + 11, 2) || s[at + 13] != ':' || !digits(s, at + 14, 2) || s[at + 16] != ':' || !digits(s, at + 17, 2)) return false;
+    if (!wallOf(number(s, at, 4), number(s, at + 5, 2), number(s, at + 8, 2), number(s, at + 11, 2), number(s, at + 14, 2),
+                number(s, at + 17, 2), found.wall)) {
+        return false;
+    }
+
+    found = Found{false, at, at + 19, found.wall, false, 0, separator, {}};
+    std::size_t end = at + 19;
+    if (end + 1 < s.size() && (s[end] == '.' || s[end] == ',') && digit(s[end + 1])) {
+        std::size_t last = end + 1;
+        while (last < s.size() && digit(s[last])) ++last;
+        found.fraction = std::string(s.substr(end, last - end));
+        end = last;
+    }
+    if (end < s.size() && (s[end] == 'Z' || s[end] == 'z')) {
+        found.has_offset = true;
+        ++end;
+    } else if (end + 3 <= s.size() && (s[end] == '+' || s[end] == '-') && digits(s, end + 1, 2)) {
+        const int hours = number(s, end + 1, 2);
+        int minutes = 0;
+        std::size_t last = end + 3;
+        if (last + 3 <= s.size() && s[last] == ':' && digits(s, last + 1, 2)) {
+            minutes = number(s, last + 1, 2);
+            last += 3;
+        } else if (last + 2 <= s.size() && digits(s, last, 2)) {
+            minutes = number(s, last, 2);
+            last += 2;
+        }
+        if (hours < 24 && minutes < 60) {
+            found.has_offset = true;
+            found.offset = (s[end] == '-' ? -1 : 1) * (hours * 3600 + minutes * 60);
+            end = last;
+        }
+    }
+    found.end = end;
+    return true;
+}
+
+bool clf(const std::string_view s, const std::size_t at, Found& found) {
+    if (s.size() - at < 26) return false;
+    if (!digits(s, at, 2) || s[at + 2] != '/' || s[at + 6] != '/' || !digits(s, at + 7, 4) || s[at + 11] != ':' ||
+        !digits(s, at + 12, 2) || s[at + 14] != ':' || !digits(s, at + 15, 2) || s[at + 17] != ':' || !digits(s, at + 18, 2) ||
+        s[at + 20] != ' ' || (s[at + 21] != '+' && s[at + 21] != '-') || !digits(s, at + 22, 4)) {
+        return false;
+    }
+    int month = 0;
+    while (month < 12 && s.substr(at + 3, 3) != kMonths[month]) ++month;
+    if (month == 12) return false;
+    const int hours = number(s, at + 22, 2);
+    const int minutes = number(s, at + 24, 2);
+    if (hours > 23 || minutes > 59) return false;
+    if (!wallOf(number(s, at + 7, 4), month + 1, number(s, at, 2), number(s, at + 12, 2), number(s, at + 15, 2),
+                number(s, at + 18, 2), found.wall)) {
+        return false;
+    }
+    found = Found{true, at, at + 26, found.wall, true, (s[at + 21] == '-' ? -1 : 1) * (hours * 3600 + minutes * 60), 'T', {}};
+    return true;
+}
+
+bool at(const std::string_view line, const std::size_t pos, Found& found) {
+    return pos + 19 <= line.size() && (iso(line, pos, found) || clf(line, pos, found));
+}
+
+std::string format(const Found& found, const std::int64_t wall, const int offset) {
+    const date::sys_days day{date::days{wall >= 0 ? wall / 86400 : (wall - 86399) / 86400}};
+    const date::year_month_day ymd{day};
+    const auto seconds = static_cast<int>(wall - day.time_since_epoch().count() * std::int64_t{86400});
+    const int year = static_cast<int>(ymd.year());
+    const auto month = static_cast<unsigned>(ymd.month());
+    const auto dom = static_cast<unsigned>(ymd.day());
+    const char sign = offset < 0 ? '-' : '+';
+    const int magnitude = offset < 0 ? -offset : offset;
+
+    char buffer[64];
+    if (found.clf) {
+        std::snprintf(buffer, sizeof(buffer), "%02u/%s/%04d:%02d:%02d:%02d %c%02d%02d", dom, kMonths[month - 1], year, seconds / 3600,
+                      seconds / 60 % 60, seconds % 60, sign, magnitude / 3600, magnitude / 60 % 60);
+        return buffer;
+    }
+    std::snprintf(buffer, sizeof(buffer), "%04d-%02u-%02u%c%02d:%02d:%02d", year, month, dom, found.separator, seconds / 3600,
+                  seconds / 60 % 60, seconds % 60);
+    std::string text = buffer + found.fraction;
+    if (!found.has_offset) return text;
+    std::snprintf(buffer, sizeof(buffer), "%c%02d:%02d", sign, magnitude / 3600, magnitude / 60 % 60);
+    text += buffer;
+    if (magnitude % 60 != 0) {
+        std::snprintf(buffer, sizeof(buffer), ":%02d", magnitude % 60);
+        text += buffer;
+    }
+    return text;
+}
+
+std::string referenceLine(const std::string_view line, const timelib::StreamConvertOptions& options) {
+    Found found;
+    bool located = false;
+    if (options.delimiter == '\0') {
+        for (std::size_t pos = 0; pos + 19 <= line.size() && !located; ++pos) located = at(line, pos, found);
+    } else {
+        std::size_t start = 0;
+        bool ok = true;
+        for (std::size_t field = 0; field < options.field && ok; ++field) {
+            const std::size_t delimiter = line.find(options.delimiter, start);
+            ok = delimiter != std::string_view::npos;
+            start = delimiter + 1;
+        }
+        if (ok && start < line.size() && (line[start] == '"' || line[start] == '[')) ++start;
+        located = ok && start < line.size() && at(line, start, found);
+    }
+    if (!located || (!found.has_offset && !options.source)) return std::string(line);
+
+    const std::int64_t utc = found.has_offset
+        ? found.wall - found.offset
+        : options.source->to_sys(date::local_seconds{std::chrono::seconds{found.wall}}, date::choose::earliest).time_since_epoch().count();
+    const auto offset = static_cast<int>(options.target->get_info(date::sys_seconds{std::chrono::seconds{utc}}).offset.count());
+    const std::int64_t wall = utc + offset;
+    if (wall < -62167219200 || wall >= 253402300800) return std::string(line);
+
+    return std::string(line.substr(0, found.begin)) + format(found, wall, offset) + std::string(line.substr(found.end));
+}
+
+std::string reference(const std::string_view text, const timelib::StreamConvertOptions& options) {
+    std::string out;
+    for (std::size_t start = 0; start < text.size();) {
+        std::size_t end = text.find('\n', start);
+        const bool newline = end != std::string_view::npos;
+        if (!newline) end = text.size();
+        out += referenceLine(text.substr(start, end - start), options);
+        if (newline) out += '\n';
+        start = end + 1;
+    }
+    return out;
+}
+
+// stamps that are right, nearly right and wrong in every field, with noise around them. `any_year`
+// also writes years far outside the ones with zone rules, for the edges of what fits in four digits
+class Lines {
+public:
+    Lines(const std::uint32_t seed, const bool any_year) : rng_(seed), any_year_(any_year) {}
+
+    std::string line(const bool csv) {
+        std::string text;
+        if (csv) {
+            text = std::to_string(pick(0, 99999)) + "," + word() + ",";
+            const int open = pick(0, 3);
+            if (open == 1) text += '"';
+            if (open == 2) text += '[';
+            text += stamp() + (open == 1 ? "\"" : open == 2 ? "]" : "") + "," + word();
+        } else {
+            for (int parts = pick(1, 4); parts > 0; --parts) text += (pick(0, 2) ? stamp() : word()) + (pick(0, 1) ? " " : "");
+        }
+        // a byte or two knocked out of shape. digits only with any year, a changed one could move
+        // a stamp out of the years that have zone rules
+        const std::string_view bytes = any_year_ ? "0129:/-+T Zx." : ":/-+T Zx.";
+        for (int damage = pick(0, 3) == 0 ? pick(1, 2) : 0; damage > 0 && !text.empty(); --damage) {
+            text[static_cast<std::size_t>(pick(0, static_cast<int>(text.size()) - 1))] = bytes[static_cast<std::size_t>(pick(0, static_cast<int>(bytes.size()) - 1))];
+        }
+        return text;
+    }
+
+private:
+    std::mt19937 rng_;
+    bool any_year_;
+
+    int pick(const int low, const int high) { return std::uniform_int_distribution<int>(low, high)(rng_); }
+
+    std::string two(const int low, const int high) {
+        char buffer[8];
+        std::snprintf(buffer, sizeof(buffer), "%02d", pick(low, high));
+        return buffer;
+    }
+
+    std::string year() {
+        char buffer[8];
+        const int kind = any_year_ ? pick(0, 3) : 2;
+        std::snprintf(buffer, sizeof(buffer), "%04d", kind == 0 ? pick(0, 9999) : kind == 1 ? pick(0, 1) * 9999 : pick(1901, 2099));
+        return buffer;
+    }
+
+    std::string word() {
+        static const char* kWords[] = {"GET", "/index.html", "200", "1234", "user=7", "12/34", "2024-", "10:00", "x", "-0700", "a,b"};
+        return kWords[pick(0, 10)];
+    }
+
+    std::string offset() {
+        switch (pick(0, 8)) {
+            case 0: return "Z";
+            case 1: return "z";
+            case 2: return (pick(0, 1) ? "+" : "-") + two(0, 14) + ":" + two(0, 59);
+            case 3: return (pick(0, 1) ? "+" : "-") + two(0, 14) + two(0, 59);
+            case 4: return (pick(0, 1) ? "+" : "-") + two(0, 14);
+            case 5: return "+" + two(20, 30) + ":" + two(50, 70);
+            default: return "";
+        }
+    }
+
+    std::string stamp() {
+        if (pick(0, 3) == 0) {
+            return two(0, 32) + "/" + (pick(0, 9) ? kMonths[pick(0, 11)] : "Foo") + "/" + year() + ":" + two(0, 24) + ":" + two(0, 60) + ":" +
+                   two(0, 60) + " " + (pick(0, 1) ? "+" : "-") + two(0, 14) + two(0, 61);
+        }
+        std::string text = year() + "-" + two(0, 13) + "-" + two(0, 32) + "Tt x"[pick(0, 3)] + two(0, 24) + ":" + two(0, 60) + ":" + two(0, 60);
+        if (pick(0, 3) == 0) text += (pick(0, 1) ? "." : ",") + std::to_string(pick(0, 999999));
+        return text + offset();
+    }
+};
+
+class FailingBuffer : public std::streambuf {
+public:
+    explicit FailingBuffer(std::string text) : text_(std::move(text)) { setg(text_.data(), text_.data(), text_.data() + text_.size()); }
+
+protected:
+    int_type underflow() override { throw std::runtime_error("read error"); }
+
+private:
+    std::string text_;
+};
+
+void compare(const timelib::StreamConvertOptions& options, const bool csv, const std::uint32_t seed, const bool any_year = false) {
+    Lines lines(seed, any_year);
+    std::string text;
+    for (int i = 0; i < 8000; ++i) text += lines.line(csv) + (i % 7 == 3 ? "\r\n" : "\n");
+    text += lines.line(csv);
+
+    const std::string expected = reference(text, options);
+    const timelib::StreamConverter converter(options);
+
+    std::string single;
+    converter.convert(text, single);
+    TIMELIB_CHECK(single == expected);
+    if (single != expected) {
+        // the first line that differs is enough to go on
+        std::istringstream input(text), want(expected), got(single);
+        for (std::string line, wanted, actual; std::getline(input, line) && std::getline(want, wanted) && std::getline(got, actual);) {
+            if (wanted == actual) continue;
+            std::cerr << "      in: " << line << "\nexpected: " << wanted << "\n     got: " << actual << "\n";
+            break;
+        }
+    }
+
+    // small blocks, so the work is split a few hundred ways and the sink sees them in order
+    timelib::StreamConvertOptions split_options = options;
+    split_options.block_size = 4096;
+    const timelib::StreamConverter split(split_options);
+    timelib::ThreadPool pool(3);
+
+    std::string parallel;
+    std::atomic<int> inside{0};
+    bool overlapped = false;
+    const auto sink = [&](const std::string_view block) {
+        if (inside.fetch_add(1) != 0) overlapped = true;
+        parallel.append(block);
+        inside.fetch_sub(1);
+    };
+    const auto stats = split.convert(text, sink, pool);
+    TIMELIB_CHECK(!overlapped);
+    TIMELIB_CHECK(parallel == expected);
+    TIMELIB_CHECK_EQ(stats.bytes_in, text.size());
+    TIMELIB_CHECK_EQ(stats.bytes_out, expected.size());
+
+    std::string streamed;
+    std::istringstream in(text);
+    const auto streamed_stats = split.convert(in, [&streamed](const std::string_view block) { streamed.append(block); }, pool);
+    TIMELIB_CHECK(streamed_stats.has_value());
+    TIMELIB_CHECK(streamed == expected);
+}
+
+}
+
+int main() {
+    timelib::StreamConvertOptions options;
+    options.source = date::locate_zone("America/New_York");
+    options.target = date::locate_zone("Asia/Kolkata");
+    compare(options, false, 1);
+
+    options.target = date::locate_zone("Europe/London");
+    compare(options, false, 2);
+
+    // without a source zone only stamps with an offset are converted
+    options.source = nullptr;
+    compare(options, false, 3);
+
+    options.source = date::locate_zone("Australia/Sydney");
+    options.delimiter = ',';
+    options.field = 2;
+    compare(options, true, 4);
+
+    // from year 0 to 9999, and what would end up outside them is left alone
+    options.source = date::locate_zone("Etc/UTC");
+    options.target = date::locate_zone("Etc/GMT-14");
+    options.delimiter = '\0';
+    compare(options, false, 5, true);
+
+    // a stream that fails part way is an error, not a short input
+    FailingBuffer buffer(std::string(100000, 'x') + "\n");
+    std::istream failing(&buffer);
+    timelib::ThreadPool pool(1);
+    const timelib::StreamConverter converter(options);
+    TIMELIB_CHECK(!converter.convert(failing, [](std::string_view) {}, pool).has_value());
+
+    return timelib::test::result("stream_convert");
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstdlib>
+#include <string>
+#include <unistd.h>
+
+// protocol shared by timelibd and timelib_query. requests are one query per line, responses come
+// back one line per request in the same order, so any number of requests can be written before
+// reading the answers:
+//
+//   request:  <query text>\n
+//   response: <error code>\t<result or error message>\n
+//
+// lines starting with '!' are commands instead of queries: "!ping" answers "0\tpong" and
+// "!reload" re-reads the tz database. a last line without a newline is answered when the client
+// shuts down its side of the connection.
+namespace timelib::daemon {
+
+    // requests longer than this get an error and the connection is closed
+    inline constexpr std::size_t kMaxLineLength = 4096;
+    // a client that writes requests without reading the answers isn't read from while this much
+    // is waiting for it, so its writes block instead of the daemon buffering without limit
+    inline constexpr std::size_t kMaxPendingOutput = 1 << 20;
+
+    inline std::string defaultSocketPath() {
+        if (const char* runtime = std::getenv("XDG_RUNTIME_DIR"); runtime && *runtime) return std::string(runtime) + "/timelibd.sock";
+        return "/tmp/timelibd-" + std::to_string(getuid()) + ".sock";
+    }
+
+}
@@ -0,0 +1,26 @@
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include "gazetteer.hpp"
+
+// compiles a GeoNames city dump (cities15000.txt and friends) into a gazetteer
+// TimeConverter::loadGazetteer can map.
+// usage: timelib_gazcompile <cities.tsv> <output> [min_population]
+int main(int argc, char** argv) {
+    if (argc < 3 || argc > 4) {
+        std::cerr << "usage: " << argv[0] << " <cities.tsv> <output> [min_population]" << std::endl;
+        return 2;
+    }
+
+    timelib::GazetteerOptions options;
+    if (argc > 3) options.min_population = static_cast<std::uint32_t>(std::strtoul(argv[3], nullptr, 10));
+
+    const std::size_t places = timelib::Gazetteer::write(argv[1], argv[2], options);
+    if (places == 0) {
+        std::cerr << "could not compile " << argv[1] << " into " << argv[2] << std::endl;
+        return 1;
+    }
+
+    std::cout << "wrote " << places << " places (population " << options.min_population << " and up) to " << argv[2] << std::endl;
+    return 0;
+}
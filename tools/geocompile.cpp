@@ -0,0 +1,31 @@
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include "geo_index.hpp"
+
+// compiles timezone boundary polygons (geojson, e.g. timezone-boundary-builder's release) into
+// an index TimeConverter::loadGeoIndex can map.
+// usage: timelib_geocompile <boundaries.geojson> <output> [cells_per_degree] [tolerance]
+int main(int argc, char** argv) {
+    if (argc < 3 || argc > 5) {
+        std::cerr << "usage: " << argv[0] << " <boundaries.geojson> <output> [cells_per_degree] [tolerance]" << std::endl;
+        return 2;
+    }
+
+    timelib::GeoIndexOptions options;
+    if (argc > 3) options.cells_per_degree = static_cast<std::uint32_t>(std::atoi(argv[3]));
+    if (argc > 4) options.tolerance = std::atof(argv[4]);
+    if (options.cells_per_degree == 0 || options.cells_per_degree > 40 || 1000000 % options.cells_per_degree != 0) {
+        std::cerr << "cells_per_degree has to divide 1000000 and be at most 40" << std::endl;
+        return 2;
+    }
+
+    const std::size_t zones = timelib::GeoIndex::write(argv[1], argv[2], options);
+    if (zones == 0) {
+        std::cerr << "could not compile " << argv[1] << " into " << argv[2] << std::endl;
+        return 1;
+    }
+
+    std::cout << "wrote " << zones << " zones (" << options.cells_per_degree << " cells per degree) to " << argv[2] << std::endl;
+    return 0;
+}
@@ -0,0 +1,97 @@
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include "resolver.hpp"
+#include "stream_convert.hpp"
+#include "thread_pool.hpp"
+
+// rewrites the timestamps in a log or csv file to another zone, see StreamConverter for the
+// formats. timestamps without an offset are read as --from wall time. the result goes to stdout.
+// usage: timelib_convert --to <location> [--from <location>] [-d delimiter -f field] [-j threads] [-v] [file]
+namespace {
+
+int usage(const char* name) {
+    std::cerr << "usage: " << name << " --to <location> [--from <location>] [-d delimiter -f field] [-j threads] [-v] [file]"
+              << std::endl;
+    return 2;
+}
+
+}
+
+int main(int argc, char** argv) {
+    std::string to;
+    std::string from;
+    std::string path;
+    timelib::StreamConvertOptions options;
+    std::size_t threads = 0;
+    bool verbose = false;
+
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const bool has_value = i + 1 < argc;
+        if (arg == "--to" && has_value) {
+            to = argv[++i];
+        } else if (arg == "--from" && has_value) {
+            from = argv[++i];
+        } else if (arg == "-d" && has_value) {
+            const std::string delimiter = argv[++i];
+            options.delimiter = delimiter == "\\t" ? '\t' : delimiter.empty() ? '\0' : delimiter[0];
+        } else if (arg == "-f" && has_value) {
+            options.field = static_cast<std::size_t>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "-j" && has_value) {
+            threads = static_cast<std::size_t>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "-v") {
+            verbose = true;
+        } else if (arg.size() > 1 && arg[0] == '-') {
+            return usage(argv[0]);
+        } else if (path.empty()) {
+            path = arg;
+        } else {
+            return usage(argv[0]);
+        }
+    }
+    if (to.empty()) return usage(argv[0]);
+
+    const timelib::ZoneResolver resolver;
+    options.target = resolver.resolve(to);
+    if (!options.target) {
+        std::cerr << "unknown location: " << to << std::endl;
+        return 1;
+    }
+    if (!from.empty()) {
+        options.source = resolver.resolve(from);
+        if (!options.source) {
+            std::cerr << "unknown location: " << from << std::endl;
+            return 1;
+        }
+    }
+
+    // the converted blocks are big, stdio's own buffering would only add a copy
+    std::setvbuf(stdout, nullptr, _IONBF, 0);
+    bool write_failed = false;
+    const auto sink = [&write_failed](const std::string_view text) {
+        if (!write_failed && std::fwrite(text.data(), 1, text.size(), stdout) != text.size()) write_failed = true;
+    };
+
+    const timelib::StreamConverter converter(options);
+    timelib::ThreadPool pool(threads);
+    const bool from_stdin = path.empty() || path == "-";
+    if (from_stdin) std::ios::sync_with_stdio(false);
+    const auto converted = from_stdin ? converter.convert(std::cin, sink, pool) : converter.convertFile(path, sink, pool);
+    if (!converted) {
+        std::cerr << "could not read " << (from_stdin ? std::string("the input") : path) << std::endl;
+        return 1;
+    }
+    const timelib::StreamConvertStats& stats = *converted;
+
+    if (write_failed) {
+        std::cerr << "could not write the output" << std::endl;
+        return 1;
+    }
+    if (verbose) {
+        std::cerr << "converted " << stats.converted << " of " << stats.lines << " lines (" << stats.bytes_in << " bytes in, "
+                  << stats.bytes_out << " bytes out)" << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,105 @@
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "daemon.hpp"
+
+// asks a running timelibd. every argument is one query, without any the queries are read from
+// stdin, one per line. answers are printed as they arrive, in request order.
+// usage: timelib_query [-s socket_path] [query...]
+int main(int argc, char** argv) {
+    std::string path = timelib::daemon::defaultSocketPath();
+    std::vector<std::string> queries;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "-s" && i + 1 < argc) {
+            path = argv[++i];
+        } else if (arg == "-h" || arg == "--help") {
+            std::cerr << "usage: " << argv[0] << " [-s socket_path] [query...]" << std::endl;
+            return 2;
+        } else {
+            queries.push_back(arg);
+        }
+    }
+    if (queries.empty()) {
+        for (std::string line; std::getline(std::cin, line);) queries.push_back(line);
+    }
+
+    sockaddr_un address{};
+    if (path.size() >= sizeof(address.sun_path)) {
+        std::cerr << "socket path too long: " << path << std::endl;
+        return 2;
+    }
+    address.sun_family = AF_UNIX;
+    std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+
+    const int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0 || connect(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) < 0) {
+        std::cerr << "could not connect to " << path << ": " << std::strerror(errno) << std::endl;
+        return 1;
+    }
+
+    std::string request;
+    for (const auto& query : queries) {
+        // a newline inside a query would be taken as two requests
+        for (const char c : query) request += c == '\n' ? ' ' : c;
+        request += '\n';
+    }
+    // answers are read while requests are still going out: the daemon stops reading a client
+    // whose answers pile up, so writing everything first would wait on it forever
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+
+    int status = 0;
+    std::size_t sent = 0;
+    std::size_t answered = 0;
+    std::string buffer;
+    char chunk[16384];
+    while (answered < queries.size()) {
+        pollfd ready{fd, static_cast<short>(POLLIN | (sent < request.size() ? POLLOUT : 0)), 0};
+        if (poll(&ready, 1, -1) < 0) {
+            if (errno == EINTR) continue;
+            std::cerr << "poll: " << std::strerror(errno) << std::endl;
+            return 1;
+        }
+
+        if (sent < request.size() && (ready.revents & POLLOUT)) {
+            const ssize_t n = send(fd, request.data() + sent, request.size() - sent, MSG_NOSIGNAL);
+            if (n < 0 && errno != EINTR && errno != EAGAIN && errno != EWOULDBLOCK) {
+                std::cerr << "send: " << std::strerror(errno) << std::endl;
+                return 1;
+            }
+            if (n > 0) sent += static_cast<std::size_t>(n);
+            if (sent == request.size()) shutdown(fd, SHUT_WR);
+        }
+
+        if (!(ready.revents & (POLLIN | POLLHUP | POLLERR))) continue;
+        const ssize_t n = read(fd, chunk, sizeof(chunk));
+        if (n < 0 && (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK)) continue;
+        if (n <= 0) break;
+        buffer.append(chunk, static_cast<std::size_t>(n));
+
+        std::size_t start = 0;
+        for (std::size_t end; (end = buffer.find('\n', start)) != std::string::npos; start = end + 1) {
+            const std::string line = buffer.substr(start, end - start);
+            const std::size_t tab = line.find('\t');
+            const bool ok = line.compare(0, tab, "0") == 0;
+            (ok ? std::cout : std::cerr) << line.substr(tab == std::string::npos ? 0 : tab + 1) << '\n';
+            if (!ok) status = 1;
+            ++answered;
+        }
+        buffer.erase(0, start);
+    }
+    close(fd);
+
+    if (answered < queries.size()) {
+        std::cerr << "timelibd closed the connection early" << std::endl;
+        return 1;
+    }
+    return status;
+}
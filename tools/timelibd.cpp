@@ -0,0 +1,293 @@
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "daemon.hpp"
+#include "time.hpp"
+
+// keeps a converter with warm lookup tables around and answers queries over a unix socket, see
+// daemon.hpp for the protocol.
+// usage: timelibd [socket_path]
+
+namespace {
+
+// most a connection is read from per wakeup, so one client writing flat out can't starve the rest
+constexpr std::size_t kReadBudget = 64 * 1024;
+
+volatile std::sig_atomic_t stopping = 0;
+
+void onSignal(int) { stopping = 1; }
+
+struct Connection {
+    int fd = -1;
+    std::string in;
+    std::string out;
+    // bytes of `out` already written
+    std::size_t sent = 0;
+    // the peer shut down its side (or the read failed), what's buffered is all there will be
+    bool eof = false;
+    bool closing = false;
+
+    std::size_t pending() const { return out.size() - sent; }
+    // the client isn't reading its answers, so its requests are left unread too
+    bool backedUp() const { return pending() >= timelib::daemon::kMaxPendingOutput; }
+};
+
+bool setNonBlocking(const int fd) {
+    const int flags = fcntl(fd, F_GETFL, 0);
+    return flags >= 0 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+void appendResponse(std::string& out, const int code, const std::string_view text) {
+    out += std::to_string(code);
+    out += '\t';
+    out += text;
+    out += '\n';
+}
+
+void answer(std::string_view line, std::string& out) {
+    if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+
+    if (line == "!ping") {
+        appendResponse(out, 0, "pong");
+    } else if (line == "!reload") {
+        const bool reloaded = timelib::TimeConverter::reload();
+        appendResponse(out, reloaded ? 0 : static_cast<int>(timelib::ErrorCode::ProcessingError),
+                       reloaded ? "reloaded" : "could not reload the tz database");
+    } else {
+        const auto response = timelib::TimeConverter::processInput(line);
+        const auto& result = response->result;
+        appendResponse(out, static_cast<int>(result.code), result.ok() ? result.result : result.error_message);
+    }
+}
+
+// answers the complete lines in the input buffer until the answers back up, and after eof the
+// last line even without its newline. false when a line is too long
+bool process(Connection& connection) {
+    const auto too_long = [&connection] {
+        appendResponse(connection.out, static_cast<int>(timelib::ErrorCode::InvalidQuery), "request line too long");
+        connection.in.clear();
+        return false;
+    };
+
+    std::size_t start = 0;
+    std::size_t end = 0;
+    while (!connection.backedUp() && (end = connection.in.find('\n', start)) != std::string::npos) {
+        if (end - start > timelib::daemon::kMaxLineLength) return too_long();
+        answer(std::string_view(connection.in).substr(start, end - start), connection.out);
+        start = end + 1;
+    }
+    connection.in.erase(0, start);
+    if (connection.backedUp()) return true;
+
+    if (connection.in.size() > timelib::daemon::kMaxLineLength) return too_long();
+    if (connection.eof && !connection.in.empty()) {
+        answer(connection.in, connection.out);
+        connection.in.clear();
+    }
+    return true;
+}
+
+// false when the peer went away
+bool flush(Connection& connection) {
+    while (connection.sent < connection.out.size()) {
+        const ssize_t n = send(connection.fd, connection.out.data() + connection.sent, connection.out.size() - connection.sent,
+                               MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return errno == EAGAIN || errno == EWOULDBLOCK;
+        }
+        connection.sent += static_cast<std::size_t>(n);
+    }
+    connection.out.clear();
+    connection.sent = 0;
+    return true;
+}
+
+// reads what's there, up to kReadBudget. false when the peer closed its side or the read failed.
+// epoll is level triggered, so whatever is left over wakes the loop again on the next round
+bool receive(Connection& connection) {
+    char buffer[16384];
+    for (std::size_t total = 0; total < kReadBudget;) {
+        const ssize_t n = read(connection.fd, buffer, sizeof(buffer));
+        if (n > 0) {
+            connection.in.append(buffer, static_cast<std::size_t>(n));
+            total += static_cast<std::size_t>(n);
+            continue;
+        }
+        if (n == 0) return false;
+        if (errno == EINTR) continue;
+        return errno == EAGAIN || errno == EWOULDBLOCK;
+    }
+    return true;
+}
+
+int listenOn(const std::string& path) {
+    sockaddr_un address{};
+    if (path.size() >= sizeof(address.sun_path)) {
+        std::cerr << "socket path too long: " << path << std::endl;
+        return -1;
+    }
+    address.sun_family = AF_UNIX;
+    std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+
+    const int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        std::cerr << "socket: " << std::strerror(errno) << std::endl;
+        return -1;
+    }
+
+    // a socket file is either a daemon that is still running, which keeps it, or one left behind
+    // by a daemon that didn't shut down cleanly, which nothing answers on
+    if (struct stat existing{}; lstat(path.c_str(), &existing) == 0) {
+        if (!S_ISSOCK(existing.st_mode)) {
+            std::cerr << path << " exists and is not a socket" << std::endl;
+            close(fd);
+            return -1;
+        }
+        const int probe = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        const bool answered = probe >= 0 && connect(probe, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) == 0;
+        if (probe >= 0) close(probe);
+        if (answered) {
+            std::cerr << "another timelibd is already listening on " << path << std::endl;
+            close(fd);
+            return -1;
+        }
+        unlink(path.c_str());
+    }
+
+    if (bind(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) < 0 || listen(fd, 64) < 0 || !setNonBlocking(fd)) {
+        std::cerr << "could not listen on " << path << ": " << std::strerror(errno) << std::endl;
+        close(fd);
+        return -1;
+    }
+    chmod(path.c_str(), S_IRUSR | S_IWUSR);
+    return fd;
+}
+
+}
+
+int main(int argc, char** argv) {
+    if (argc > 2) {
+        std::cerr << "usage: " << argv[0] << " [socket_path]" << std::endl;
+        return 2;
+    }
+    const std::string path = argc > 1 ? argv[1] : timelib::daemon::defaultSocketPath();
+
+    struct sigaction action{};
+    action.sa_handler = onSignal;
+    sigaction(SIGINT, &action, nullptr);
+    sigaction(SIGTERM, &action, nullptr);
+    std::signal(SIGPIPE, SIG_IGN);
+
+    // pay for loading the tzdb and building the lookup tables now rather than on the first request
+    timelib::TimeConverter::setResultCacheCapacity(4096);
+    timelib::TimeConverter::processInput("time in utc");
+
+    const int listener = listenOn(path);
+    if (listener < 0) return 1;
+
+    const int epoll = epoll_create1(EPOLL_CLOEXEC);
+    epoll_event listen_event{};
+    listen_event.events = EPOLLIN;
+    listen_event.data.fd = listener;
+    if (epoll < 0 || epoll_ctl(epoll, EPOLL_CTL_ADD, listener, &listen_event) < 0) {
+        std::cerr << "epoll: " << std::strerror(errno) << std::endl;
+        return 1;
+    }
+
+    std::unordered_map<int, std::unique_ptr<Connection>> connections;
+    const auto drop = [&](const int fd) {
+        epoll_ctl(epoll, EPOLL_CTL_DEL, fd, nullptr);
+        close(fd);
+        connections.erase(fd);
+    };
+    // only ask for writability while there's something left to write, and stop reading from a
+    // connection that is only being drained before it's closed, or whose answers pile up
+    const auto watch = [&](const Connection& connection) {
+        const bool reading = !connection.closing && !connection.eof && !connection.backedUp();
+        epoll_event event{};
+        event.events = (reading ? EPOLLIN | EPOLLRDHUP : 0u) | (connection.out.empty() ? 0u : static_cast<unsigned>(EPOLLOUT));
+        event.data.fd = connection.fd;
+        epoll_ctl(epoll, EPOLL_CTL_MOD, connection.fd, &event);
+    };
+
+    std::cout << "timelibd listening on " << path << std::endl;
+
+    epoll_event events[64];
+    while (!stopping) {
+        const int ready = epoll_wait(epoll, events, 64, -1);
+        if (ready < 0) {
+            if (errno == EINTR) continue;
+            std::cerr << "epoll_wait: " << std::strerror(errno) << std::endl;
+            break;
+        }
+
+        for (int i = 0; i < ready; ++i) {
+            const int fd = events[i].data.fd;
+
+            if (fd == listener) {
+                while (true) {
+                    const int client = accept4(listener, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+                    if (client < 0) break;
+
+                    auto connection = std::make_unique<Connection>();
+                    connection->fd = client;
+                    epoll_event event{};
+                    event.events = EPOLLIN | EPOLLRDHUP;
+                    event.data.fd = client;
+                    if (epoll_ctl(epoll, EPOLL_CTL_ADD, client, &event) < 0) {
+                        close(client);
+                        continue;
+                    }
+                    connections.emplace(client, std::move(connection));
+                }
+                continue;
+            }
+
+            const auto it = connections.find(fd);
+            if (it == connections.end()) continue;
+            Connection& connection = *it->second;
+
+            if (!connection.closing && !connection.eof && !connection.backedUp() &&
+                (events[i].events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR))) {
+                // a peer that shut down its write side still gets answers to what it sent
+                if (!receive(connection)) connection.eof = true;
+            }
+            // also after a write made room, for requests that were held back while backed up. when
+            // the answers went out straight away there's no write event coming to pick those up
+            bool alive = true;
+            do {
+                if (!connection.closing && !process(connection)) connection.closing = true;
+                alive = flush(connection);
+            } while (alive && !connection.closing && connection.out.empty() &&
+                     (connection.in.find('\n') != std::string::npos || (connection.eof && !connection.in.empty())));
+            if (!alive) {
+                drop(fd);
+                continue;
+            }
+            // done once everything sent was answered, or after an error once that's written
+            if ((connection.closing || (connection.eof && connection.in.empty())) && connection.out.empty()) {
+                drop(fd);
+                continue;
+            }
+            watch(connection);
+        }
+    }
+
+    for (const auto& [fd, connection] : connections) close(fd);
+    close(listener);
+    close(epoll);
+    unlink(path.c_str());
+    return 0;
+}
@@ -0,0 +1,30 @@
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include "zone_image.hpp"
+
+// compiles the tzdb timelib was built against into an image ZoneTables::loadImage can map.
+// usage: timelib_tzcompile <output> [first_year] [last_year]
+int main(int argc, char** argv) {
+    if (argc < 2 || argc > 4) {
+        std::cerr << "usage: " << argv[0] << " <output> [first_year] [last_year]" << std::endl;
+        return 2;
+    }
+
+    const int first = argc > 2 ? std::atoi(argv[2]) : 1970;
+    const int last = argc > 3 ? std::atoi(argv[3]) : 2100;
+    if (first >= last) {
+        std::cerr << "first_year has to be before last_year" << std::endl;
+        return 2;
+    }
+
+    const std::size_t zones = timelib::ZoneImage::write(argv[1], date::year{first}, date::year{last});
+    if (zones == 0) {
+        std::cerr << "could not write " << argv[1] << std::endl;
+        return 1;
+    }
+
+    std::cout << "wrote " << zones << " zones (" << first << "-" << last << ", tzdata " << date::get_tzdb().version << ") to "
+              << argv[1] << std::endl;
+    return 0;
+}